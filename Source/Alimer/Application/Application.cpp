@@ -23,19 +23,57 @@
 #include "AlimerVersion.h"
 #include "../Application/Application.h"
 #include "../Scene/Systems/CameraSystem.h"
+#include "../Scene/Components/CameraComponent.h"
 #include "../IO/Path.h"
 #include "../Core/Platform.h"
 #include "../Core/Log.h"
+#include <chrono>
+#include <cmath>
+#include <csignal>
+
+#if ALIMER_PLATFORM_WINDOWS
+#   include <mmsystem.h>
+#endif
 
 namespace Alimer
 {
     static Application* __appInstance = nullptr;
+    static volatile std::sig_atomic_t __exitRequested = 0;
+
+    static void HandleExitSignal(int)
+    {
+        __exitRequested = 1;
+    }
+
+    template <class Clock>
+    static void SleepUntil(typename Clock::time_point deadline)
+    {
+#if ALIMER_PLATFORM_WINDOWS
+        // Windows sleeps in scheduler quanta, wake up early and yield the remaining time.
+        const auto margin = std::chrono::milliseconds(2);
+        if (deadline - Clock::now() > margin)
+        {
+            std::this_thread::sleep_until(deadline - margin);
+        }
+
+        while (Clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+#else
+        // Monotonic nanosleep is precise to tens of microseconds.
+        std::this_thread::sleep_until(deadline);
+#endif
+    }
 
     Application::Application()
         : _running(false)
         , _paused(false)
         , _headless(false)
         , _settings{}
+        , _simulationTick(0)
+        , _nextSimulationTick(0)
+        , _simulationRunning(false)
         , _entities{}
         , _systems(_entities)
         , _scene(_entities)
@@ -50,6 +88,12 @@ namespace Alimer
     {
         _paused = true;
         _running = false;
+        StopSimulationThread();
+        _framePipeline.Stop();
+        _workQueue.Shutdown();
+
+        // Cached resources may hold GPU objects.
+        _resources.ReleaseAllResources(true);
 
         SafeDelete(_mainWindow);
         SafeDelete(_graphicsDevice);
@@ -66,16 +110,71 @@ namespace Alimer
 
     bool Application::InitializeBeforeRun()
     {
+        _startupTimeline.Reset();
         SetCurrentThreadName("Main");
         _log->Open("Alimer.log");
 
         ALIMER_LOGINFOF("Initializing engine %s...", ALIMER_VERSION_STR);
 
-        // Init Window and Gpu.
+        if (_settings.headless)
+        {
+            _headless = true;
+        }
+
+        _resources.SetAutoReloadResources(_settings.autoReloadResources);
+
+        if (!_settings.derivedDataCacheDirectory.IsEmpty())
+            DerivedDataCache::Get().SetDirectory(_settings.derivedDataCacheDirectory, _settings.derivedDataCacheSize);
+
+        {
+            TimelineScope scope(_startupTimeline, "WorkQueue");
+            _workQueue.CreateThreads(_settings.workerThreads);
+        }
+
+        // Subsystems not depending on window and graphics initialize on worker threads meanwhile.
+        std::vector<std::future<void>> tasks;
+        tasks.push_back(_workQueue.Async([this]() {
+            TimelineScope scope(_startupTimeline, "FileSystem");
+            FileSystem::Get();
+        }, WorkPriority::High));
+
+        if (!_headless
+            || _settings.headlessPlugins)
+        {
+            tasks.push_back(_workQueue.Async([this]() {
+                TimelineScope scope(_startupTimeline, "Plugins");
+                LoadPlugins();
+            }, WorkPriority::High));
+        }
+
+        // Create per platform Audio module.
+        if (!_headless)
+        {
+            tasks.push_back(_workQueue.Async([this]() {
+                TimelineScope scope(_startupTimeline, "Audio");
+                _audio = Audio::Create();
+                if (_audio)
+                {
+                    _audio->Initialize();
+                }
+            }, WorkPriority::High));
+        }
+
+        auto waitTasks = [&tasks]() {
+            for (std::future<void>& task : tasks)
+            {
+                task.wait();
+            }
+        };
+
+        // Init Window and Gpu, on main thread as some backends require it.
         if (!_headless)
         {
             uvec2 windowSize = uvec2(800, 600);
-            _mainWindow = new Window("Alimer", windowSize);
+            {
+                TimelineScope scope(_startupTimeline, "Window");
+                _mainWindow = new Window("Alimer", windowSize);
+            }
 
             // Assign as window handle.
             SwapchainDescriptor swapchainDesc = {};
@@ -87,35 +186,73 @@ namespace Alimer
             _settings.renderingSettings.swapchain = swapchainDesc;
 
             // Create and init graphics.
+            TimelineScope scope(_startupTimeline, "Graphics");
             _graphicsDevice = GraphicsDevice::Create(_settings.prefferedGraphicsBackend, _settings.validation);
             if (!_graphicsDevice->Initialize(_settings.renderingSettings))
             {
                 ALIMER_LOGERROR("Failed to initialize Graphics.");
+                waitTasks();
                 return false;
             }
         }
 
-        // Load plugins
-        LoadPlugins();
+        {
+            TimelineScope scope(_startupTimeline, "Wait workers");
+            waitTasks();
+        }
 
-        // Create per platform Audio module.
-        auto audio = Audio::Create();
-        audio->Initialize();
+        if (!_settings.lazyPlugins
+            && (!_headless || _settings.headlessPlugins))
+        {
+            TimelineScope scope(_startupTimeline, "Install plugins");
+            PluginManager::GetInstance()->LoadAllPlugins();
+        }
 
         // Initialize this instance and all systems.
-        Initialize();
+        {
+            TimelineScope scope(_startupTimeline, "Initialize");
+            Initialize();
+        }
 
         // Setup and configure all systems.
         _systems.Add<CameraSystem>();
         _renderContext.SetDevice(_graphicsDevice);
 
         ALIMER_LOGINFO("Engine initialized with success.");
+        if (_settings.logStartupTimeline)
+        {
+            _startupTimeline.Log("Startup timeline");
+        }
         _running = true;
         //BeginRun();
 
         // Reset timer.
         _timer.Reset();
 
+        // Start dedicated simulation thread if requested. Headless runs tick the simulation at the fixed rate on the main thread instead.
+        if (!_headless
+            && _settings.fixedTimeStep
+            && _settings.threadedSimulation)
+        {
+            StartSimulationThread();
+        }
+
+        // Move rendering to its own thread, overlapping with simulation of the next frame.
+        if (!_headless
+            && _settings.renderPipelineDepth > 0)
+        {
+            _framePipeline.Start(_settings.renderPipelineDepth, [this](const FrameSnapshot& snapshot) {
+                RenderSnapshot(snapshot);
+            }, [this]() {
+                return CreateFrameData();
+            });
+
+            // Loaders create GPU objects and replace cached resources, neither may overlap with rendering of earlier frames.
+            _resources.SetEndLoadCallback([this]() {
+                _framePipeline.Flush();
+            });
+        }
+
         // Run the first time an update
         //InternalUpdate();
 
@@ -124,50 +261,329 @@ namespace Alimer
 
     void Application::LoadPlugins()
     {
-        PluginManager::GetInstance()->LoadPlugins(FileSystem::GetExecutableFolder());
+        PluginManager::GetInstance()->SetHotReload(_settings.hotReloadPlugins);
+        PluginManager::GetInstance()->DiscoverPlugins(FileSystem::GetExecutableFolder());
+    }
+
+    void Application::ReloadPlugins()
+    {
+        PluginManager* pluginManager = PluginManager::GetInstance();
+        if (!pluginManager->CheckForChanges())
+            return;
+
+        // No plugin code may run on other threads while libraries are swapped.
+        _framePipeline.Flush();
+        std::lock_guard<std::mutex> lock(_simulationMutex);
+        pluginManager->ReloadChangedPlugins();
+    }
+
+    int Application::RunHeadless()
+    {
+        _headless = true;
+
+        if (!InitializeBeforeRun())
+        {
+            return EXIT_FAILURE;
+        }
+
+        // No window to close, exit on termination signals.
+        std::signal(SIGINT, HandleExitSignal);
+        std::signal(SIGTERM, HandleExitSignal);
+
+#if ALIMER_PLATFORM_WINDOWS
+        timeBeginPeriod(1);
+#endif
+
+        while (_running)
+        {
+            RunFrame();
+
+            if (__exitRequested)
+            {
+                Exit();
+            }
+        }
+
+#if ALIMER_PLATFORM_WINDOWS
+        timeEndPeriod(1);
+#endif
+
+        OnExiting();
+        return EXIT_SUCCESS;
     }
 
     void Application::RunFrame()
     {
+        if (_settings.hotReloadPlugins)
+        {
+            ReloadPlugins();
+        }
+
+        _resources.Update();
+
+        if (_headless)
+        {
+            RunHeadlessTick();
+            return;
+        }
+
         if (!_paused)
         {
             // Tick timer.
-            double frameTime = _timer.Frame();
-            double deltaTime = _timer.GetElapsed();
+            _timer.Frame();
+            double frameTime = _timer.GetFrameTime();
+            double elapsedTime = _timer.GetElapsed();
 
             // Update all systems.
-            _systems.Update(deltaTime);
+            double alpha = 1.0;
+            if (!_settings.fixedTimeStep)
+            {
+                _systems.Update(frameTime);
+            }
+            else if (!_settings.threadedSimulation)
+            {
+                alpha = UpdateFixedTimeStep(frameTime);
+            }
+            else
+            {
+                alpha = GetSimulationAlpha();
+            }
 
             // Render single frame if window is not minimzed.
-            if (!_mainWindow->IsMinimized())
+            if (_mainWindow
+                && !_mainWindow->IsMinimized())
             {
-                RenderFrame(frameTime, deltaTime);
+                if (_framePipeline.IsRunning())
+                {
+                    // Blocks only when render thread is more than pipeline depth frames behind.
+                    FrameSnapshot* snapshot = _framePipeline.BeginFrame();
+                    snapshot->frameIndex = _frameIndex;
+                    snapshot->frameTime = frameTime;
+                    snapshot->elapsedTime = elapsedTime;
+                    snapshot->alpha = alpha;
+                    ExtractFrame(*snapshot);
+                    _framePipeline.EndFrame();
+                }
+                else
+                {
+                    RenderFrame(frameTime, elapsedTime, alpha);
+                }
             }
+
+            _frameIndex++;
         }
 
         // Update input, even when paused.
         _input.Update();
     }
 
-    void Application::RenderFrame(double frameTime, double elapsedTime)
+    void Application::RunHeadlessTick()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const double timeStep = 1.0 / Max(_settings.fixedUpdateRate, 1u);
+        const Clock::duration tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeStep));
+
+        if (_paused)
+        {
+            Sleep(10);
+            _nextHeadlessTick = 0;
+            return;
+        }
+
+        Clock::time_point tickStart = Clock::now();
+        if (_nextHeadlessTick == 0)
+        {
+            _nextHeadlessTick = tickStart.time_since_epoch().count();
+            _lastHeadlessTick = _nextHeadlessTick;
+            _lastCpuTime = GetProcessCpuTime();
+        }
+
+        // Simulation always advances by exactly one fixed step per tick.
+        _systems.Update(timeStep);
+        _simulationTick++;
+
+        Clock::time_point updateEnd = Clock::now();
+
+        // CPU usage is measured over the whole tick period, including the sleep of the previous tick.
+        const double cpuTime = GetProcessCpuTime();
+        const double period = std::chrono::duration<double>(Clock::duration(tickStart.time_since_epoch().count() - _lastHeadlessTick)).count();
+        _tickStats.tick = _simulationTick;
+        _tickStats.updateTime = std::chrono::duration<double>(updateEnd - tickStart).count();
+        _tickStats.cpuUsage = period > 0.0 ? (cpuTime - _lastCpuTime) / period : 0.0;
+        _tickStats.memoryUsage = GetProcessMemoryUsage();
+        _lastCpuTime = cpuTime;
+        _lastHeadlessTick = tickStart.time_since_epoch().count();
+
+        if (_settings.tickStatsInterval
+            && (_simulationTick % _settings.tickStatsInterval) == 0)
+        {
+            ALIMER_LOGINFOF("Tick %llu: update %.3f ms, CPU %.1f%%, memory %.2f MB",
+                static_cast<unsigned long long>(_tickStats.tick),
+                _tickStats.updateTime * 1000.0,
+                _tickStats.cpuUsage * 100.0,
+                double(_tickStats.memoryUsage) / (1024.0 * 1024.0));
+        }
+
+        // Schedule next tick on a fixed grid, ticks that fell behind run back to back until caught up.
+        Clock::time_point nextTick = Clock::time_point(Clock::duration(_nextHeadlessTick)) + tickDuration;
+        if (updateEnd - nextTick > tickDuration * Max(_settings.maxFixedUpdateSteps, 1u))
+        {
+            nextTick = updateEnd;
+        }
+
+        _nextHeadlessTick = nextTick.time_since_epoch().count();
+        SleepUntil<Clock>(nextTick);
+    }
+
+    double Application::UpdateFixedTimeStep(double frameTime)
+    {
+        const double timeStep = 1.0 / Max(_settings.fixedUpdateRate, 1u);
+        _fixedAccumulator += frameTime;
+
+        uint32_t steps = 0;
+        while (_fixedAccumulator >= timeStep
+            && steps < _settings.maxFixedUpdateSteps)
+        {
+            _systems.Update(timeStep);
+            _fixedAccumulator -= timeStep;
+            _simulationTick++;
+            steps++;
+        }
+
+        // Drop whatever could not be caught up, otherwise a long stall keeps the simulation behind forever.
+        if (_fixedAccumulator >= timeStep)
+        {
+            _fixedAccumulator = std::fmod(_fixedAccumulator, timeStep);
+        }
+
+        return _fixedAccumulator / timeStep;
+    }
+
+    void Application::StartSimulationThread()
+    {
+        if (_simulationRunning)
+            return;
+
+        _simulationRunning = true;
+        _simulationThread = std::thread(&Application::SimulationThread, this);
+    }
+
+    void Application::StopSimulationThread()
+    {
+        _simulationRunning = false;
+        if (_simulationThread.joinable())
+        {
+            _simulationThread.join();
+        }
+    }
+
+    void Application::SimulationThread()
+    {
+        using Clock = std::chrono::steady_clock;
+
+        SetCurrentThreadName("Simulation");
+
+        const double timeStep = 1.0 / Max(_settings.fixedUpdateRate, 1u);
+        const Clock::duration tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeStep));
+
+        Clock::time_point nextTick = Clock::now() + tickDuration;
+        _nextSimulationTick = nextTick.time_since_epoch().count();
+
+        while (_simulationRunning)
+        {
+            if (_paused)
+            {
+                Sleep(1);
+                nextTick = Clock::now() + tickDuration;
+                continue;
+            }
+
+            Clock::time_point now = Clock::now();
+            uint32_t steps = 0;
+            while (now >= nextTick
+                && steps < _settings.maxFixedUpdateSteps)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_simulationMutex);
+                    _systems.Update(timeStep);
+                }
+
+                _simulationTick++;
+                nextTick += tickDuration;
+                steps++;
+            }
+
+            // Fell too far behind, restart ticking from now.
+            if (now >= nextTick)
+            {
+                nextTick = now + tickDuration;
+            }
+
+            _nextSimulationTick = nextTick.time_since_epoch().count();
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+
+    double Application::GetSimulationAlpha() const
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const double timeStep = 1.0 / Max(_settings.fixedUpdateRate, 1u);
+        const int64_t now = Clock::now().time_since_epoch().count();
+        const double untilNextTick = std::chrono::duration<double>(Clock::duration(_nextSimulationTick - now)).count();
+        return Clamp(1.0 - untilNextTick / timeStep, 0.0, 1.0);
+    }
+
+    void Application::ExtractFrame(FrameSnapshot& snapshot)
+    {
+        std::unique_lock<std::mutex> guard(_simulationMutex, std::defer_lock);
+        if (_simulationRunning)
+            guard.lock();
+
+        _entities.Each<CameraComponent>([&snapshot](Entity entity, CameraComponent& camera) {
+            ALIMER_UNUSED(entity);
+            snapshot.cameras.push_back({ camera.GetView(), camera.GetProjection() });
+        });
+
+        OnExtractFrame(snapshot);
+    }
+
+    void Application::RenderSnapshot(const FrameSnapshot& snapshot)
+    {
+        _renderSnapshot = &snapshot;
+        RenderFrame(snapshot.frameTime, snapshot.elapsedTime, snapshot.alpha);
+        _renderSnapshot = nullptr;
+    }
+
+    void Application::RenderFrame(double frameTime, double elapsedTime, double alpha)
     {
         if (_headless)
             return;
 
+        _interpolationAlpha = alpha;
+
         auto context = _graphicsDevice->GetContext();
 
         RenderPassBeginDescriptor renderPass = {};
         renderPass.colors[0].clearColor = Color4(0.0f, 0.2f, 0.4f, 1.0f);
         context->BeginDefaultRenderPass(&renderPass);
 
-        // Call OnRenderFrame for custom rendering frame logic.
-        OnRenderFrame(context, frameTime, elapsedTime);
-
-        // Render scene to default command buffer.
-        if (_sceneRenderPipeline)
         {
-            //auto camera = _scene.GetActiveCamera()->GetComponent<CameraComponent>()->camera;
-            //_renderPipeline->Render(_renderContext, { camera });
+            // Simulation thread must not touch the scene while it's being recorded, pipelined rendering only reads the snapshot.
+            std::unique_lock<std::mutex> guard(_simulationMutex, std::defer_lock);
+            if (_simulationRunning && !_renderSnapshot)
+                guard.lock();
+
+            // Call OnRenderFrame for custom rendering frame logic.
+            OnRenderFrame(context, frameTime, elapsedTime);
+
+            // Render scene to default command buffer.
+            if (_sceneRenderPipeline)
+            {
+                //auto camera = _scene.GetActiveCamera()->GetComponent<CameraComponent>()->camera;
+                //_renderPipeline->Render(_renderContext, { camera });
+            }
         }
 
         // End swap chain render pass.
@@ -28,14 +28,20 @@
 #include <vector>
 #include <string>
 #include <atomic>
+#include <thread>
+#include <mutex>
 #include "../Core/Object.h"
 #include "../Core/Log.h"
 #include "../Core/Timer.h"
 #include "../Core/PluginManager.h"
+#include "../Core/WorkQueue.h"
+#include "../Core/Timeline.h"
 #include "../Application/Window.h"
 #include "../Application/GameSystem.h"
+#include "../Application/FramePipeline.h"
 #include "../Serialization/Serializable.h"
 #include "../IO/FileSystem.h"
+#include "../Resource/DerivedDataCache.h"
 #include "../Resource/ResourceManager.h"
 #include "../Input/Input.h"
 #include "../Audio/Audio.h"
@@ -57,6 +63,64 @@ namespace Alimer
 #endif
 
         RenderingSettings renderingSettings = {};
+
+        /// Update simulation with fixed time step, decoupled from rendering frame rate.
+        bool fixedTimeStep = false;
+
+        /// Simulation rate in Hz when using fixed time step.
+        uint32_t fixedUpdateRate = 60;
+
+        /// Maximum number of fixed steps to catch up in a single frame.
+        uint32_t maxFixedUpdateSteps = 5;
+
+        /// Run fixed time step simulation on a dedicated thread, separate from rendering. Ignored when headless.
+        bool threadedSimulation = false;
+
+        /// Number of frames rendering may lag behind simulation on a dedicated render thread, 0 to render on the main thread.
+        uint32_t renderPipelineDepth = 0;
+
+        /// Run as server without window, graphics, audio and input, ticking simulation at fixedUpdateRate.
+        bool headless = false;
+
+        /// Load plugins also when running headless.
+        bool headlessPlugins = false;
+
+        /// Log tick statistics every given number of headless ticks, 0 to disable.
+        uint32_t tickStatsInterval = 0;
+
+        /// Number of worker threads, 0 to use one less than hardware threads.
+        uint32_t workerThreads = 0;
+
+        /// Install plugins on first use through PluginManager::GetPlugin instead of at startup. Plugins that only work through side effects of Install are then never installed.
+        bool lazyPlugins = false;
+
+        /// Reload plugin libraries when they are rebuilt, handing state over to the new instance.
+        bool hotReloadPlugins = false;
+
+        /// Reload loaded resources when their file changes in a resource directory.
+        bool autoReloadResources = false;
+
+        /// Log the startup timeline once initialized.
+        bool logStartupTimeline = true;
+
+        /// Directory of the derived data cache holding compiled shaders and decoded images between runs, empty to disable.
+        String derivedDataCacheDirectory;
+
+        /// Maximum size of the derived data cache in bytes.
+        uint64_t derivedDataCacheSize = DEFAULT_DERIVED_DATA_CACHE_SIZE;
+    };
+
+    /// Statistics of the last headless tick.
+    struct TickStats
+    {
+        /// Simulation tick index.
+        uint64_t tick = 0;
+        /// Time spent updating simulation, in seconds.
+        double updateTime = 0.0;
+        /// Process CPU usage over the last tick period, 1.0 being one core fully busy.
+        double cpuUsage = 0.0;
+        /// Resident process memory in bytes.
+        uint64_t memoryUsage = 0;
     };
 
     /// Application for main loop and all modules and OS setup.
@@ -92,6 +156,24 @@ namespace Alimer
 
         Timer &GetFrameTimer() { return _timer; }
 
+        /// Return number of simulation ticks executed so far.
+        uint64_t GetSimulationTick() const { return _simulationTick; }
+
+        /// Return interpolation factor between the last two simulation ticks, valid during rendering.
+        double GetInterpolationAlpha() const { return _interpolationAlpha; }
+
+        /// Return whether running without window, graphics, audio and input.
+        bool IsHeadless() const { return _headless; }
+
+        /// Return statistics of the last headless tick.
+        const TickStats& GetTickStats() const { return _tickStats; }
+
+        /// Return the work queue.
+        WorkQueue& GetWorkQueue() { return _workQueue; }
+
+        /// Return timeline of engine initialization.
+        const Timeline& GetStartupTimeline() const { return _startupTimeline; }
+
         inline ResourceManager& GetResources() { return _resources; }
         inline Window* GetMainWindow() const { return _mainWindow; }
         inline GraphicsDevice* GetGraphicsDevice() const { return _graphicsDevice; }
@@ -101,6 +183,16 @@ namespace Alimer
         void PlatformConstruct();
         bool InitializeBeforeRun();
         void LoadPlugins();
+        void ReloadPlugins();
+        int RunHeadless();
+        void RunHeadlessTick();
+        double UpdateFixedTimeStep(double frameTime);
+        void StartSimulationThread();
+        void StopSimulationThread();
+        void SimulationThread();
+        double GetSimulationAlpha() const;
+        void ExtractFrame(FrameSnapshot& snapshot);
+        void RenderSnapshot(const FrameSnapshot& snapshot);
 
     protected:
         /// Called after setup and engine initialization with all modules initialized.
@@ -110,11 +202,20 @@ namespace Alimer
         virtual void OnExiting() { }
 
         /// Render after frame update.
-        void RenderFrame(double frameTime, double elapsedTime);
+        void RenderFrame(double frameTime, double elapsedTime, double alpha);
 
         /// Called during rendering single frame.
         virtual void OnRenderFrame(SharedPtr<CommandContext> context, double frameTime, double elapsedTime);
 
+        /// Called on the main thread to extract render data of the frame, when rendering is pipelined. Own render data goes to the snapshot data created by CreateFrameData.
+        virtual void OnExtractFrame(FrameSnapshot& snapshot) { ALIMER_UNUSED(snapshot); }
+
+        /// Create own render data for one frame pipeline slot, filled in OnExtractFrame and read while rendering the snapshot. Called once per slot when the render thread starts.
+        virtual FrameData* CreateFrameData() { return nullptr; }
+
+        /// Return the snapshot being rendered, null when rendering is not pipelined.
+        const FrameSnapshot* GetRenderSnapshot() const { return _renderSnapshot; }
+
         std::vector<std::string> _args;
         std::atomic<bool> _running;
         std::atomic<bool> _paused;
@@ -123,11 +224,35 @@ namespace Alimer
 
         Logger* _log;
         Timer _timer;
+        WorkQueue _workQueue;
+        Timeline _startupTimeline;
+
+        /// Fixed time step accumulator, in seconds.
+        double _fixedAccumulator = 0.0;
+        std::atomic<uint64_t> _simulationTick;
+        std::atomic<int64_t> _nextSimulationTick;
+        double _interpolationAlpha = 1.0;
+        std::thread _simulationThread;
+        std::atomic<bool> _simulationRunning;
+        /// Guards systems and entities when simulation runs on a dedicated thread.
+        std::mutex _simulationMutex;
+
+        /// Render thread consuming extracted frames.
+        FramePipeline _framePipeline;
+        const FrameSnapshot* _renderSnapshot = nullptr;
+        uint64_t _frameIndex = 0;
+
+        /// Headless tick scheduling and statistics.
+        int64_t _nextHeadlessTick = 0;
+        int64_t _lastHeadlessTick = 0;
+        double _lastCpuTime = 0.0;
+        TickStats _tickStats;
+
         ResourceManager _resources;
         Window* _mainWindow = nullptr;
         GraphicsDevice* _graphicsDevice = nullptr;
         Input _input;
-        Audio* _audio;
+        Audio* _audio = nullptr;
 
         //
         EntityManager _entities;
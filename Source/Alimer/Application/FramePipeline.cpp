@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Application/FramePipeline.h"
+#include "../Core/Platform.h"
+
+namespace Alimer
+{
+    FramePipeline::FramePipeline()
+    {
+    }
+
+    FramePipeline::~FramePipeline()
+    {
+        Stop();
+    }
+
+    void FramePipeline::Start(uint32_t depth, RenderCallback callback, CreateDataCallback createData)
+    {
+        Stop();
+
+        _depth = Max(depth, 1u);
+        // One slot is filled by the main thread while the others are queued or being rendered.
+        _snapshots.resize(_depth + 1);
+        if (createData)
+        {
+            for (FrameSnapshot& snapshot : _snapshots)
+                snapshot.data.Reset(createData());
+        }
+        _submitted = 0;
+        _completed = 0;
+        _callback = std::move(callback);
+        _running = true;
+        _thread = std::thread(&FramePipeline::RenderThread, this);
+    }
+
+    void FramePipeline::Stop()
+    {
+        if (!_running)
+            return;
+
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _running = false;
+        }
+
+        _frameSubmitted.notify_all();
+        _thread.join();
+        _snapshots.clear();
+    }
+
+    FrameSnapshot* FramePipeline::BeginFrame()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _frameCompleted.wait(lock, [this] { return _submitted - _completed < _depth; });
+
+        FrameSnapshot* snapshot = &_snapshots[_submitted % _snapshots.size()];
+        // Keep allocations from previous use of the slot.
+        snapshot->cameras.clear();
+        if (snapshot->data)
+            snapshot->data->Clear();
+        return snapshot;
+    }
+
+    void FramePipeline::EndFrame()
+    {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _submitted++;
+        }
+
+        _frameSubmitted.notify_one();
+    }
+
+    void FramePipeline::Flush()
+    {
+        // Rendering code waiting for its own frame would never return.
+        if (std::this_thread::get_id() == _thread.get_id())
+            return;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _frameCompleted.wait(lock, [this] { return _completed == _submitted; });
+    }
+
+    void FramePipeline::RenderThread()
+    {
+        SetCurrentThreadName("Render");
+
+        for (;;)
+        {
+            const FrameSnapshot* snapshot;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _frameSubmitted.wait(lock, [this] { return _completed != _submitted || !_running; });
+
+                // Drain pending frames before exiting.
+                if (_completed == _submitted)
+                    break;
+
+                snapshot = &_snapshots[_completed % _snapshots.size()];
+            }
+
+            _callback(*snapshot);
+
+            {
+                std::lock_guard<std::mutex> guard(_mutex);
+                _completed++;
+            }
+
+            _frameCompleted.notify_all();
+        }
+    }
+}
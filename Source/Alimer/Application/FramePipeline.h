@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Ptr.h"
+#include "../Math/Matrix4x4.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Alimer
+{
+    /// Camera state extracted for rendering.
+    struct CameraSnapshot
+    {
+        mat4 view;
+        mat4 projection;
+    };
+
+    /// Base class for application-defined render data, one instance per pipeline slot reused across frames.
+    class ALIMER_API FrameData
+    {
+    public:
+        /// Destructor.
+        virtual ~FrameData() = default;
+
+        /// Called on the main thread before the slot is filled for a new frame.
+        virtual void Clear() { }
+    };
+
+    /// Immutable render data extracted from the simulation for a single frame.
+    struct FrameSnapshot
+    {
+        /// Index of the frame.
+        uint64_t frameIndex = 0;
+        /// Frame delta time, in seconds.
+        double frameTime = 0.0;
+        /// Total elapsed time, in seconds.
+        double elapsedTime = 0.0;
+        /// Interpolation factor between the last two simulation ticks.
+        double alpha = 1.0;
+        /// Extracted cameras.
+        std::vector<CameraSnapshot> cameras;
+        /// Application-defined render data of the slot, null when none was created.
+        UniquePtr<FrameData> data;
+
+        /// Return the application-defined render data as the given type.
+        template <class T> T* GetData() const { return static_cast<T*>(data.Get()); }
+    };
+
+    /// Hands frame snapshots from the main thread over to a dedicated render thread.
+    class ALIMER_API FramePipeline final
+    {
+    public:
+        using RenderCallback = std::function<void(const FrameSnapshot&)>;
+        using CreateDataCallback = std::function<FrameData*()>;
+
+        /// Constructor.
+        FramePipeline();
+
+        /// Destructor. Stops the render thread.
+        ~FramePipeline();
+
+        /// Start render thread allowing given number of frames in flight. The optional create function is called once per slot for its application-defined render data.
+        void Start(uint32_t depth, RenderCallback callback, CreateDataCallback createData = nullptr);
+
+        /// Render all pending frames and stop the render thread.
+        void Stop();
+
+        /// Return whether the render thread is running.
+        bool IsRunning() const { return _running; }
+
+        /// Return the number of frames allowed in flight.
+        uint32_t GetDepth() const { return _depth; }
+
+        /// Acquire the next snapshot to fill, blocks while the render thread is too far behind.
+        FrameSnapshot* BeginFrame();
+
+        /// Submit the snapshot acquired with BeginFrame to the render thread.
+        void EndFrame();
+
+        /// Wait until the render thread has consumed all submitted frames. Returns immediately when called from the render thread.
+        void Flush();
+
+    private:
+        void RenderThread();
+
+        std::vector<FrameSnapshot> _snapshots;
+        uint32_t _depth = 0;
+        uint64_t _submitted = 0;
+        uint64_t _completed = 0;
+        bool _running = false;
+        RenderCallback _callback;
+
+        std::thread _thread;
+        std::mutex _mutex;
+        std::condition_variable _frameSubmitted;
+        std::condition_variable _frameCompleted;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(FramePipeline);
+    };
+}
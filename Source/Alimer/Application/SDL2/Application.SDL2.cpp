@@ -119,6 +119,13 @@ namespace Alimer
 
     int Application::Run()
     {
+        // Server instances don't need SDL at all.
+        if (_headless
+            || _settings.headless)
+        {
+            return RunHeadless();
+        }
+
         SDL_SetMainReady();
         int result = SDL_Init(
             SDL_INIT_VIDEO
@@ -191,6 +198,9 @@ namespace Alimer
             RunFrame();
         }
 
+        _framePipeline.Stop();
+        StopSimulationThread();
+
         OnExiting();
 
         // quit all subsystems and quit application.
@@ -61,8 +61,8 @@ namespace Alimer
                 {
                     remove = false;
                     handler->Invoke(*this);
-                    // If the sender has been destroyed, abort processing immediately
-                    if (safeCurrentSender.IsExpired())
+                    // If the sender has been destroyed, abort processing immediately. Without a sender there is nothing to be destroyed.
+                    if (sender && safeCurrentSender.IsExpired())
                         return;
                 }
             }
@@ -87,7 +87,7 @@ namespace Alimer
         /// Destruct.
         virtual ~Event() = default;
 
-        /// Send the event.
+        /// Send the event to all handlers. Sending stops if the sender is destroyed by a handler. Null sender is allowed for events without one.
         void Send(Object* sender);
         /// Subscribe to the event. The event takes ownership of the handler data. If there is already handler data for the same receiver, it is overwritten.
         void Subscribe(EventHandler* handler);
@@ -215,6 +215,8 @@ namespace Alimer
 
     void Logger::OnLog(LogLevel level, const String& message)
     {
+        std::lock_guard<std::mutex> lock(_mutex);
+
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
         size_t length = strlen(LogLevelPrefix[static_cast<unsigned>(level)]) + 2 + message.Length() + 1 + 1 + 1;
         char* output = new char[length];
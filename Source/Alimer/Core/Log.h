@@ -26,6 +26,7 @@
 #include "../Core/Ptr.h"
 #include <memory>
 #include <vector>
+#include <mutex>
 
 namespace Alimer
 {
@@ -103,6 +104,9 @@ namespace Alimer
         /// List of Listener's on the Log.
         std::vector<LogListener*> _listeners;
 
+        /// Serializes output from multiple threads.
+        std::mutex _mutex;
+
     private:
         DISALLOW_COPY_MOVE_AND_ASSIGN(Logger);
     };
@@ -25,6 +25,7 @@
 
 #if defined(_WIN32)
 #include <windows.h>
+#include <psapi.h>
 
 // ntdll.dll function pointer typedefs
 typedef LONG NTSTATUS, *PNTSTATUS;
@@ -70,12 +71,17 @@ typedef struct tagTHREADNAME_INFO
 #elif defined(__APPLE__) 
 #   include <TargetConditionals.h>
 #   include <sys/time.h>
+#   include <sys/resource.h>
 #   include <unistd.h>
 #   include <dlfcn.h>
 #   include <pthread.h>
+#   include <mach/mach.h>
 #else
 #   include <sys/time.h>
+#   include <sys/resource.h>
 #   include <unistd.h>
+#   include <fcntl.h>
+#   include <cstdio>
 #   include <dlfcn.h>
 #   include <pthread.h>
 #endif
@@ -279,6 +285,77 @@ namespace Alimer
 #else
         timespec time{static_cast<time_t>(milliseconds / 1000), static_cast<long>((milliseconds % 1000) * 1000000)};
         nanosleep(&time, nullptr);
+#endif
+    }
+
+    uint64_t GetProcessMemoryUsage()
+    {
+#if ALIMER_PLATFORM_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters = {};
+        if (::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return static_cast<uint64_t>(counters.WorkingSetSize);
+        }
+
+        return 0;
+#elif defined(__APPLE__)
+        mach_task_basic_info_data_t info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        {
+            return static_cast<uint64_t>(info.resident_size);
+        }
+
+        return 0;
+#elif defined(__linux__) || defined(__ANDROID__)
+        // Second field of statm is the resident set size in pages.
+        int fd = ::open("/proc/self/statm", O_RDONLY);
+        if (fd < 0)
+            return 0;
+
+        char buffer[128];
+        ssize_t length = ::read(fd, buffer, sizeof(buffer) - 1);
+        ::close(fd);
+        if (length <= 0)
+            return 0;
+
+        buffer[length] = '\0';
+        unsigned long long size = 0;
+        unsigned long long resident = 0;
+        if (sscanf(buffer, "%llu %llu", &size, &resident) != 2)
+            return 0;
+
+        return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+        return 0;
+#endif
+    }
+
+    double GetProcessCpuTime()
+    {
+#if ALIMER_PLATFORM_WINDOWS
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (!::GetProcessTimes(::GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+            return 0.0;
+
+        ULARGE_INTEGER kernel;
+        kernel.LowPart = kernelTime.dwLowDateTime;
+        kernel.HighPart = kernelTime.dwHighDateTime;
+        ULARGE_INTEGER user;
+        user.LowPart = userTime.dwLowDateTime;
+        user.HighPart = userTime.dwHighDateTime;
+
+        // FILETIME is in 100 nanoseconds units.
+        return double(kernel.QuadPart + user.QuadPart) * 1e-7;
+#elif ALIMER_PLATFORM_UWP || ALIMER_PLATFORM_WEB
+        return 0.0;
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0.0;
+
+        return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+            + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
 #endif
     }
 }
@@ -142,4 +142,10 @@ namespace Alimer
 
     /// Suspends execution for given milliseconds.
     ALIMER_API void Sleep(uint32_t milliseconds);
+
+    /// Return resident memory of the current process in bytes, or 0 if not available.
+    ALIMER_API uint64_t GetProcessMemoryUsage();
+
+    /// Return CPU time (user and kernel) consumed by the current process in seconds.
+    ALIMER_API double GetProcessCpuTime();
 }
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "../Base/String.h"
+#include <vector>
 
 #if defined(__CYGWIN32__)
 #   define ALIMER_INTERFACE_EXPORT __declspec(dllexport)
@@ -35,6 +36,9 @@
 #   define ALIMER_INTERFACE_EXPORT
 #endif
 
+/// Version of the plugin interface, plugins exporting a different "AlimerPluginApiVersion" are rejected.
+#define ALIMER_PLUGIN_API_VERSION 1
+
 namespace Alimer
 {
     /// Class defining a generic Engine plugin.
@@ -60,13 +64,24 @@ namespace Alimer
         /// Perform any tasks the plugin needs to perform when the system is shut down.
         virtual void Shutdown() {}
 
+        /// Get the plugin version, passed to the reloaded instance when restoring state.
+        virtual uint32_t GetVersion() const { return 0; }
+
+        /// Save state before the plugin library is unloaded for hot-reload.
+        virtual void SaveState(std::vector<uint8_t>& state) { ALIMER_UNUSED(state); }
+
+        /// Restore state saved by the previous instance of given version after hot-reload, return false if state is not compatible.
+        virtual bool RestoreState(const std::vector<uint8_t>& state, uint32_t version) { ALIMER_UNUSED(state); ALIMER_UNUSED(version); return true; }
+
     private:
         DISALLOW_COPY_MOVE_AND_ASSIGN(Plugin);
     };
 
     // Plugins should implement thoose functions
     // "AlimerPluginLoad" and "AlimerPluginUnload" (extern "C")
+    // and optionally "AlimerPluginApiVersion" returning ALIMER_PLUGIN_API_VERSION.
     typedef Plugin* (*PluginLoadFunc)();
     typedef void (*PluginUnloadFunc)(Plugin*);
+    typedef uint32_t (*PluginApiVersionFunc)();
 
 }
@@ -24,6 +24,9 @@
 #include "../IO/FileSystem.h"
 #include "../Core/Log.h"
 #include "../Core/Platform.h"
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
 
 #if defined(_WIN32)
 #   define PLUGIN_EXT ".dll"
@@ -33,6 +36,10 @@
 #   define PLUGIN_EXT ".so"
 #endif
 
+#define PLUGIN_MANIFEST "Plugins.manifest"
+#define PLUGIN_SHADOW_DIRECTORY ".hotreload/"
+#define PLUGIN_CHECK_INTERVAL_MS 500
+
 namespace Alimer
 {
     PluginManager *PluginManager::_instance;
@@ -43,7 +50,22 @@ namespace Alimer
 
     PluginManager::~PluginManager()
     {
+        for (PluginEntry& entry : _entries)
+        {
+            if (entry.installed)
+            {
+                entry.plugin->Shutdown();
+                entry.plugin->Uninstall();
+            }
+
+            UnloadEntry(entry);
+        }
 
+        for (auto& plugin : _plugins)
+        {
+            plugin->Shutdown();
+            plugin->Uninstall();
+        }
     }
 
     PluginManager *PluginManager::GetInstance()
@@ -61,34 +83,180 @@ namespace Alimer
     }
 
     void PluginManager::LoadPlugins(const String& pluginPath)
+    {
+        DiscoverPlugins(pluginPath);
+        LoadAllPlugins();
+    }
+
+    void PluginManager::DiscoverPlugins(const String& pluginPath)
     {
         ALIMER_LOGTRACE("Initializing Plugin System...");
-        ALIMER_LOGDEBUGF("Scanning for plugins in directory '%s'", pluginPath.CString());
 
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        const String directory = AddTrailingSlash(pluginPath);
+        const String manifestPath = directory + PLUGIN_MANIFEST;
+        const uint64_t directoryTime = FileSystem::GetLastModifiedTime(RemoveTrailingSlash(directory));
+
+        uint64_t cachedDirectoryTime = 0;
+        std::vector<PluginEntry> cached;
+        const bool hasManifest = ReadManifest(manifestPath, cachedDirectoryTime, cached);
+
+        // Unchanged directory means same set of files, scanning can be skipped.
         std::vector<String> files;
-        ScanDirectory(files, pluginPath, PLUGIN_EXT, ScanDirFlags::Files, false);
+        if (hasManifest
+            && directoryTime != 0
+            && directoryTime == cachedDirectoryTime)
+        {
+            for (const PluginEntry& entry : cached)
+            {
+                files.push_back(entry.fileName);
+            }
+        }
+        else
+        {
+            ALIMER_LOGDEBUGF("Scanning for plugins in directory '%s'", pluginPath.CString());
+            ScanDirectory(files, directory, PLUGIN_EXT, ScanDirFlags::Files, false);
+        }
 
-        for (const String& pluginFile : files)
+        bool manifestDirty = !hasManifest || directoryTime != cachedDirectoryTime;
+        for (const String& fileName : files)
         {
-            LoadPlugin(pluginFile);
+            const String fullPath = directory + fileName;
+            auto existing = std::find_if(_entries.begin(), _entries.end(), [&fullPath](const PluginEntry& entry) {
+                return entry.fileName == fullPath;
+            });
+
+            if (existing != _entries.end())
+                continue;
+
+            PluginEntry entry;
+            entry.fileName = fileName;
+            entry.modifiedTime = FileSystem::GetLastModifiedTime(fullPath);
+
+            auto it = std::find_if(cached.begin(), cached.end(), [&fileName](const PluginEntry& cachedEntry) {
+                return cachedEntry.fileName == fileName;
+            });
+
+            if (it != cached.end()
+                && it->modifiedTime == entry.modifiedTime)
+            {
+                // Trust the manifest, library is loaded on first use.
+                entry.name = it->name;
+            }
+            else
+            {
+                // New or changed library, need to load it to find its name.
+                manifestDirty = true;
+                entry.fileName = fullPath;
+                LoadEntry(entry);
+            }
+
+            entry.fileName = fullPath;
+            _entries.push_back(entry);
+        }
+
+        if (manifestDirty)
+        {
+            WriteManifest(manifestPath, directory, directoryTime);
+
+            // Creating the manifest touches the directory itself, store the final time so next start skips scanning.
+            const uint64_t newDirectoryTime = FileSystem::GetLastModifiedTime(RemoveTrailingSlash(directory));
+            if (newDirectoryTime != directoryTime)
+            {
+                WriteManifest(manifestPath, directory, newDirectoryTime);
+            }
         }
 
-        // List enumerated plugins
-        /*for (auto it : _plugins)
+        ALIMER_LOGDEBUGF("Discovered %u plugins", static_cast<uint32_t>(GetAvailablePlugins().size()));
+    }
+
+    void PluginManager::LoadAllPlugins()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for (PluginEntry& entry : _entries)
         {
-            const PluginDesc& desc = it.second;
-            ALIMER_LOGINFOF("Loaded plugin => Name: '%s', Version: '%u.%u'",
-                desc.name,
-                ALIMER_VERSION_MAJOR(desc.version),
-                ALIMER_VERSION_MAJOR(desc.version));
-        }*/
+            if (!entry.name.IsEmpty())
+            {
+                InstallEntry(entry);
+            }
+        }
+    }
+
+    Plugin* PluginManager::GetPlugin(const String& name)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for (PluginEntry& entry : _entries)
+        {
+            if (entry.name == name)
+            {
+                InstallEntry(entry);
+                return entry.installed ? entry.plugin : nullptr;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::vector<String> PluginManager::GetAvailablePlugins() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        std::vector<String> result;
+        for (const PluginEntry& entry : _entries)
+        {
+            if (!entry.name.IsEmpty())
+                result.push_back(entry.name);
+        }
+
+        return result;
     }
 
     bool PluginManager::LoadPlugin(const String& pluginName)
     {
-        void* libHandle = LoadNativeLibrary(pluginName.CString());
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        PluginEntry entry;
+        entry.fileName = pluginName;
+        entry.modifiedTime = FileSystem::GetLastModifiedTime(pluginName);
+        if (!LoadEntry(entry))
+        {
+            return false;
+        }
+
+        _entries.push_back(entry);
+        InstallEntry(_entries.back());
+        return true;
+    }
+
+    bool PluginManager::LoadEntry(PluginEntry& entry)
+    {
+        entry.modifiedTime = FileSystem::GetLastModifiedTime(entry.fileName);
+
+        // Load from a copy so the original can be rebuilt, unique name makes the OS load new code.
+        entry.loadedFileName = entry.fileName;
+        if (_hotReload)
+        {
+            String path, file, extension;
+            SplitPath(entry.fileName, path, file, extension, false);
+
+            const String shadowDirectory = path + PLUGIN_SHADOW_DIRECTORY;
+            const String shadowFileName = String::Format("%s%s.%u%s", shadowDirectory.CString(), file.CString(), ++_shadowCopyIndex, extension.CString());
+            if (FileSystem::CreateDirectory(shadowDirectory)
+                && FileSystem::Copy(entry.fileName, shadowFileName))
+            {
+                entry.loadedFileName = shadowFileName;
+            }
+            else
+            {
+                ALIMER_LOGWARNF("Cannot create shadow copy of plugin '%s', it won't be reloadable", entry.fileName.CString());
+            }
+        }
+
+        void* libHandle = LoadNativeLibrary(entry.loadedFileName.CString());
         if (!libHandle)
         {
+            UnloadEntry(entry);
             return false;
         }
 
@@ -96,17 +264,32 @@ namespace Alimer
         if (!loadFunc)
         {
             UnloadNativeLibrary(libHandle);
+            UnloadEntry(entry);
             return false;  // Not a plugin
         }
 
+        PluginApiVersionFunc apiVersionFunc = (PluginApiVersionFunc)GetSymbol(libHandle, "AlimerPluginApiVersion");
+        if (apiVersionFunc
+            && apiVersionFunc() != ALIMER_PLUGIN_API_VERSION)
+        {
+            ALIMER_LOGERRORF("Plugin '%s' was built against plugin API version %u, expected %u",
+                entry.fileName.CString(), apiVersionFunc(), ALIMER_PLUGIN_API_VERSION);
+            UnloadNativeLibrary(libHandle);
+            UnloadEntry(entry);
+            return false;
+        }
+
+        entry.library = libHandle;
+        entry.unloadFunc = (PluginUnloadFunc)GetSymbol(libHandle, "AlimerPluginUnload");
+
         // Try to instance the plugin being loaded
         try
         {
             Plugin* plugin = loadFunc();
             if (plugin)
             {
-                InstallPlugin(plugin);
-                //UnloadNativeLibrary(libHandle);
+                entry.name = plugin->GetName();
+                entry.plugin = plugin;
                 return true;
             }
         }
@@ -115,11 +298,236 @@ namespace Alimer
 
         }
 
+        UnloadEntry(entry);
+        return false;
+    }
+
+    void PluginManager::UnloadEntry(PluginEntry& entry)
+    {
+        if (entry.plugin)
+        {
+            // Instance must be destroyed by the library which allocated it.
+            if (entry.unloadFunc)
+                entry.unloadFunc(entry.plugin);
+            else
+                delete entry.plugin;
+
+            entry.plugin = nullptr;
+        }
+
+        if (entry.library)
+        {
+            UnloadNativeLibrary(entry.library);
+            entry.library = nullptr;
+        }
+
+        if (!entry.loadedFileName.IsEmpty()
+            && entry.loadedFileName != entry.fileName)
+        {
+            FileSystem::Delete(entry.loadedFileName);
+        }
+
+        entry.loadedFileName.Clear();
+        entry.unloadFunc = nullptr;
+        entry.installed = false;
+    }
+
+    void PluginManager::InstallEntry(PluginEntry& entry)
+    {
+        if (entry.installed)
+            return;
+
+        if (!entry.plugin
+            && !LoadEntry(entry))
+        {
+            ALIMER_LOGERRORF("Failed to load plugin '%s' from '%s'", entry.name.CString(), entry.fileName.CString());
+            return;
+        }
+
+        entry.installed = true;
+        ALIMER_LOGINFOF("Installing plugin: %s", entry.plugin->GetName().CString());
+        entry.plugin->Install();
+        entry.plugin->Initialize();
+        ALIMER_LOGINFO("Plugin successfully installed");
+    }
+
+    bool PluginManager::ReadManifest(const String& manifestPath, uint64_t& directoryTime, std::vector<PluginEntry>& entries)
+    {
+        if (!FileSystem::FileExists(manifestPath))
+            return false;
+
+        FileStream stream(manifestPath, FileAccess::ReadOnly);
+        if (!stream.IsOpen())
+            return false;
+
+        // Format: "directoryTime" line followed by "modifiedTime|fileName|pluginName" lines, empty name for non plugin libraries.
+        std::vector<String> lines = stream.ReadAllText().Split('\n');
+        if (lines.empty())
+            return false;
+
+        directoryTime = strtoull(lines[0].Trimmed().CString(), nullptr, 10);
+        for (size_t i = 1; i < lines.size(); ++i)
+        {
+            std::vector<String> fields = lines[i].Trimmed().Split('|', true);
+            if (fields.size() != 3)
+                continue;
+
+            PluginEntry entry;
+            entry.modifiedTime = strtoull(fields[0].CString(), nullptr, 10);
+            entry.fileName = fields[1];
+            entry.name = fields[2];
+            entries.push_back(entry);
+        }
+
+        return true;
+    }
+
+    void PluginManager::WriteManifest(const String& manifestPath, const String& directory, uint64_t directoryTime)
+    {
+        FileStream stream(manifestPath, FileAccess::WriteOnly);
+        if (!stream.IsOpen())
+        {
+            ALIMER_LOGDEBUGF("Cannot write plugin manifest '%s'", manifestPath.CString());
+            return;
+        }
+
+        stream.WriteLine(String(static_cast<unsigned long long>(directoryTime)));
+        for (const PluginEntry& entry : _entries)
+        {
+            if (!entry.fileName.StartsWith(directory))
+                continue;
+
+            stream.WriteLine(String::Format("%llu|%s|%s",
+                static_cast<unsigned long long>(entry.modifiedTime),
+                FileSystem::GetFileNameAndExtension(entry.fileName).CString(),
+                entry.name.CString()));
+        }
+    }
+
+    void PluginManager::SetHotReload(bool enable)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        _hotReload = enable;
+    }
+
+    bool PluginManager::CheckForChanges()
+    {
+        if (!_hotReload)
+            return false;
+
+        const int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (now - _lastCheckTime < PLUGIN_CHECK_INTERVAL_MS)
+            return false;
+
+        _lastCheckTime = now;
+
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        bool ready = false;
+        for (PluginEntry& entry : _entries)
+        {
+            // Libraries not loaded yet will load the new file on first use.
+            if (!entry.plugin)
+                continue;
+
+            const uint64_t modifiedTime = FileSystem::GetLastModifiedTime(entry.fileName);
+            if (modifiedTime == 0
+                || modifiedTime == entry.modifiedTime)
+            {
+                entry.pendingTime = 0;
+                continue;
+            }
+
+            // Wait for one more check so that the library is not reloaded while still being written.
+            if (modifiedTime == entry.pendingTime)
+                ready = true;
+            else
+                entry.pendingTime = modifiedTime;
+        }
+
+        return ready;
+    }
+
+    uint32_t PluginManager::ReloadChangedPlugins()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+        uint32_t count = 0;
+        for (PluginEntry& entry : _entries)
+        {
+            if (!entry.plugin
+                || entry.pendingTime == 0
+                || FileSystem::GetLastModifiedTime(entry.fileName) != entry.pendingTime)
+            {
+                continue;
+            }
+
+            entry.pendingTime = 0;
+            if (ReloadEntry(entry))
+                count++;
+        }
+
+        return count;
+    }
+
+    bool PluginManager::ReloadPlugin(const String& name)
+    {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+        for (PluginEntry& entry : _entries)
+        {
+            if (entry.name == name)
+                return ReloadEntry(entry);
+        }
+
         return false;
     }
 
+    bool PluginManager::ReloadEntry(PluginEntry& entry)
+    {
+        PluginEntry newEntry;
+        newEntry.fileName = entry.fileName;
+        if (!LoadEntry(newEntry))
+        {
+            ALIMER_LOGERRORF("Failed to reload plugin '%s', keeping current instance", entry.fileName.CString());
+            return false;
+        }
+
+        if (newEntry.name != entry.name)
+        {
+            ALIMER_LOGERRORF("Reloaded plugin '%s' changed name to '%s', keeping current instance", entry.name.CString(), newEntry.name.CString());
+            UnloadEntry(newEntry);
+            return false;
+        }
+
+        const bool wasInstalled = entry.installed;
+        const uint32_t oldVersion = entry.plugin->GetVersion();
+        std::vector<uint8_t> state;
+        if (wasInstalled)
+        {
+            entry.plugin->SaveState(state);
+            entry.plugin->Shutdown();
+            entry.plugin->Uninstall();
+        }
+
+        UnloadEntry(entry);
+        entry = newEntry;
+
+        if (wasInstalled)
+        {
+            InstallEntry(entry);
+            if (!entry.plugin->RestoreState(state, oldVersion))
+            {
+                ALIMER_LOGWARNF("Plugin '%s' discarded state of version %u", entry.name.CString(), oldVersion);
+            }
+        }
+
+        ALIMER_LOGINFOF("Reloaded plugin '%s' (version %u -> %u)", entry.name.CString(), oldVersion, entry.plugin->GetVersion());
+        return true;
+    }
+
     void PluginManager::InstallPlugin(Plugin* plugin)
     {
+        std::lock_guard<std::recursive_mutex> lock(_mutex);
+
         ALIMER_LOGINFOF("Installing plugin: %s", plugin->GetName().CString());
 
         _plugins.push_back(UniquePtr<Plugin>(plugin));
@@ -28,6 +28,7 @@
 #include "../Core/Plugin.h"
 #include <vector>
 #include <unordered_map>
+#include <mutex>
 
 namespace Alimer
 {
@@ -41,18 +42,77 @@ namespace Alimer
         /// Shutdown the plugin manager.
         static void Shutdown();
 
-        /// Load plugins from given path.
+        /// Load and install all plugins from given path.
         void LoadPlugins(const String& pluginPath);
+
+        /// Discover plugins in given path without installing them, using the cached manifest to skip loading unchanged libraries.
+        void DiscoverPlugins(const String& pluginPath);
+
+        /// Install all discovered plugins not installed yet.
+        void LoadAllPlugins();
+
+        /// Return plugin by name, loading and installing it on first use. Return null if not available.
+        Plugin* GetPlugin(const String& name);
+
+        /// Return names of all discovered plugins.
+        std::vector<String> GetAvailablePlugins() const;
+
         bool LoadPlugin(const String& pluginName);
         void InstallPlugin(Plugin* plugin);
 
+        /// Enable loading plugin libraries from shadow copies, so that they can be rebuilt and reloaded while running.
+        void SetHotReload(bool enable);
+
+        /// Return whether hot-reload is enabled.
+        bool IsHotReloadEnabled() const { return _hotReload; }
+
+        /// Check loaded plugin libraries for changes, return true when a changed library is ready to be reloaded.
+        bool CheckForChanges();
+
+        /// Reload changed plugin libraries, handing state over from old to new instances. Return number of reloaded plugins.
+        uint32_t ReloadChangedPlugins();
+
+        /// Reload plugin by name. Old instance is kept if the new library fails to load.
+        bool ReloadPlugin(const String& name);
+
     private:
+        /// Discovered plugin library.
+        struct PluginEntry
+        {
+            String name;
+            String fileName;
+            uint64_t modifiedTime = 0;
+            /// Modification time seen on last check, reload waits until it stays the same.
+            uint64_t pendingTime = 0;
+            /// Shadow copy the library was loaded from when hot-reload is enabled.
+            String loadedFileName;
+            void* library = nullptr;
+            Plugin* plugin = nullptr;
+            PluginUnloadFunc unloadFunc = nullptr;
+            bool installed = false;
+        };
+
         /// Constructor.
         PluginManager();
         ~PluginManager();
 
+        /// Load library and create plugin instance, return false if not a plugin.
+        bool LoadEntry(PluginEntry& entry);
+        void InstallEntry(PluginEntry& entry);
+        /// Destroy plugin instance and unload its library.
+        void UnloadEntry(PluginEntry& entry);
+        bool ReloadEntry(PluginEntry& entry);
+        bool ReadManifest(const String& manifestPath, uint64_t& directoryTime, std::vector<PluginEntry>& entries);
+        void WriteManifest(const String& manifestPath, const String& directory, uint64_t directoryTime);
+
         static PluginManager *_instance;
         std::vector<UniquePtr<Plugin>> _plugins;
+        /// Discovered libraries, including the ones not being plugins, so they are never probed again.
+        std::vector<PluginEntry> _entries;
+        mutable std::recursive_mutex _mutex;
+        bool _hotReload = false;
+        uint32_t _shadowCopyIndex = 0;
+        int64_t _lastCheckTime = 0;
 
     private:
         DISALLOW_COPY_MOVE_AND_ASSIGN(PluginManager);
@@ -700,7 +700,7 @@ namespace Alimer
         /// Assign from a pointer. Existing array is deleted and ownership is transferred from the source pointer, which becomes null.
         AutoArrayPtr<T>& operator = (AutoArrayPtr<T>& rhs)
         {
-            delete _array;
+            delete[] _array;
             _array = rhs._array;
             rhs._array = nullptr;
             return *this;
@@ -709,7 +709,7 @@ namespace Alimer
         /// Assign a new array. Existing array is deleted.
         AutoArrayPtr<T>& operator = (T* rhs)
         {
-            delete _array;
+            delete[] _array;
             _array = rhs;
             return *this;
         }
@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Core/Timeline.h"
+#include "../Core/Log.h"
+#include <algorithm>
+
+namespace Alimer
+{
+    Timeline::Timeline()
+        : _start(Clock::now())
+    {
+    }
+
+    void Timeline::Reset()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+        _start = Clock::now();
+    }
+
+    uint32_t Timeline::Begin(const String& name)
+    {
+        const double now = GetElapsed();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.push_back({ name, std::this_thread::get_id(), now, now });
+        return static_cast<uint32_t>(_entries.size() - 1);
+    }
+
+    void Timeline::End(uint32_t index)
+    {
+        const double now = GetElapsed();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (index < _entries.size())
+        {
+            _entries[index].end = now;
+        }
+    }
+
+    double Timeline::GetElapsed() const
+    {
+        return std::chrono::duration<double>(Clock::now() - _start).count();
+    }
+
+    std::vector<Timeline::Entry> Timeline::GetEntries() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _entries;
+    }
+
+    void Timeline::Log(const char* title) const
+    {
+        std::vector<Entry> entries = GetEntries();
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.begin < b.begin;
+        });
+
+        // Number threads in order of first appearance, the first one being the caller thread.
+        std::vector<std::thread::id> threads;
+        double total = 0.0;
+        for (const Entry& entry : entries)
+        {
+            if (std::find(threads.begin(), threads.end(), entry.thread) == threads.end())
+                threads.push_back(entry.thread);
+
+            total = std::max(total, entry.end);
+        }
+
+        ALIMER_LOGINFOF("%s (%.2f ms):", title, total * 1000.0);
+        for (const Entry& entry : entries)
+        {
+            const size_t threadIndex = std::find(threads.begin(), threads.end(), entry.thread) - threads.begin();
+            ALIMER_LOGINFOF("  [%8.2f - %8.2f ms] %8.2f ms  thread %u  %s",
+                entry.begin * 1000.0,
+                entry.end * 1000.0,
+                (entry.end - entry.begin) * 1000.0,
+                static_cast<uint32_t>(threadIndex),
+                entry.name.CString());
+        }
+    }
+}
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/String.h"
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+namespace Alimer
+{
+    /// Records named time ranges from any thread, used to report where startup time is spent.
+    class ALIMER_API Timeline
+    {
+    public:
+        /// Recorded time range.
+        struct Entry
+        {
+            String name;
+            std::thread::id thread;
+            /// Begin and end in seconds since timeline reset.
+            double begin;
+            double end;
+        };
+
+        /// Constructor.
+        Timeline();
+
+        /// Clear entries and restart the clock.
+        void Reset();
+
+        /// Begin a time range and return its index.
+        uint32_t Begin(const String& name);
+
+        /// End a time range previously returned by Begin.
+        void End(uint32_t index);
+
+        /// Return seconds elapsed since reset.
+        double GetElapsed() const;
+
+        /// Log all entries ordered by begin time.
+        void Log(const char* title) const;
+
+        /// Return recorded entries.
+        std::vector<Entry> GetEntries() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        Clock::time_point _start;
+        mutable std::mutex _mutex;
+        std::vector<Entry> _entries;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(Timeline);
+    };
+
+    /// Records a timeline range for the lifetime of the scope.
+    class ALIMER_API TimelineScope
+    {
+    public:
+        TimelineScope(Timeline& timeline, const String& name)
+            : _timeline(timeline)
+            , _index(timeline.Begin(name))
+        {
+        }
+
+        ~TimelineScope()
+        {
+            _timeline.End(_index);
+        }
+
+    private:
+        Timeline& _timeline;
+        uint32_t _index;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(TimelineScope);
+    };
+}
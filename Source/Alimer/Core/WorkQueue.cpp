@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Core/WorkQueue.h"
+#include "../Core/Platform.h"
+#include "../Core/Log.h"
+#include "../Math/MathUtil.h"
+#include <atomic>
+
+namespace Alimer
+{
+    WorkQueue::WorkQueue()
+    {
+        AddSubsystem(this);
+    }
+
+    WorkQueue::~WorkQueue()
+    {
+        Shutdown();
+        RemoveSubsystem(this);
+    }
+
+    void WorkQueue::CreateThreads(uint32_t numThreads)
+    {
+        if (!_threads.empty())
+            return;
+
+        if (numThreads == 0)
+        {
+            uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+
+        _shutdown = false;
+        _threads.reserve(numThreads);
+        for (uint32_t i = 0; i < numThreads; ++i)
+        {
+            _threads.emplace_back(&WorkQueue::WorkerThread, this, i);
+        }
+
+        ALIMER_LOGDEBUGF("Created %u worker threads", numThreads);
+    }
+
+    void WorkQueue::Shutdown()
+    {
+        if (_threads.empty())
+            return;
+
+        Complete();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _shutdown = true;
+        }
+
+        _workCondition.notify_all();
+        for (std::thread& thread : _threads)
+        {
+            thread.join();
+        }
+
+        _threads.clear();
+    }
+
+    void WorkQueue::AddWorkItem(std::function<void()> work, WorkPriority priority)
+    {
+        if (_threads.empty())
+        {
+            work();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queues[static_cast<uint32_t>(priority)].push_back(std::move(work));
+            _pendingItems++;
+        }
+
+        _workCondition.notify_one();
+    }
+
+    void WorkQueue::ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& func)
+    {
+        if (count == 0)
+            return;
+
+        batchSize = Max(batchSize, 1u);
+        const uint32_t numBatches = (count + batchSize - 1) / batchSize;
+        if (numBatches == 1 || _threads.empty() || IsWorkerThread())
+        {
+            func(0, count);
+            return;
+        }
+
+        // Batches are claimed from a shared counter, so the calling thread keeps working even when workers are busy.
+        struct ParallelForState
+        {
+            std::atomic<uint32_t> nextBatch{ 0 };
+            std::atomic<uint32_t> completedBatches{ 0 };
+            std::mutex mutex;
+            std::condition_variable condition;
+        };
+
+        auto state = std::make_shared<ParallelForState>();
+        auto runBatches = [state, count, batchSize, numBatches, &func]()
+        {
+            uint32_t batch;
+            while ((batch = state->nextBatch.fetch_add(1)) < numBatches)
+            {
+                const uint32_t begin = batch * batchSize;
+                func(begin, Min(begin + batchSize, count));
+                if (state->completedBatches.fetch_add(1) + 1 == numBatches)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->condition.notify_all();
+                }
+            }
+        };
+
+        const uint32_t numHelpers = Min(numBatches - 1, GetNumThreads());
+        for (uint32_t i = 0; i < numHelpers; ++i)
+        {
+            AddWorkItem(runBatches, WorkPriority::High);
+        }
+
+        runBatches();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->condition.wait(lock, [&state, numBatches]() { return state->completedBatches == numBatches; });
+    }
+
+    void WorkQueue::Complete()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_pendingItems > 0)
+        {
+            if (!ExecuteWorkItem(lock))
+            {
+                _completedCondition.wait(lock);
+            }
+        }
+    }
+
+    bool WorkQueue::IsCompleted() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pendingItems == 0;
+    }
+
+    bool WorkQueue::IsWorkerThread() const
+    {
+        const std::thread::id currentId = std::this_thread::get_id();
+        for (const std::thread& thread : _threads)
+        {
+            if (thread.get_id() == currentId)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool WorkQueue::ExecuteWorkItem(std::unique_lock<std::mutex>& lock)
+    {
+        for (auto& queue : _queues)
+        {
+            if (queue.empty())
+                continue;
+
+            std::function<void()> work = std::move(queue.front());
+            queue.pop_front();
+
+            lock.unlock();
+            work();
+            lock.lock();
+
+            if (--_pendingItems == 0)
+            {
+                _completedCondition.notify_all();
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    void WorkQueue::WorkerThread(uint32_t index)
+    {
+        String threadName = String::Format("Worker %u", index);
+        SetCurrentThreadName(threadName.CString());
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_shutdown)
+        {
+            if (!ExecuteWorkItem(lock))
+            {
+                _workCondition.wait(lock);
+            }
+        }
+    }
+}
@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+namespace Alimer
+{
+    /// Defines work item priority, higher priority items are executed first.
+    enum class WorkPriority : uint32_t
+    {
+        High = 0,
+        Normal,
+        Low,
+        Count
+    };
+
+    /// Work queue subsystem for multithreading.
+    class ALIMER_API WorkQueue final : public Object
+    {
+        ALIMER_OBJECT(WorkQueue, Object);
+
+    public:
+        /// Constructor.
+        WorkQueue();
+
+        /// Destructor.
+        ~WorkQueue() override;
+
+        /// Create worker threads, 0 to use one less than hardware threads. Can only be called once.
+        void CreateThreads(uint32_t numThreads = 0);
+
+        /// Complete pending work and stop worker threads.
+        void Shutdown();
+
+        /// Add a work item. Executed immediately when there are no worker threads.
+        void AddWorkItem(std::function<void()> work, WorkPriority priority = WorkPriority::Normal);
+
+        /// Run function on a worker thread and return future of the result.
+        template <typename Func>
+        auto Async(Func&& func, WorkPriority priority = WorkPriority::Normal) -> std::future<decltype(func())>
+        {
+            using ResultType = decltype(func());
+            auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+            std::future<ResultType> result = task->get_future();
+            AddWorkItem([task]() { (*task)(); }, priority);
+            return result;
+        }
+
+        /// Execute func(begin, end) over [0, count) split in batches, the calling thread participates and returns when all batches have completed.
+        void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& func);
+
+        /// Wait until all queued work has completed, executing work on the calling thread meanwhile.
+        void Complete();
+
+        /// Return whether all work has completed.
+        bool IsCompleted() const;
+
+        /// Return number of worker threads.
+        uint32_t GetNumThreads() const { return static_cast<uint32_t>(_threads.size()); }
+
+        /// Return whether called from one of the worker threads.
+        bool IsWorkerThread() const;
+
+    private:
+        /// Pop and execute the highest priority work item, return false if queue is empty.
+        bool ExecuteWorkItem(std::unique_lock<std::mutex>& lock);
+        void WorkerThread(uint32_t index);
+
+        std::vector<std::thread> _threads;
+        std::deque<std::function<void()>> _queues[static_cast<uint32_t>(WorkPriority::Count)];
+        mutable std::mutex _mutex;
+        std::condition_variable _workCondition;
+        std::condition_variable _completedCondition;
+        /// Number of queued and executing work items.
+        uint32_t _pendingItems = 0;
+        bool _shutdown = false;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(WorkQueue);
+    };
+}
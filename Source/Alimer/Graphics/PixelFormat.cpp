@@ -127,29 +127,21 @@ namespace Alimer
 
     uint32_t CalculateDataSize(uint32_t width, uint32_t height, PixelFormat format, uint32_t* numRows, uint32_t* rowPitch)
     {
+        const PixelFormatDesc& desc = FormatDesc[static_cast<uint32_t>(format)];
         uint32_t rows, rowSize, dataSize;
 
-        //if (format < PixelFormat::BC1)
+        if (desc.isCompressed)
         {
-            rows = height;
-            rowSize = width * GetPixelFormatSize(format);
-            dataSize = rows * rowSize;
-        }
-        /*else if (format < PixelFormat::PVRTC_RGB_2BPP)
-        {
-            uint32_t blockSize = (format == PixelFormat::BC1 || format == PixelFormat::ETC1) ? 8 : 16;
-            rows = (size.height + 3) / 4;
-            rowSize = ((size.width + 3) / 4) * blockSize;
-            dataSize = rows * rowSize;
+            // Block compressed, rows are rows of blocks.
+            rows = (height + desc.compressionRatio.height - 1) / desc.compressionRatio.height;
+            rowSize = ((width + desc.compressionRatio.width - 1) / desc.compressionRatio.width) * desc.bytesPerBlock;
         }
         else
         {
-            uint32_t blockSize = format < PixelFormat::PVRTC_RGB_4BPP ? 2 : 4;
-            uint32_t dataWidth = Max(width, blockSize == 2 ? 16u : 8u);
-            rows = Max(height, 8u);
-            dataSize = (dataWidth * rows * blockSize + 7) >> 3;
-            rowSize = dataSize / rows;
-        }*/
+            rows = height;
+            rowSize = width * desc.bytesPerBlock;
+        }
+        dataSize = rows * rowSize;
 
         if (numRows)
             *numRows = rows;
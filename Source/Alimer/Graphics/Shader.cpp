@@ -24,6 +24,7 @@
 #include "../Graphics/GraphicsDevice.h"
 #include "../Graphics/ShaderCompiler.h"
 #include "../IO/FileSystem.h"
+#include "../Resource/CookedAsset.h"
 #include "../Core/Log.h"
 #include <spirv-cross/spirv_glsl.hpp>
 
@@ -169,12 +170,184 @@ namespace Alimer
         ExtractInputOutputs(reflection->stage, resources.stage_outputs, compiler, ResourceParamType::Output, ParamAccess::Write, reflection->resources);
     }
 
+    /// Cooked shader stage record, followed by the resource records and the code.
+    struct CookedShaderStage
+    {
+        uint32_t stage;
+        uint32_t inputMask;
+        uint32_t outputMask;
+        uint32_t resourceCount;
+        uint64_t codeSize;
+    };
+
+    /// Cooked shader resource record, followed by the name.
+    struct CookedShaderResource
+    {
+        uint32_t stages;
+        uint32_t resourceType;
+        uint32_t dataType;
+        uint32_t access;
+        uint32_t set;
+        uint32_t binding;
+        uint32_t location;
+        uint32_t vecSize;
+        uint32_t arraySize;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t nameLength;
+    };
+
+    void CookedShader::SetStage(ShaderStage stage, const ShaderBlob& blob)
+    {
+        const unsigned index = static_cast<unsigned>(stage);
+        _code[index].assign(blob.data, blob.data + blob.size);
+        _reflection[index] = ShaderReflection();
+        if (blob.reflection)
+            _reflection[index] = *blob.reflection;
+        else
+            SPIRVReflectResources(reinterpret_cast<const uint32_t*>(blob.data), blob.size, &_reflection[index]);
+    }
+
+    void CookedShader::Clear()
+    {
+        for (unsigned i = 0; i < static_cast<unsigned>(ShaderStage::Count); i++)
+        {
+            _code[i].clear();
+            _reflection[i] = ShaderReflection();
+        }
+    }
+
+    ShaderBlob CookedShader::GetStage(ShaderStage stage) const
+    {
+        const unsigned index = static_cast<unsigned>(stage);
+        ShaderBlob blob = {};
+        if (_code[index].empty())
+            return blob;
+
+        blob.size = _code[index].size();
+        blob.data = const_cast<uint8_t*>(_code[index].data());
+        blob.reflection = &_reflection[index];
+        return blob;
+    }
+
+    bool CookedShader::Save(Stream& dest, uint64_t sourceHash) const
+    {
+        uint32_t stageCount = 0;
+        for (unsigned i = 0; i < static_cast<unsigned>(ShaderStage::Count); i++)
+        {
+            if (!_code[i].empty())
+                ++stageCount;
+        }
+
+        CookedAssetWriter writer(dest);
+        bool success = writer.WriteHeader(CookedAssetType::Shader, sourceHash) && writer.Write(stageCount);
+        for (unsigned i = 0; i < static_cast<unsigned>(ShaderStage::Count) && success; i++)
+        {
+            if (_code[i].empty())
+                continue;
+
+            const ShaderReflection& reflection = _reflection[i];
+            CookedShaderStage stage;
+            stage.stage = i;
+            stage.inputMask = reflection.inputMask;
+            stage.outputMask = reflection.outputMask;
+            stage.resourceCount = static_cast<uint32_t>(reflection.resources.size());
+            stage.codeSize = _code[i].size();
+            success = writer.Write(stage);
+
+            for (const PipelineResource& resource : reflection.resources)
+            {
+                CookedShaderResource record;
+                record.stages = static_cast<uint32_t>(resource.stages);
+                record.resourceType = static_cast<uint32_t>(resource.resourceType);
+                record.dataType = static_cast<uint32_t>(resource.dataType);
+                record.access = static_cast<uint32_t>(resource.access);
+                record.set = resource.set;
+                record.binding = resource.binding;
+                record.location = resource.location;
+                record.vecSize = resource.vecSize;
+                record.arraySize = resource.arraySize;
+                record.offset = resource.offset;
+                record.size = resource.size;
+                record.nameLength = static_cast<uint32_t>(resource.name.length());
+                success = success && writer.Write(record) && writer.Write(resource.name.data(), resource.name.length());
+            }
+
+            success = success && writer.WriteData(_code[i].data(), _code[i].size());
+        }
+
+        return success;
+    }
+
+    bool CookedShader::Load(CookedAssetReader& reader)
+    {
+        Clear();
+
+        uint32_t stageCount;
+        if (!reader.ReadHeader(CookedAssetType::Shader) || !reader.Read(stageCount))
+            return false;
+
+        for (uint32_t s = 0; s < stageCount; ++s)
+        {
+            CookedShaderStage stage;
+            if (!reader.Read(stage) || stage.stage >= static_cast<uint32_t>(ShaderStage::Count))
+                return false;
+
+            ShaderReflection& reflection = _reflection[stage.stage];
+            reflection.stage = static_cast<ShaderStage>(stage.stage);
+            reflection.inputMask = stage.inputMask;
+            reflection.outputMask = stage.outputMask;
+
+            for (uint32_t r = 0; r < stage.resourceCount; ++r)
+            {
+                CookedShaderResource record;
+                if (!reader.Read(record))
+                    return false;
+
+                PipelineResource resource = {};
+                resource.stages = static_cast<ShaderStageUsage>(record.stages);
+                resource.resourceType = static_cast<ResourceParamType>(record.resourceType);
+                resource.dataType = static_cast<ParamDataType>(record.dataType);
+                resource.access = static_cast<ParamAccess>(record.access);
+                resource.set = record.set;
+                resource.binding = record.binding;
+                resource.location = record.location;
+                resource.vecSize = record.vecSize;
+                resource.arraySize = record.arraySize;
+                resource.offset = record.offset;
+                resource.size = record.size;
+
+                // Check before allocating, a corrupt length would otherwise allocate up to 4 GB.
+                if (record.nameLength > reader.GetRemaining())
+                    return false;
+
+                resource.name.resize(record.nameLength);
+                if (!reader.Read(&resource.name[0], record.nameLength))
+                    return false;
+
+                reflection.resources.push_back(resource);
+            }
+
+            const uint8_t* code = reader.ReadData(static_cast<size_t>(stage.codeSize));
+            if (!code || stage.codeSize == 0 || stage.codeSize % sizeof(uint32_t))
+                return false;
+
+            _code[stage.stage].assign(code, code + stage.codeSize);
+        }
+
+        return true;
+    }
+
     ShaderModule::ShaderModule(uint64_t hash, const ShaderBlob& blob)
         : _hash(hash)
     {
         _byteCode.assign(blob.data, blob.data + blob.size);
-        // Reflection all shader resouces.
-        SPIRVReflectResources(reinterpret_cast<const uint32_t*>(blob.data), blob.size, &_reflection);
+
+        // Reflection all shader resouces, unless reflected when cooked.
+        if (blob.reflection)
+            _reflection = *blob.reflection;
+        else
+            SPIRVReflectResources(reinterpret_cast<const uint32_t*>(blob.data), blob.size, &_reflection);
     }
 
     Shader::Shader(GraphicsDevice* device, const ShaderDescriptor* descriptor)
@@ -30,12 +30,17 @@
 
 namespace Alimer
 {
+    class CookedAssetReader;
+    class Stream;
+
     ALIMER_API void SPIRVReflectResources(const uint32_t* pCode, size_t size, ShaderReflection* reflection);
 
     struct ShaderBlob
     {
         uint64_t size;
         uint8_t *data;
+        /// Reflection of the code if known, otherwise reflected when the module is created.
+        const ShaderReflection* reflection = nullptr;
     };
 
     struct ShaderStageDescriptor
@@ -48,6 +53,35 @@ namespace Alimer
         ShaderBlob stages[static_cast<unsigned>(ShaderStage::Count)];
     };
 
+    /// Compiled shader stages with reflection, as stored in cooked shader files.
+    class ALIMER_API CookedShader
+    {
+    public:
+        /// Set stage SPIR-V code and reflect it.
+        void SetStage(ShaderStage stage, const ShaderBlob& blob);
+
+        /// Remove all stages.
+        void Clear();
+
+        /// Return whether the stage has code.
+        bool HasStage(ShaderStage stage) const { return !_code[static_cast<unsigned>(stage)].empty(); }
+
+        /// Return stage code with reflection, valid while the cooked shader exists.
+        ShaderBlob GetStage(ShaderStage stage) const;
+
+        /// Save as a cooked asset.
+        bool Save(Stream& dest, uint64_t sourceHash) const;
+
+        /// Load a cooked shader. Return false if the content is not a cooked shader.
+        bool Load(CookedAssetReader& reader);
+
+    private:
+        /// SPIR-V code per stage.
+        std::vector<uint8_t> _code[static_cast<unsigned>(ShaderStage::Count)];
+        /// Reflection per stage.
+        ShaderReflection _reflection[static_cast<unsigned>(ShaderStage::Count)];
+    };
+
     /// Defines a shader module - created by GraphicsDevice.
     class ALIMER_API ShaderModule final
     {
@@ -22,17 +22,22 @@
 
 #include "../Graphics/Types.h"
 #include "../Graphics/ShaderCompiler.h"
+#include "../Resource/DerivedDataCache.h"
 #include "../Resource/ResourceManager.h"
 #include "../IO/Path.h"
 #include "../Core/Log.h"
 #include "glslang/Public/ShaderLang.h"
 #include "glslang/StandAlone/ResourceLimits.h"
 #include "SPIRV/GlslangToSpv.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 namespace Alimer
 {
+    /// Version of the compilation rules. Part of the derived data cache key, so that changed rules compile everything again.
+    static constexpr uint32_t SHADER_COMPILER_VERSION = 1;
+
     class AlimerIncluder : public glslang::TShader::Includer
     {
     public:
@@ -76,7 +81,7 @@ namespace Alimer
         }
 
         void releaseInclude(IncludeResult* result) override {
-            delete (char*)result->userData;
+            delete[] static_cast<char*>(result->userData);
             delete result;
         }
     private:
@@ -166,6 +171,44 @@ namespace Alimer
         }
     }
 
+    void SplitShaderSections(const char* text, size_t length, String (&sources)[static_cast<unsigned>(ShaderStage::Count)])
+    {
+        for (String& source : sources)
+            source.Clear();
+
+        const char* textEnd = text + length;
+
+        static const char vertexMarker[] = "[vertex]";
+        static const char fragmentMarker[] = "[fragment]";
+        const char* vertex = std::search(text, textEnd, vertexMarker, vertexMarker + sizeof(vertexMarker) - 1);
+        const char* fragment = std::search(text, textEnd, fragmentMarker, fragmentMarker + sizeof(fragmentMarker) - 1);
+
+        // Text before the first section is shared by all stages.
+        String header;
+        if (text != textEnd && text[0] != '[')
+            header = String(text, static_cast<uint32_t>(std::min(vertex, fragment) - text));
+
+        auto addSection = [&](ShaderStage stage, const char* marker, size_t markerLength, const char* nextMarker) {
+            if (marker == textEnd)
+                return;
+
+            const char* sectionEnd = nextMarker > marker ? nextMarker : textEnd;
+            const char* sectionStart = marker + markerLength;
+            while (sectionStart < sectionEnd && (*sectionStart == '\r' || *sectionStart == '\n'))
+                sectionStart++;
+
+            const uint32_t line = static_cast<uint32_t>(std::count(text, sectionStart, '\n'));
+
+            String& source = sources[static_cast<unsigned>(stage)];
+            source = header;
+            source += String::Format("#line %u\n", line + 1);
+            source += String(sectionStart, static_cast<uint32_t>(sectionEnd - sectionStart));
+        };
+
+        addSection(ShaderStage::Vertex, vertex, sizeof(vertexMarker) - 1, fragment);
+        addSection(ShaderStage::Fragment, fragment, sizeof(fragmentMarker) - 1, vertex);
+    }
+
     ShaderBlob ShaderCompiler::Compile(
         const char* filePath,
         const char* entryPoint,
@@ -256,25 +299,25 @@ namespace Alimer
         const String preamble = macroDefinitions + poundExtension;
 
         EShLanguage eshLanguage = MapShaderStage(stage);
-        glslang::TShader shader(eshLanguage);
-
         const char* shaderStrings = source;
         const int shaderLengths = static_cast<int>(strlen(source));
         const char* stringNames = filePath && strlen(filePath) ? filePath : "unknown";
-        shader.setStringsWithLengthsAndNames(
-            &shaderStrings,
-            &shaderLengths,
-            &stringNames, 1);
-        shader.setPreamble(preamble.CString());
-        shader.setEntryPoint(entryPoint);
-        shader.setSourceEntryPoint(entryPoint);
-        shader.setShiftSamplerBinding(0);
-        shader.setShiftTextureBinding(0);
-        shader.setShiftImageBinding(0);
-        shader.setShiftUboBinding(0);
-        shader.setShiftSsboBinding(0);
-        shader.setFlattenUniformArrays(false);
-        shader.setNoStorageFormat(false);
+        auto setupShader = [&](glslang::TShader& shader) {
+            shader.setStringsWithLengthsAndNames(
+                &shaderStrings,
+                &shaderLengths,
+                &stringNames, 1);
+            shader.setPreamble(preamble.CString());
+            shader.setEntryPoint(entryPoint);
+            shader.setSourceEntryPoint(entryPoint);
+            shader.setShiftSamplerBinding(0);
+            shader.setShiftTextureBinding(0);
+            shader.setShiftImageBinding(0);
+            shader.setShiftUboBinding(0);
+            shader.setShiftSsboBinding(0);
+            shader.setFlattenUniformArrays(false);
+            shader.setNoStorageFormat(false);
+        };
 
         // Set message options.
         int options = EOptionSpv | EOptionVulkanRules | EOptionLinkProgram;
@@ -287,6 +330,51 @@ namespace Alimer
         const bool ForceVersionProfile = false;
         const bool NotForwardCompatible = false;
 
+        // Look up the derived data cache by the preprocessed source, which covers included files and defines.
+        DerivedDataCache& cache = DerivedDataCache::Get();
+        uint64_t cacheKey = 0;
+        if (cache.IsEnabled())
+        {
+            glslang::TShader preprocessShader(eshLanguage);
+            setupShader(preprocessShader);
+
+            std::string preprocessed;
+            if (preprocessShader.preprocess(
+                &resourceLimits,
+                450,
+                DefaultProfile,
+                ForceVersionProfile,
+                NotForwardCompatible,
+                messages,
+                &preprocessed,
+                includer))
+            {
+                Hasher hasher;
+                hasher.String("ShaderCompiler");
+                hasher.UInt32(SHADER_COMPILER_VERSION);
+                hasher.UInt32(static_cast<uint32_t>(language));
+                hasher.UInt32(static_cast<uint32_t>(stage));
+                hasher.UInt32(static_cast<uint32_t>(options));
+                hasher.String(entryPoint);
+                hasher.String(preamble.CString());
+                hasher.String(preprocessed);
+                cacheKey = hasher.GetValue();
+
+                std::vector<uint8_t> data;
+                if (cache.Get(cacheKey, data) && !data.empty())
+                {
+                    ShaderBlob blob = {};
+                    blob.size = data.size();
+                    blob.data = new uint8_t[blob.size];
+                    memcpy(blob.data, data.data(), blob.size);
+                    return blob;
+                }
+            }
+        }
+
+        glslang::TShader shader(eshLanguage);
+        setupShader(shader);
+
         bool parseSuccess = shader.parse(
             &resourceLimits,
             450,
@@ -351,6 +439,9 @@ namespace Alimer
                 blob.size = spirv.size() * sizeof(uint32_t);
                 blob.data = new uint8_t[blob.size];
                 memcpy(blob.data, spirv.data(), blob.size);
+
+                if (cacheKey)
+                    cache.Put(cacheKey, blob.data, blob.size);
             }
         }
 
@@ -37,6 +37,9 @@ namespace Alimer
         HLSL
     };
 
+    /// Split a shader file into the sources of its [vertex] and [fragment] sections. Text before the first section is shared by all stages.
+    ALIMER_API void SplitShaderSections(const char* text, size_t length, String (&sources)[static_cast<unsigned>(ShaderStage::Count)]);
+
 	/// Class for shader compilation support.
 	class ALIMER_API ShaderCompiler final
 	{
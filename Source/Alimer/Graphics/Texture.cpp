@@ -35,7 +35,7 @@ namespace Alimer
         _width = descriptor->width;
         _height = descriptor->height;
         _depth = descriptor->depth;
-        _mipLevels = descriptor->depth;
+        _mipLevels = descriptor->mipLevels;
         _arrayLayers = descriptor->arrayLayers;
         _samples = descriptor->samples;
     }
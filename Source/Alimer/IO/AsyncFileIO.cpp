@@ -0,0 +1,697 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/AsyncFileIO.h"
+#include "../Core/Platform.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#if !ALIMER_PLATFORM_WINDOWS && !ALIMER_PLATFORM_UWP
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       define ALIMER_IO_URING 1
+#       include <linux/io_uring.h>
+#       include <sys/mman.h>
+#       include <sys/syscall.h>
+#       include <sys/uio.h>
+#       include <sys/eventfd.h>
+#       include <poll.h>
+#       include <errno.h>
+#   endif
+#endif
+
+namespace Alimer
+{
+    /// Blocking read of a file range.
+    static bool ReadFileRange(const String& fileName, uint64_t offset, uint64_t size, std::vector<uint8_t>& data)
+    {
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        HANDLE handle = CreateFileW(WString(fileName).CString(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(handle, &fileSize))
+        {
+            CloseHandle(handle);
+            return false;
+        }
+
+        const uint64_t available = static_cast<uint64_t>(fileSize.QuadPart) > offset ? static_cast<uint64_t>(fileSize.QuadPart) - offset : 0;
+        size = (size == 0 || size > available) ? available : size;
+        data.resize(static_cast<size_t>(size));
+
+        uint64_t done = 0;
+        while (done < size)
+        {
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(offset + done);
+            overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+
+            const DWORD chunk = static_cast<DWORD>(std::min<uint64_t>(size - done, 1u << 30));
+            DWORD bytesRead = 0;
+            if (!ReadFile(handle, data.data() + done, chunk, &bytesRead, &overlapped) || bytesRead == 0)
+                break;
+
+            done += bytesRead;
+        }
+
+        CloseHandle(handle);
+#else
+        int fd = open(fileName.CString(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+        const uint64_t available = fileSize > offset ? fileSize - offset : 0;
+        size = (size == 0 || size > available) ? available : size;
+        data.resize(static_cast<size_t>(size));
+
+        uint64_t done = 0;
+        while (done < size)
+        {
+            ssize_t result = pread(fd, data.data() + done, static_cast<size_t>(size - done), static_cast<off_t>(offset + done));
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            if (result <= 0)
+                break;
+
+            done += static_cast<uint64_t>(result);
+        }
+
+        close(fd);
+#endif
+
+        data.resize(static_cast<size_t>(done));
+        return true;
+    }
+
+    /// Backend base managing the prioritized pending queue.
+    class AsyncFileIOBackend
+    {
+    public:
+        virtual ~AsyncFileIOBackend() = default;
+
+        virtual const char* GetName() const = 0;
+
+        void Submit(std::vector<AsyncReadRequest>& requests)
+        {
+            if (requests.empty())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (AsyncReadRequest& request : requests)
+                {
+                    _queues[static_cast<uint32_t>(request.priority)].push_back(std::move(request));
+                }
+
+                _pendingCount += static_cast<uint32_t>(requests.size());
+            }
+
+            requests.clear();
+            Wake();
+        }
+
+        void WaitIdle()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idleCondition.wait(lock, [this]() { return _pendingCount == 0; });
+        }
+
+    protected:
+        /// Notify I/O threads of new requests or shutdown.
+        virtual void Wake() = 0;
+
+        /// Pop highest priority request, mutex must be held.
+        bool PopRequest(AsyncReadRequest& request)
+        {
+            for (auto& queue : _queues)
+            {
+                if (!queue.empty())
+                {
+                    request = std::move(queue.front());
+                    queue.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /// Read the request with a blocking read on the calling thread and complete it, mutex must not be held.
+        void ReadAndComplete(AsyncReadRequest& request)
+        {
+            AsyncReadResult result;
+            result.fileName = request.fileName;
+            result.offset = request.offset;
+            result.success = ReadFileRange(request.fileName, request.offset, request.size, result.data);
+            Complete(request, result);
+        }
+
+        /// Invoke callback and mark request as completed, mutex must not be held.
+        void Complete(AsyncReadRequest& request, AsyncReadResult& result)
+        {
+            if (request.callback)
+            {
+                request.callback(result);
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_pendingCount == 0)
+            {
+                _idleCondition.notify_all();
+            }
+        }
+
+        void SetShutdown()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _shutdown = true;
+            }
+
+            Wake();
+        }
+
+        std::mutex _mutex;
+        std::deque<AsyncReadRequest> _queues[static_cast<uint32_t>(WorkPriority::Count)];
+        std::condition_variable _idleCondition;
+        uint32_t _pendingCount = 0;
+        bool _shutdown = false;
+    };
+
+    /// Backend issuing blocking reads from dedicated I/O threads.
+    class ThreadAsyncFileIOBackend final : public AsyncFileIOBackend
+    {
+    public:
+        ThreadAsyncFileIOBackend(uint32_t numThreads)
+        {
+            numThreads = numThreads ? numThreads : 1;
+            for (uint32_t i = 0; i < numThreads; ++i)
+            {
+                _threads.emplace_back(&ThreadAsyncFileIOBackend::IOThread, this);
+            }
+        }
+
+        ~ThreadAsyncFileIOBackend() override
+        {
+            SetShutdown();
+            for (std::thread& thread : _threads)
+            {
+                thread.join();
+            }
+        }
+
+        const char* GetName() const override { return "Threads"; }
+
+    private:
+        void Wake() override
+        {
+            _requestCondition.notify_all();
+        }
+
+        void IOThread()
+        {
+            SetCurrentThreadName("AsyncIO");
+
+            for (;;)
+            {
+                AsyncReadRequest request;
+                {
+                    bool hasRequest = false;
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _requestCondition.wait(lock, [this, &request, &hasRequest]() {
+                        hasRequest = PopRequest(request);
+                        return hasRequest || _shutdown;
+                    });
+
+                    if (!hasRequest)
+                        break;
+                }
+
+                ReadAndComplete(request);
+            }
+        }
+
+        std::vector<std::thread> _threads;
+        std::condition_variable _requestCondition;
+    };
+
+#ifdef ALIMER_IO_URING
+    /// Linux io_uring backend, one thread keeps the ring filled and reaps completions.
+    class IoUringAsyncFileIOBackend final : public AsyncFileIOBackend
+    {
+    public:
+        static constexpr uint32_t QueueDepth = 64;
+        /// Reads larger than this are split, the kernel caps a single read below 2 GB.
+        static constexpr uint64_t MaxReadSize = 1u << 30;
+        /// User data of the wakeup poll, slots use index + 1.
+        static constexpr uint64_t WakeupUserData = 0;
+
+        IoUringAsyncFileIOBackend() = default;
+
+        ~IoUringAsyncFileIOBackend() override
+        {
+            if (_thread.joinable())
+            {
+                SetShutdown();
+                _thread.join();
+            }
+
+            if (_sqes)
+                munmap(_sqes, _sqesSize);
+            if (_cqRing)
+                munmap(_cqRing, _cqRingSize);
+            if (_sqRing)
+                munmap(_sqRing, _sqRingSize);
+            if (_ringFd >= 0)
+                close(_ringFd);
+            if (_wakeupFd >= 0)
+                close(_wakeupFd);
+        }
+
+        bool Initialize()
+        {
+            io_uring_params params = {};
+            _ringFd = static_cast<int>(syscall(__NR_io_uring_setup, QueueDepth, &params));
+            if (_ringFd < 0)
+                return false;
+
+            _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+            _sqRing = MapRing(_sqRingSize, IORING_OFF_SQ_RING);
+            _cqRing = MapRing(_cqRingSize, IORING_OFF_CQ_RING);
+            _sqes = static_cast<io_uring_sqe*>(MapRing(_sqesSize, IORING_OFF_SQES));
+            if (!_sqRing || !_cqRing || !_sqes)
+                return false;
+
+            uint8_t* sq = static_cast<uint8_t*>(_sqRing);
+            _sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+            _sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+            _sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+            uint8_t* cq = static_cast<uint8_t*>(_cqRing);
+            _cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+            _cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+            _cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+            _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // Slots are limited so that the wakeup poll always fits in the submission queue.
+            _slots.resize(params.sq_entries - 1);
+
+            _wakeupFd = eventfd(0, EFD_CLOEXEC);
+            if (_wakeupFd < 0)
+                return false;
+
+            _thread = std::thread(&IoUringAsyncFileIOBackend::IOThread, this);
+            return true;
+        }
+
+        const char* GetName() const override { return _ringFailed ? "Threads" : "io_uring"; }
+
+    private:
+        struct Slot
+        {
+            AsyncReadRequest request;
+            AsyncReadResult result;
+            int fd = -1;
+            iovec iov = {};
+            uint64_t size = 0;
+            uint64_t done = 0;
+            bool used = false;
+        };
+
+        void* MapRing(size_t size, off_t offset)
+        {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, offset);
+            return ptr == MAP_FAILED ? nullptr : ptr;
+        }
+
+        void Wake() override
+        {
+            uint64_t value = 1;
+            ALIMER_UNUSED(write(_wakeupFd, &value, sizeof(value)));
+        }
+
+        io_uring_sqe* GetSqe()
+        {
+            // Only this thread produces, tail can be read plainly and published with release.
+            const uint32_t tail = *_sqTail;
+            const uint32_t index = tail & _sqMask;
+            io_uring_sqe* sqe = &_sqes[index];
+            memset(sqe, 0, sizeof(io_uring_sqe));
+            _sqArray[index] = index;
+            __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+            _toSubmit++;
+            return sqe;
+        }
+
+        void ArmWakeup()
+        {
+            io_uring_sqe* sqe = GetSqe();
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = _wakeupFd;
+            sqe->poll_events = POLLIN;
+            sqe->user_data = WakeupUserData;
+        }
+
+        void SubmitRead(uint32_t slotIndex)
+        {
+            Slot& slot = _slots[slotIndex];
+            const uint64_t remaining = slot.size - slot.done;
+            slot.iov.iov_base = slot.result.data.data() + slot.done;
+            slot.iov.iov_len = static_cast<size_t>(remaining < MaxReadSize ? remaining : MaxReadSize);
+
+            io_uring_sqe* sqe = GetSqe();
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = slot.fd;
+            sqe->off = slot.request.offset + slot.done;
+            sqe->addr = reinterpret_cast<uint64_t>(&slot.iov);
+            sqe->len = 1;
+            sqe->user_data = slotIndex + 1;
+        }
+
+        /// Open file and start reading, return false if request completed immediately.
+        bool StartRequest(uint32_t slotIndex)
+        {
+            Slot& slot = _slots[slotIndex];
+            slot.result.fileName = slot.request.fileName;
+            slot.result.offset = slot.request.offset;
+            slot.done = 0;
+
+            slot.fd = open(slot.request.fileName.CString(), O_RDONLY | O_CLOEXEC);
+            struct stat st;
+            if (slot.fd < 0
+                || fstat(slot.fd, &st) != 0)
+            {
+                return false;
+            }
+
+            const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+            const uint64_t available = fileSize > slot.request.offset ? fileSize - slot.request.offset : 0;
+            slot.size = (slot.request.size == 0 || slot.request.size > available) ? available : slot.request.size;
+            slot.result.data.resize(static_cast<size_t>(slot.size));
+            if (slot.size == 0)
+            {
+                slot.result.success = true;
+                return false;
+            }
+
+            SubmitRead(slotIndex);
+            return true;
+        }
+
+        void FinishRequest(uint32_t slotIndex)
+        {
+            Slot& slot = _slots[slotIndex];
+            if (slot.fd >= 0)
+            {
+                close(slot.fd);
+                slot.fd = -1;
+            }
+
+            slot.result.data.resize(static_cast<size_t>(slot.done));
+            Complete(slot.request, slot.result);
+
+            slot.request = {};
+            slot.result = {};
+            slot.used = false;
+            _inFlight--;
+        }
+
+        void ProcessCompletion(const io_uring_cqe& cqe)
+        {
+            if (cqe.user_data == WakeupUserData)
+            {
+                uint64_t value;
+                ALIMER_UNUSED(read(_wakeupFd, &value, sizeof(value)));
+                _wakeupArmed = false;
+                return;
+            }
+
+            const uint32_t slotIndex = static_cast<uint32_t>(cqe.user_data - 1);
+            Slot& slot = _slots[slotIndex];
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+            {
+                SubmitRead(slotIndex);
+                return;
+            }
+
+            if (cqe.res < 0)
+            {
+                slot.result.success = false;
+                FinishRequest(slotIndex);
+                return;
+            }
+
+            slot.done += static_cast<uint64_t>(cqe.res);
+            if (cqe.res > 0 && slot.done < slot.size)
+            {
+                // Short read, continue with the remaining range.
+                SubmitRead(slotIndex);
+                return;
+            }
+
+            slot.result.success = true;
+            FinishRequest(slotIndex);
+        }
+
+        /// Complete the requests in the ring as failed once the ring is no longer usable.
+        void FailInFlight()
+        {
+            for (uint32_t i = 0; i < _slots.size(); ++i)
+            {
+                if (!_slots[i].used)
+                    continue;
+
+                _slots[i].result.success = false;
+                FinishRequest(i);
+            }
+
+            _toSubmit = 0;
+            _ringFailed = true;
+        }
+
+        /// Serve the remaining and later requests one at a time, woken by the blocking eventfd instead of the ring.
+        void ReadBlocking()
+        {
+            for (;;)
+            {
+                AsyncReadRequest request;
+                bool hasRequest;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    hasRequest = PopRequest(request);
+                    if (!hasRequest && _shutdown)
+                        break;
+                }
+
+                if (hasRequest)
+                {
+                    ReadAndComplete(request);
+                }
+                else
+                {
+                    uint64_t value;
+                    ALIMER_UNUSED(read(_wakeupFd, &value, sizeof(value)));
+                }
+            }
+        }
+
+        void IOThread()
+        {
+            SetCurrentThreadName("AsyncIO");
+
+            for (;;)
+            {
+                if (!_wakeupArmed)
+                {
+                    ArmWakeup();
+                    _wakeupArmed = true;
+                }
+
+                // Fill free slots in priority order, all of them are submitted with a single system call.
+                std::vector<uint32_t> immediate;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_shutdown && _inFlight == 0 && _pendingCount == 0)
+                        break;
+
+                    for (uint32_t i = 0; i < _slots.size() && _inFlight < _slots.size(); ++i)
+                    {
+                        if (_slots[i].used)
+                            continue;
+
+                        if (!PopRequest(_slots[i].request))
+                            break;
+
+                        _slots[i].used = true;
+                        _inFlight++;
+                        immediate.push_back(i);
+                    }
+                }
+
+                for (uint32_t slotIndex : immediate)
+                {
+                    if (!StartRequest(slotIndex))
+                    {
+                        FinishRequest(slotIndex);
+                    }
+                }
+
+                int result = static_cast<int>(syscall(__NR_io_uring_enter, _ringFd, _toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+                if (result >= 0)
+                {
+                    _toSubmit -= static_cast<uint32_t>(result);
+                }
+                else if (errno != EINTR && errno != EBUSY && errno != EAGAIN)
+                {
+                    ALIMER_LOGERRORF("io_uring_enter failed with error %d, falling back to blocking reads", errno);
+                    FailInFlight();
+                    ReadBlocking();
+                    return;
+                }
+
+                uint32_t head = *_cqHead;
+                while (head != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+                {
+                    const io_uring_cqe cqe = _cqes[head & _cqMask];
+                    head++;
+                    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+                    ProcessCompletion(cqe);
+                }
+            }
+        }
+
+        int _ringFd = -1;
+        int _wakeupFd = -1;
+        void* _sqRing = nullptr;
+        void* _cqRing = nullptr;
+        io_uring_sqe* _sqes = nullptr;
+        size_t _sqRingSize = 0;
+        size_t _cqRingSize = 0;
+        size_t _sqesSize = 0;
+        uint32_t* _sqTail = nullptr;
+        uint32_t* _sqArray = nullptr;
+        uint32_t _sqMask = 0;
+        uint32_t* _cqHead = nullptr;
+        uint32_t* _cqTail = nullptr;
+        uint32_t _cqMask = 0;
+        io_uring_cqe* _cqes = nullptr;
+
+        std::vector<Slot> _slots;
+        uint32_t _inFlight = 0;
+        uint32_t _toSubmit = 0;
+        bool _wakeupArmed = false;
+        /// Set when the ring failed and requests are read with blocking reads.
+        std::atomic<bool> _ringFailed{ false };
+        std::thread _thread;
+    };
+#endif
+
+    AsyncFileIO::AsyncFileIO(uint32_t numThreads)
+    {
+#ifdef ALIMER_IO_URING
+        UniquePtr<IoUringAsyncFileIOBackend> ioUring(new IoUringAsyncFileIOBackend());
+        if (ioUring->Initialize())
+        {
+            _backend.Reset(ioUring.Detach());
+        }
+        else
+        {
+            ALIMER_LOGDEBUG("io_uring not available, using I/O threads");
+        }
+#endif
+
+        if (!_backend)
+        {
+            _backend.Reset(new ThreadAsyncFileIOBackend(numThreads));
+        }
+    }
+
+    AsyncFileIO::~AsyncFileIO()
+    {
+        _backend.Reset();
+    }
+
+    void AsyncFileIO::Submit(AsyncReadRequest request)
+    {
+        std::vector<AsyncReadRequest> requests;
+        requests.push_back(std::move(request));
+        _backend->Submit(requests);
+    }
+
+    void AsyncFileIO::Submit(std::vector<AsyncReadRequest>& requests)
+    {
+        _backend->Submit(requests);
+    }
+
+    std::future<AsyncReadResult> AsyncFileIO::Read(const String& fileName, uint64_t offset, uint64_t size, WorkPriority priority)
+    {
+        auto promise = std::make_shared<std::promise<AsyncReadResult>>();
+        std::future<AsyncReadResult> future = promise->get_future();
+
+        AsyncReadRequest request;
+        request.fileName = fileName;
+        request.offset = offset;
+        request.size = size;
+        request.priority = priority;
+        request.callback = [promise](AsyncReadResult& result) {
+            promise->set_value(std::move(result));
+        };
+
+        Submit(std::move(request));
+        return future;
+    }
+
+    void AsyncFileIO::WaitIdle()
+    {
+        _backend->WaitIdle();
+    }
+
+    const char* AsyncFileIO::GetBackendName() const
+    {
+        return _backend->GetName();
+    }
+}
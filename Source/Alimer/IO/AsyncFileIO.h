@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/String.h"
+#include "../Core/Ptr.h"
+#include "../Core/WorkQueue.h"
+#include <vector>
+#include <functional>
+#include <future>
+
+namespace Alimer
+{
+    /// Result of an asynchronous file read.
+    struct AsyncReadResult
+    {
+        /// Native file name.
+        String fileName;
+        /// Offset of the read in bytes.
+        uint64_t offset = 0;
+        /// Data read, shorter than requested when end of file was reached.
+        std::vector<uint8_t> data;
+        /// Whether the file could be opened and read.
+        bool success = false;
+    };
+
+    /// Callback invoked on an I/O thread when a read completes.
+    using AsyncReadCallback = std::function<void(AsyncReadResult& result)>;
+
+    /// Asynchronous file read request.
+    struct AsyncReadRequest
+    {
+        /// Native file name.
+        String fileName;
+        /// Offset of the read in bytes.
+        uint64_t offset = 0;
+        /// Number of bytes to read, 0 to read until end of file.
+        uint64_t size = 0;
+        /// Pending requests of higher priority are issued first.
+        WorkPriority priority = WorkPriority::Normal;
+        AsyncReadCallback callback;
+    };
+
+    class AsyncFileIOBackend;
+
+    /// Asynchronous file reads, using io_uring on Linux when available and dedicated I/O threads otherwise.
+    class ALIMER_API AsyncFileIO final
+    {
+    public:
+        /// Constructor. Number of threads is used by the thread backend.
+        AsyncFileIO(uint32_t numThreads = 2);
+
+        /// Destructor. Complete all pending requests.
+        ~AsyncFileIO();
+
+        /// Submit a read request.
+        void Submit(AsyncReadRequest request);
+
+        /// Submit multiple read requests at once, requests are moved from.
+        void Submit(std::vector<AsyncReadRequest>& requests);
+
+        /// Read file range and return future of the result.
+        std::future<AsyncReadResult> Read(const String& fileName, uint64_t offset, uint64_t size, WorkPriority priority = WorkPriority::Normal);
+
+        /// Wait until all submitted requests have completed.
+        void WaitIdle();
+
+        /// Return name of the backend in use.
+        const char* GetBackendName() const;
+
+    private:
+        UniquePtr<AsyncFileIOBackend> _backend;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(AsyncFileIO);
+    };
+}
@@ -0,0 +1,378 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/CompressedStream.h"
+#include "../IO/Compression.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Alimer
+{
+    /// Compressed stream magic, "ACMP".
+    static constexpr uint32_t COMPRESSED_STREAM_MAGIC = 0x504D4341;
+    static constexpr uint32_t COMPRESSED_STREAM_VERSION = 1;
+    static constexpr size_t NO_BLOCK = ~static_cast<size_t>(0);
+
+    struct CompressedStreamHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t blockSize;
+        uint32_t reserved;
+    };
+
+    /// Stored after the block index at the end of the stream.
+    struct CompressedStreamFooter
+    {
+        uint64_t uncompressedSize;
+        uint64_t indexOffset;
+        uint32_t blockCount;
+        uint32_t magic;
+    };
+
+    static_assert(sizeof(CompressedBlockInfo) == 16, "Invalid CompressedBlockInfo size");
+
+    CompressedStream::CompressedStream(Stream* source)
+        : _source(source)
+        , _blockSize(0)
+        , _currentBlock(NO_BLOCK)
+        , _valid(false)
+    {
+        _valid = ReadIndex();
+    }
+
+    CompressedStream::CompressedStream(UniquePtr<Stream> source)
+        : _ownedSource(std::move(source))
+        , _source(_ownedSource.Get())
+        , _blockSize(0)
+        , _currentBlock(NO_BLOCK)
+        , _valid(false)
+    {
+        _valid = ReadIndex();
+    }
+
+    bool CompressedStream::ReadIndex()
+    {
+        if (!_source || !_source->CanSeek())
+            return false;
+
+        SetName(_source->GetName());
+
+        CompressedStreamHeader header;
+        CompressedStreamFooter footer;
+        const size_t sourceSize = _source->GetSize();
+        if (sourceSize < sizeof(header) + sizeof(footer)
+            || !_source->Seek(0)
+            || _source->Read(&header, sizeof(header)) != sizeof(header)
+            || !_source->Seek(sourceSize - sizeof(footer))
+            || _source->Read(&footer, sizeof(footer)) != sizeof(footer)
+            || header.magic != COMPRESSED_STREAM_MAGIC
+            || footer.magic != COMPRESSED_STREAM_MAGIC)
+        {
+            ALIMER_LOGERRORF("'%s' is not a compressed stream", _name.CString());
+            return false;
+        }
+
+        const uint64_t indexSize = static_cast<uint64_t>(footer.blockCount) * sizeof(CompressedBlockInfo);
+        const uint64_t expectedBlocks = header.blockSize ? (footer.uncompressedSize + header.blockSize - 1) / header.blockSize : 0;
+        if (header.version != COMPRESSED_STREAM_VERSION
+            || !header.blockSize
+            || header.blockSize > COMPRESSED_STREAM_MAX_BLOCK_SIZE
+            || footer.blockCount != expectedBlocks
+            || footer.indexOffset > sourceSize - sizeof(footer)
+            || indexSize != sourceSize - sizeof(footer) - footer.indexOffset)
+        {
+            ALIMER_LOGERRORF("Compressed stream '%s' has corrupted block index", _name.CString());
+            return false;
+        }
+
+        _blocks.resize(footer.blockCount);
+        if (!_source->Seek(static_cast<size_t>(footer.indexOffset))
+            || _source->Read(_blocks.data(), static_cast<size_t>(indexSize)) != indexSize)
+        {
+            _blocks.clear();
+            return false;
+        }
+
+        const size_t maxCompressedSize = GetCompressBound(header.blockSize);
+        for (const CompressedBlockInfo& block : _blocks)
+        {
+            if (block.offset > footer.indexOffset
+                || block.compressedSize > footer.indexOffset - block.offset
+                || block.compressedSize > maxCompressedSize)
+            {
+                ALIMER_LOGERRORF("Compressed stream '%s' has corrupted block index", _name.CString());
+                _blocks.clear();
+                return false;
+            }
+        }
+
+        _blockSize = header.blockSize;
+        _size = static_cast<size_t>(footer.uncompressedSize);
+        _position = 0;
+        return true;
+    }
+
+    bool CompressedStream::LoadBlock(size_t index)
+    {
+        if (index == _currentBlock)
+            return true;
+
+        _currentBlock = NO_BLOCK;
+        const CompressedBlockInfo& block = _blocks[index];
+        const size_t blockStart = index * _blockSize;
+        const size_t blockLength = std::min(static_cast<size_t>(_blockSize), _size - blockStart);
+        _blockData.resize(blockLength);
+
+        if (!_source->Seek(static_cast<size_t>(block.offset)))
+            return false;
+
+        if (block.stored)
+        {
+            if (block.compressedSize != blockLength
+                || _source->Read(_blockData.data(), blockLength) != blockLength)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            _compressedData.resize(block.compressedSize);
+            if (_source->Read(_compressedData.data(), block.compressedSize) != block.compressedSize
+                || DecompressLZ4(_compressedData.data(), block.compressedSize, _blockData.data(), blockLength) != blockLength)
+            {
+                ALIMER_LOGERRORF("Failed to decompress block %u of '%s'", static_cast<uint32_t>(index), _name.CString());
+                return false;
+            }
+        }
+
+        _currentBlock = index;
+        return true;
+    }
+
+    bool CompressedStream::CanRead() const
+    {
+        return _valid;
+    }
+
+    bool CompressedStream::CanWrite() const
+    {
+        return false;
+    }
+
+    bool CompressedStream::CanSeek() const
+    {
+        return _valid;
+    }
+
+    size_t CompressedStream::Read(void* dest, size_t size)
+    {
+        if (!_valid)
+            return 0;
+
+        if (size > _size - _position)
+            size = _size - _position;
+
+        uint8_t* destPtr = static_cast<uint8_t*>(dest);
+        size_t totalRead = 0;
+        while (totalRead < size)
+        {
+            const size_t blockIndex = _position / _blockSize;
+            const size_t blockOffset = _position % _blockSize;
+            if (!LoadBlock(blockIndex))
+                break;
+
+            const size_t count = std::min(size - totalRead, _blockData.size() - blockOffset);
+            memcpy(destPtr + totalRead, _blockData.data() + blockOffset, count);
+            totalRead += count;
+            _position += count;
+        }
+
+        return totalRead;
+    }
+
+    size_t CompressedStream::Write(const void* data, size_t size)
+    {
+        ALIMER_UNUSED(data);
+        ALIMER_UNUSED(size);
+        return 0;
+    }
+
+    bool CompressedStream::Seek(size_t position)
+    {
+        if (!_valid || position > _size)
+            return false;
+
+        _position = position;
+        return true;
+    }
+
+    CompressedStreamWriter::CompressedStreamWriter(Stream* dest, uint32_t blockSize, CompressionLevel level)
+        : _dest(dest)
+        , _blockSize(blockSize)
+        , _level(level)
+        , _compressedSize(0)
+        , _failed(false)
+        , _finished(false)
+    {
+        WriteHeader();
+    }
+
+    CompressedStreamWriter::CompressedStreamWriter(UniquePtr<Stream> dest, uint32_t blockSize, CompressionLevel level)
+        : _ownedDest(std::move(dest))
+        , _dest(_ownedDest.Get())
+        , _blockSize(blockSize)
+        , _level(level)
+        , _compressedSize(0)
+        , _failed(false)
+        , _finished(false)
+    {
+        WriteHeader();
+    }
+
+    CompressedStreamWriter::~CompressedStreamWriter()
+    {
+        Finish();
+    }
+
+    void CompressedStreamWriter::WriteHeader()
+    {
+        if (!_dest || !_dest->CanWrite() || !_blockSize || _blockSize > COMPRESSED_STREAM_MAX_BLOCK_SIZE)
+        {
+            _failed = true;
+            return;
+        }
+
+        SetName(_dest->GetName());
+        _blockData.reserve(_blockSize);
+        _compressedData.resize(GetCompressBound(_blockSize));
+
+        CompressedStreamHeader header = { COMPRESSED_STREAM_MAGIC, COMPRESSED_STREAM_VERSION, _blockSize, 0 };
+        if (_dest->Write(&header, sizeof(header)) != sizeof(header))
+            _failed = true;
+        _compressedSize = sizeof(header);
+    }
+
+    bool CompressedStreamWriter::FlushBlock()
+    {
+        if (_blockData.empty())
+            return true;
+
+        const size_t blockLength = _blockData.size();
+        size_t compressedLength = CompressLZ4(_blockData.data(), blockLength, _compressedData.data(), _compressedData.size(), _level);
+
+        // Store incompressible blocks as is.
+        CompressedBlockInfo block = { _compressedSize, 0, 0 };
+        const uint8_t* blockData = _compressedData.data();
+        if (!compressedLength || compressedLength >= blockLength)
+        {
+            compressedLength = blockLength;
+            blockData = _blockData.data();
+            block.stored = 1;
+        }
+
+        block.compressedSize = static_cast<uint32_t>(compressedLength);
+        if (_dest->Write(blockData, compressedLength) != compressedLength)
+        {
+            _failed = true;
+            return false;
+        }
+
+        _compressedSize += compressedLength;
+        _blocks.push_back(block);
+        _blockData.clear();
+        return true;
+    }
+
+    bool CompressedStreamWriter::Finish()
+    {
+        if (_finished)
+            return !_failed;
+
+        _finished = true;
+        if (_failed || !FlushBlock())
+            return false;
+
+        CompressedStreamFooter footer = { _size, _compressedSize, static_cast<uint32_t>(_blocks.size()), COMPRESSED_STREAM_MAGIC };
+        const size_t indexSize = _blocks.size() * sizeof(CompressedBlockInfo);
+        if (_dest->Write(_blocks.data(), indexSize) != indexSize
+            || _dest->Write(&footer, sizeof(footer)) != sizeof(footer))
+        {
+            _failed = true;
+            return false;
+        }
+
+        _compressedSize += indexSize + sizeof(footer);
+        return true;
+    }
+
+    bool CompressedStreamWriter::CanRead() const
+    {
+        return false;
+    }
+
+    bool CompressedStreamWriter::CanWrite() const
+    {
+        return !_finished && !_failed;
+    }
+
+    bool CompressedStreamWriter::CanSeek() const
+    {
+        return false;
+    }
+
+    size_t CompressedStreamWriter::Read(void* dest, size_t size)
+    {
+        ALIMER_UNUSED(dest);
+        ALIMER_UNUSED(size);
+        return 0;
+    }
+
+    size_t CompressedStreamWriter::Write(const void* data, size_t size)
+    {
+        if (!CanWrite())
+            return 0;
+
+        const uint8_t* srcPtr = static_cast<const uint8_t*>(data);
+        size_t written = 0;
+        while (written < size)
+        {
+            const size_t count = std::min(size - written, _blockSize - _blockData.size());
+            _blockData.insert(_blockData.end(), srcPtr + written, srcPtr + written + count);
+            written += count;
+            _position += count;
+            _size += count;
+
+            if (_blockData.size() == _blockSize && !FlushBlock())
+                return written;
+        }
+
+        return written;
+    }
+
+    bool CompressedStreamWriter::Seek(size_t position)
+    {
+        // Only seeking to the current position is supported.
+        return position == _position;
+    }
+}
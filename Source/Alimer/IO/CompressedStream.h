@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/Stream.h"
+#include "../IO/Compression.h"
+#include "../Core/Ptr.h"
+
+namespace Alimer
+{
+    /// Default uncompressed block size of compressed streams.
+    static constexpr uint32_t COMPRESSED_STREAM_DEFAULT_BLOCK_SIZE = 64 * 1024;
+    /// Largest uncompressed block size of compressed streams, bounds the block buffers of corrupt streams.
+    static constexpr uint32_t COMPRESSED_STREAM_MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+    /// Block index entry of a compressed stream.
+    struct CompressedBlockInfo
+    {
+        /// Offset of block data in the compressed stream.
+        uint64_t offset;
+        /// Size of stored block data.
+        uint32_t compressedSize;
+        /// Nonzero if the block is stored uncompressed.
+        uint32_t stored;
+    };
+
+    /// Read-only stream over block compressed data, decompressing only the blocks that are read.
+    class ALIMER_API CompressedStream final : public Stream
+    {
+    public:
+        /// Construct over a seekable source stream, which must outlive this stream.
+        CompressedStream(Stream* source);
+
+        /// Construct and take ownership of a seekable source stream.
+        CompressedStream(UniquePtr<Stream> source);
+
+        bool CanRead() const override;
+        bool CanWrite() const override;
+        bool CanSeek() const override;
+
+        size_t Read(void* dest, size_t size) override;
+        size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+
+        /// Return whether the source was read successfully.
+        bool IsValid() const { return _valid; }
+
+        /// Return uncompressed block size.
+        uint32_t GetBlockSize() const { return _blockSize; }
+
+        /// Return number of blocks.
+        size_t GetNumBlocks() const { return _blocks.size(); }
+
+    private:
+        /// Read header and block index.
+        bool ReadIndex();
+        /// Decompress block into the block buffer.
+        bool LoadBlock(size_t index);
+
+        /// Owned source stream.
+        UniquePtr<Stream> _ownedSource;
+        /// Source stream.
+        Stream* _source;
+        /// Uncompressed block size.
+        uint32_t _blockSize;
+        /// Block index.
+        std::vector<CompressedBlockInfo> _blocks;
+        /// Decompressed current block.
+        std::vector<uint8_t> _blockData;
+        /// Compressed data read buffer.
+        std::vector<uint8_t> _compressedData;
+        /// Index of decompressed block.
+        size_t _currentBlock;
+        /// Valid flag.
+        bool _valid;
+    };
+
+    /// Write-only stream compressing data in fixed size blocks, followed by a block index for random access reads.
+    class ALIMER_API CompressedStreamWriter final : public Stream
+    {
+    public:
+        /// Construct over a destination stream, which must outlive this stream. Block size must be from 1 to COMPRESSED_STREAM_MAX_BLOCK_SIZE.
+        CompressedStreamWriter(Stream* dest, uint32_t blockSize = COMPRESSED_STREAM_DEFAULT_BLOCK_SIZE, CompressionLevel level = CompressionLevel::Fast);
+
+        /// Construct and take ownership of a destination stream.
+        CompressedStreamWriter(UniquePtr<Stream> dest, uint32_t blockSize = COMPRESSED_STREAM_DEFAULT_BLOCK_SIZE, CompressionLevel level = CompressionLevel::Fast);
+
+        /// Destructor. Finish the stream if not finished yet.
+        ~CompressedStreamWriter() override;
+
+        /// Compress pending data and write the block index. No data can be written after. Return true on success.
+        bool Finish();
+
+        bool CanRead() const override;
+        bool CanWrite() const override;
+        bool CanSeek() const override;
+
+        size_t Read(void* dest, size_t size) override;
+        size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+
+        /// Return number of compressed bytes written to the destination so far.
+        uint64_t GetCompressedSize() const { return _compressedSize; }
+
+    private:
+        /// Write the header.
+        void WriteHeader();
+        /// Compress and write the pending block.
+        bool FlushBlock();
+
+        /// Owned destination stream.
+        UniquePtr<Stream> _ownedDest;
+        /// Destination stream.
+        Stream* _dest;
+        /// Uncompressed block size.
+        uint32_t _blockSize;
+        /// Compression level.
+        CompressionLevel _level;
+        /// Block index.
+        std::vector<CompressedBlockInfo> _blocks;
+        /// Pending uncompressed data.
+        std::vector<uint8_t> _blockData;
+        /// Compression output buffer.
+        std::vector<uint8_t> _compressedData;
+        /// Bytes written to the destination.
+        uint64_t _compressedSize;
+        /// Error or finished flags.
+        bool _failed;
+        bool _finished;
+    };
+}
@@ -0,0 +1,377 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/Compression.h"
+#include <cstring>
+#include <vector>
+
+namespace Alimer
+{
+    static constexpr uint32_t LZ4_MIN_MATCH = 4;
+    /// Last bytes are always literals.
+    static constexpr uint32_t LZ4_LAST_LITERALS = 5;
+    /// Last match must start at least this far from the end.
+    static constexpr uint32_t LZ4_MF_LIMIT = 12;
+    static constexpr uint32_t LZ4_MAX_DISTANCE = 65535;
+    static constexpr uint32_t LZ4_HASH_LOG = 12;
+    static constexpr uint32_t LZ4HC_HASH_LOG = 15;
+    static constexpr uint32_t LZ4HC_NO_POSITION = 0xffffffff;
+
+    static inline uint32_t Read32(const uint8_t* ptr)
+    {
+        uint32_t value;
+        memcpy(&value, ptr, sizeof(value));
+        return value;
+    }
+
+    static inline uint32_t HashSequence(uint32_t sequence, uint32_t hashLog = LZ4_HASH_LOG)
+    {
+        return (sequence * 2654435761u) >> (32 - hashLog);
+    }
+
+    /// Write literal or match length continuation bytes.
+    static inline bool WriteLength(uint8_t*& op, const uint8_t* oend, size_t length)
+    {
+        while (length >= 255)
+        {
+            if (op >= oend)
+                return false;
+
+            *op++ = 255;
+            length -= 255;
+        }
+
+        if (op >= oend)
+            return false;
+
+        *op++ = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    /// Emit one sequence, match length of 0 emits the final literals only.
+    static bool WriteSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t literalLength, uint32_t offset, size_t matchLength)
+    {
+        if (op >= oend)
+            return false;
+
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+        if (literalLength >= 15
+            && !WriteLength(op, oend, literalLength - 15))
+        {
+            return false;
+        }
+
+        if (static_cast<size_t>(oend - op) < literalLength)
+            return false;
+
+        memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        if (matchLength == 0)
+            return true;
+
+        if (oend - op < 2)
+            return false;
+
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+
+        const size_t code = matchLength - LZ4_MIN_MATCH;
+        *token |= static_cast<uint8_t>(code >= 15 ? 15 : code);
+        if (code >= 15)
+            return WriteLength(op, oend, code - 15);
+
+        return true;
+    }
+
+    size_t GetCompressBound(size_t srcSize)
+    {
+        return srcSize + srcSize / 255 + 16;
+    }
+
+    uint64_t GetDecompressBound(uint64_t compressedSize)
+    {
+        // Each length continuation byte adds at most 255 bytes, tokens, offsets and literals expand less.
+        return compressedSize * 255;
+    }
+
+    size_t CompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize)
+    {
+        const uint8_t* const source = static_cast<const uint8_t*>(src);
+        const uint8_t* ip = source;
+        const uint8_t* anchor = source;
+        const uint8_t* const iend = source + srcSize;
+        uint8_t* op = static_cast<uint8_t*>(dest);
+        uint8_t* const oend = op + destSize;
+
+        if (srcSize > LZ4_MF_LIMIT)
+        {
+            const uint8_t* const mflimit = iend - LZ4_MF_LIMIT;
+            const uint8_t* const matchlimit = iend - LZ4_LAST_LITERALS;
+
+            // Positions are stored relative to source, 0 is never a valid candidate for ip > source.
+            std::vector<uint32_t> table(1u << LZ4_HASH_LOG, 0);
+            while (ip < mflimit)
+            {
+                const uint32_t sequence = Read32(ip);
+                const uint32_t hash = HashSequence(sequence);
+                const uint8_t* ref = source + table[hash];
+                table[hash] = static_cast<uint32_t>(ip - source);
+
+                if (ref >= ip
+                    || static_cast<size_t>(ip - ref) > LZ4_MAX_DISTANCE
+                    || Read32(ref) != sequence)
+                {
+                    ip++;
+                    continue;
+                }
+
+                // Extend backwards over pending literals, then forward.
+                while (ip > anchor && ref > source && ip[-1] == ref[-1])
+                {
+                    ip--;
+                    ref--;
+                }
+
+                size_t matchLength = LZ4_MIN_MATCH;
+                while (ip + matchLength < matchlimit && ref[matchLength] == ip[matchLength])
+                {
+                    matchLength++;
+                }
+
+                if (!WriteSequence(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<uint32_t>(ip - ref), matchLength))
+                    return 0;
+
+                ip += matchLength;
+                anchor = ip;
+
+                // Index position inside the match so that the next search finds recent data.
+                if (ip < mflimit)
+                {
+                    table[HashSequence(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - source);
+                }
+            }
+        }
+
+        if (!WriteSequence(op, oend, anchor, static_cast<size_t>(iend - anchor), 0, 0))
+            return 0;
+
+        return static_cast<size_t>(op - static_cast<uint8_t*>(dest));
+    }
+
+    size_t CompressLZ4HC(const void* src, size_t srcSize, void* dest, size_t destSize, int level)
+    {
+        const uint8_t* const source = static_cast<const uint8_t*>(src);
+        const uint8_t* ip = source;
+        const uint8_t* anchor = source;
+        const uint8_t* const iend = source + srcSize;
+        uint8_t* op = static_cast<uint8_t*>(dest);
+        uint8_t* const oend = op + destSize;
+
+        if (srcSize > LZ4_MF_LIMIT && srcSize < LZ4HC_NO_POSITION)
+        {
+            const uint8_t* const mflimit = iend - LZ4_MF_LIMIT;
+            const uint8_t* const matchlimit = iend - LZ4_LAST_LITERALS;
+            const uint32_t maxAttempts = 1u << (level < 1 ? 0 : level > 12 ? 11 : level - 1);
+
+            // Most recent position per hash, and distance to the previous position with the same hash within the window.
+            std::vector<uint32_t> head(1u << LZ4HC_HASH_LOG, LZ4HC_NO_POSITION);
+            std::vector<uint16_t> chain(LZ4_MAX_DISTANCE + 1, 0);
+            uint32_t nextToUpdate = 0;
+
+            auto findLongestMatch = [&](const uint8_t* position, const uint8_t*& matchRef) -> size_t
+            {
+                const uint32_t target = static_cast<uint32_t>(position - source);
+                while (nextToUpdate < target)
+                {
+                    const uint32_t hash = HashSequence(Read32(source + nextToUpdate), LZ4HC_HASH_LOG);
+                    const uint32_t previous = head[hash];
+                    const uint32_t delta = previous == LZ4HC_NO_POSITION ? 0 : nextToUpdate - previous;
+                    chain[nextToUpdate & LZ4_MAX_DISTANCE] = static_cast<uint16_t>(delta > LZ4_MAX_DISTANCE ? 0 : delta);
+                    head[hash] = nextToUpdate++;
+                }
+
+                const uint32_t sequence = Read32(position);
+                uint32_t candidate = head[HashSequence(sequence, LZ4HC_HASH_LOG)];
+                size_t bestLength = 0;
+                for (uint32_t attempts = maxAttempts;
+                    candidate != LZ4HC_NO_POSITION && attempts > 0 && target - candidate <= LZ4_MAX_DISTANCE;
+                    --attempts)
+                {
+                    const uint8_t* ref = source + candidate;
+                    if (ref[bestLength] == position[bestLength] && Read32(ref) == sequence)
+                    {
+                        size_t length = LZ4_MIN_MATCH;
+                        while (position + length < matchlimit && ref[length] == position[length])
+                        {
+                            length++;
+                        }
+
+                        if (length > bestLength)
+                        {
+                            bestLength = length;
+                            matchRef = ref;
+                        }
+                    }
+
+                    const uint16_t delta = chain[candidate & LZ4_MAX_DISTANCE];
+                    if (!delta)
+                        break;
+                    candidate -= delta;
+                }
+
+                return bestLength;
+            };
+
+            while (ip < mflimit)
+            {
+                const uint8_t* ref = nullptr;
+                size_t matchLength = findLongestMatch(ip, ref);
+                if (matchLength < LZ4_MIN_MATCH)
+                {
+                    ip++;
+                    continue;
+                }
+
+                // Lazy matching: prefer a literal when the next position starts a longer match.
+                while (ip + 1 < mflimit)
+                {
+                    const uint8_t* nextRef = nullptr;
+                    const size_t nextLength = findLongestMatch(ip + 1, nextRef);
+                    if (nextLength <= matchLength + 1)
+                        break;
+
+                    ip++;
+                    ref = nextRef;
+                    matchLength = nextLength;
+                }
+
+                if (!WriteSequence(op, oend, anchor, static_cast<size_t>(ip - anchor), static_cast<uint32_t>(ip - ref), matchLength))
+                    return 0;
+
+                ip += matchLength;
+                anchor = ip;
+            }
+        }
+
+        if (!WriteSequence(op, oend, anchor, static_cast<size_t>(iend - anchor), 0, 0))
+            return 0;
+
+        return static_cast<size_t>(op - static_cast<uint8_t*>(dest));
+    }
+
+    size_t CompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize, CompressionLevel level)
+    {
+        return level == CompressionLevel::High
+            ? CompressLZ4HC(src, srcSize, dest, destSize)
+            : CompressLZ4(src, srcSize, dest, destSize);
+    }
+
+    size_t DecompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize)
+    {
+        const uint8_t* ip = static_cast<const uint8_t*>(src);
+        const uint8_t* const iend = ip + srcSize;
+        uint8_t* const ostart = static_cast<uint8_t*>(dest);
+        uint8_t* op = ostart;
+        uint8_t* const oend = op + destSize;
+
+        while (ip < iend)
+        {
+            const uint8_t token = *ip++;
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15)
+            {
+                uint8_t value;
+                do
+                {
+                    if (ip >= iend)
+                        return 0;
+
+                    value = *ip++;
+                    literalLength += value;
+                } while (value == 255);
+            }
+
+            if (static_cast<size_t>(iend - ip) < literalLength
+                || static_cast<size_t>(oend - op) < literalLength)
+            {
+                return 0;
+            }
+
+            memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+
+            // Last sequence has no match.
+            if (ip >= iend)
+                break;
+
+            if (iend - ip < 2)
+                return 0;
+
+            const size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if (offset == 0
+                || offset > static_cast<size_t>(op - ostart))
+            {
+                return 0;
+            }
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15)
+            {
+                uint8_t value;
+                do
+                {
+                    if (ip >= iend)
+                        return 0;
+
+                    value = *ip++;
+                    matchLength += value;
+                } while (value == 255);
+            }
+
+            matchLength += LZ4_MIN_MATCH;
+            if (static_cast<size_t>(oend - op) < matchLength)
+                return 0;
+
+            // Matches may overlap their own output.
+            const uint8_t* match = op - offset;
+            if (offset >= matchLength)
+            {
+                memcpy(op, match, matchLength);
+                op += matchLength;
+            }
+            else
+            {
+                for (size_t i = 0; i < matchLength; ++i)
+                {
+                    *op++ = *match++;
+                }
+            }
+        }
+
+        return static_cast<size_t>(op - ostart);
+    }
+}
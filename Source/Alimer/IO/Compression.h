@@ -0,0 +1,57 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace Alimer
+{
+    /// LZ4 compression level.
+    enum class CompressionLevel
+    {
+        /// Fast compression.
+        Fast,
+        /// High compression, slower to compress but decompresses at the same speed.
+        High
+    };
+
+    /// Return worst case size of LZ4 compressed data for given source size.
+    ALIMER_API size_t GetCompressBound(size_t srcSize);
+
+    /// Return largest size LZ4 compressed data of given size can decompress to.
+    ALIMER_API uint64_t GetDecompressBound(uint64_t compressedSize);
+
+    /// Compress data in LZ4 block format. Return compressed size, or 0 if destination is too small.
+    ALIMER_API size_t CompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize);
+
+    /// Compress data in LZ4 block format searching hash chains for longer matches, slower but with better ratio. Level is clamped to 1-12. Return compressed size, or 0 if destination is too small.
+    ALIMER_API size_t CompressLZ4HC(const void* src, size_t srcSize, void* dest, size_t destSize, int level = 9);
+
+    /// Compress data in LZ4 block format with given level. Return compressed size, or 0 if destination is too small.
+    ALIMER_API size_t CompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize, CompressionLevel level);
+
+    /// Decompress LZ4 block format data with bounds checking. Return decompressed size, or 0 on corrupted input.
+    ALIMER_API size_t DecompressLZ4(const void* src, size_t srcSize, void* dest, size_t destSize);
+}
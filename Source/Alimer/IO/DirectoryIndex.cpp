@@ -0,0 +1,334 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/DirectoryIndex.h"
+#include "../IO/Path.h"
+#include "../Core/Log.h"
+#include <algorithm>
+
+namespace Alimer
+{
+    namespace
+    {
+        /// Indexes answering file system queries under their directory.
+        struct IndexRegistry
+        {
+            std::mutex mutex;
+            std::vector<DirectoryIndex*> indexes;
+        };
+
+        /// Never destroyed, indexes owned by static objects unregister during exit.
+        IndexRegistry& GetRegistry()
+        {
+            static IndexRegistry* registry = new IndexRegistry();
+            return *registry;
+        }
+
+        /// Return absolute path in internal format without trailing slash, or empty if it refers to a parent directory.
+        String GetLookupPath(const String& path)
+        {
+            String fullPath = RemoveTrailingSlash(path);
+            if (!IsAbsolutePath(fullPath))
+                fullPath = Path::Join(FileSystem::GetCurrentDirectory(), fullPath);
+
+            fullPath.Replace("/./", "/");
+            if (fullPath.EndsWith("/."))
+                fullPath.Resize(fullPath.Length() - 2);
+            if (fullPath.Find("/../") != String::NPOS || fullPath.EndsWith("/.."))
+                return String::EMPTY;
+
+            return fullPath;
+        }
+    }
+
+    DirectoryIndex::DirectoryIndex()
+    {
+    }
+
+    DirectoryIndex::~DirectoryIndex()
+    {
+        Unregister();
+
+        // Stop the watcher before members it updates are destroyed.
+        _watcher.StopWatching();
+    }
+
+    bool DirectoryIndex::Build(const String& path)
+    {
+        Unregister();
+        _watcher.StopWatching();
+
+        const String directory = AddTrailingSlash(path);
+        if (!FileSystem::DirectoryExists(directory))
+            return false;
+
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            _path = directory;
+            _files.clear();
+            _directories.clear();
+
+            // Start watching first so that no change is missed, changes wait for the lock until the scan is done.
+            if (!_watcher.StartWatching(_path, true, [this](const FileChange& change) { OnChange(change); }))
+                return false;
+
+            ScanContent();
+            ALIMER_LOGDEBUGF("Indexed %u files in '%s'", static_cast<uint32_t>(_files.size()), _path.CString());
+        }
+
+        // Registered outside the index lock, lookups lock the registry first.
+        const String absolutePath = GetLookupPath(_path);
+        if (!absolutePath.IsEmpty())
+        {
+            IndexRegistry& registry = GetRegistry();
+            std::lock_guard<std::mutex> guard(registry.mutex);
+            _absolutePath = absolutePath + "/";
+            registry.indexes.push_back(this);
+        }
+
+        return true;
+    }
+
+    void DirectoryIndex::Unregister()
+    {
+        IndexRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        registry.indexes.erase(std::remove(registry.indexes.begin(), registry.indexes.end(), this), registry.indexes.end());
+        _absolutePath.Clear();
+    }
+
+    DirectoryIndex* DirectoryIndex::FindIndex(const String& fullPath, String& relativePath)
+    {
+        for (DirectoryIndex* index : GetRegistry().indexes)
+        {
+            if (!index->IsLive())
+                continue;
+
+            // The indexed directory itself is the empty relative path.
+            const String& indexPath = index->_absolutePath;
+            if (fullPath.Length() + 1 == indexPath.Length() && indexPath.StartsWith(fullPath))
+            {
+                relativePath.Clear();
+                return index;
+            }
+
+            if (fullPath.StartsWith(indexPath))
+            {
+                relativePath = fullPath.Substring(indexPath.Length());
+                return index;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool DirectoryIndex::LookupFile(const String& fileName, bool& exists)
+    {
+        IndexRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        if (registry.indexes.empty())
+            return false;
+
+        String relativePath;
+        DirectoryIndex* index = FindIndex(GetLookupPath(fileName), relativePath);
+        if (!index)
+            return false;
+
+        exists = !relativePath.IsEmpty() && index->FileExists(relativePath);
+        return true;
+    }
+
+    bool DirectoryIndex::LookupDirectory(const String& path, bool& exists)
+    {
+        IndexRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        if (registry.indexes.empty())
+            return false;
+
+        String relativePath;
+        DirectoryIndex* index = FindIndex(GetLookupPath(path), relativePath);
+        if (!index)
+            return false;
+
+        exists = index->DirectoryExists(relativePath);
+        return true;
+    }
+
+    bool DirectoryIndex::LookupScan(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive)
+    {
+        IndexRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        if (registry.indexes.empty())
+            return false;
+
+        String relativePath;
+        DirectoryIndex* index = FindIndex(GetLookupPath(pathName), relativePath);
+        if (!index)
+            return false;
+
+        // Scanning a missing directory finds nothing, same as on disk.
+        if (index->DirectoryExists(relativePath))
+            index->Scan(result, relativePath, filter, flags, recursive);
+        else
+            result.clear();
+
+        return true;
+    }
+
+    bool DirectoryIndex::FileExists(const String& name) const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _files.find(name) != _files.end();
+    }
+
+    bool DirectoryIndex::DirectoryExists(const String& name) const
+    {
+        String dirName = RemoveTrailingSlash(name);
+        if (dirName.IsEmpty())
+            return true;
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _directories.find(dirName) != _directories.end();
+    }
+
+    void DirectoryIndex::Scan(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive) const
+    {
+        result.clear();
+
+        String prefix = AddTrailingSlash(pathName);
+        if (prefix == "/")
+            prefix.Clear();
+
+        String filterExtension = filter.Substring(filter.FindLast('.'));
+        if (filterExtension.Find('*') != String::NPOS)
+            filterExtension.Clear();
+
+        auto collect = [&](const std::unordered_set<String>& names, bool applyFilter)
+        {
+            for (const String& name : names)
+            {
+                if (prefix.Length() && !name.StartsWith(prefix))
+                    continue;
+
+                String relativeName = prefix.Length() ? name.Substring(prefix.Length()) : name;
+                if (!recursive && relativeName.Find('/') != String::NPOS)
+                    continue;
+
+                if (!any(flags & ScanDirFlags::Hidden) && (relativeName.StartsWith(".") || relativeName.Find("/.") != String::NPOS))
+                    continue;
+
+                if (applyFilter && !filterExtension.IsEmpty() && !relativeName.EndsWith(filterExtension))
+                    continue;
+
+                result.push_back(relativeName);
+            }
+        };
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        if (any(flags & ScanDirFlags::Files))
+            collect(_files, true);
+        if (any(flags & ScanDirFlags::Directories))
+            collect(_directories, false);
+    }
+
+    size_t DirectoryIndex::GetNumFiles() const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _files.size();
+    }
+
+    void DirectoryIndex::SetChangeCallback(const FileWatcher::Callback& callback)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _changeCallback = callback;
+    }
+
+    void DirectoryIndex::OnChange(const FileChange& change)
+    {
+        FileWatcher::Callback callback;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            ApplyChange(change);
+            callback = _changeCallback;
+        }
+
+        if (callback)
+            callback(change);
+    }
+
+    void DirectoryIndex::ApplyChange(const FileChange& change)
+    {
+        std::unordered_set<String>& names = change.directory ? _directories : _files;
+        switch (change.type)
+        {
+        case FileChangeType::Added:
+            names.insert(change.fileName);
+            break;
+
+        case FileChangeType::Removed:
+            names.erase(change.fileName);
+            if (change.directory)
+            {
+                // Content of a moved directory is not reported separately.
+                const String prefix = change.fileName + "/";
+                for (auto* set : { &_files, &_directories })
+                {
+                    for (auto it = set->begin(); it != set->end();)
+                    {
+                        if (it->StartsWith(prefix))
+                            it = set->erase(it);
+                        else
+                            ++it;
+                    }
+                }
+            }
+            break;
+
+        case FileChangeType::Modified:
+            break;
+
+        case FileChangeType::Rescan:
+            // Without the watcher the index is not used anymore.
+            if (_watcher.IsWatching())
+                ScanContent();
+            break;
+        }
+    }
+
+    void DirectoryIndex::ScanContent()
+    {
+        _files.clear();
+        _directories.clear();
+
+        std::vector<String> entries;
+        ScanNativeDirectory(entries, _path, "*", ScanDirFlags::Files | ScanDirFlags::Hidden, true);
+        _files.insert(entries.begin(), entries.end());
+
+        entries.clear();
+        ScanNativeDirectory(entries, _path, "*", ScanDirFlags::Directories | ScanDirFlags::Hidden, true);
+        for (const String& entry : entries)
+        {
+            if (!entry.EndsWith(".") && !entry.EndsWith(".."))
+                _directories.insert(entry);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/FileWatcher.h"
+#include "../IO/FileSystem.h"
+#include <mutex>
+#include <unordered_set>
+
+namespace Alimer
+{
+    /// In-memory index of the files and directories under a directory, kept current with a file watcher.
+    class ALIMER_API DirectoryIndex final
+    {
+    public:
+        /// Constructor.
+        DirectoryIndex();
+
+        /// Destructor.
+        ~DirectoryIndex();
+
+        /// Scan directory and start watching it for changes. Return true on success.
+        bool Build(const String& path);
+
+        /// Return whether the index is kept current. When not, lookups may return stale results.
+        bool IsLive() const { return _watcher.IsWatching(); }
+
+        /// Check if a file exists, name relative to the indexed directory.
+        bool FileExists(const String& name) const;
+
+        /// Check if a directory exists, name relative to the indexed directory.
+        bool DirectoryExists(const String& name) const;
+
+        /// Scan for files or directories under a relative path, same as ScanDirectory.
+        void Scan(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive) const;
+
+        /// Check if a file exists using the live index containing the native path. Return false if no live index contains it, otherwise the result is stored in exists.
+        static bool LookupFile(const String& fileName, bool& exists);
+
+        /// Check if a directory exists using the live index containing the native path. Return false if no live index contains it, otherwise the result is stored in exists.
+        static bool LookupDirectory(const String& path, bool& exists);
+
+        /// Scan a native directory using the live index containing it, same as ScanDirectory. Return false if no live index contains the directory.
+        static bool LookupScan(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive);
+
+        /// Set callback invoked on the watcher thread after the index has been updated for a change.
+        void SetChangeCallback(const FileWatcher::Callback& callback);
+
+        /// Return indexed directory with trailing slash.
+        const String& GetPath() const { return _path; }
+
+        /// Return number of indexed files.
+        size_t GetNumFiles() const;
+
+    private:
+        /// Handle a change from the file watcher.
+        void OnChange(const FileChange& change);
+        /// Apply a change to the index.
+        void ApplyChange(const FileChange& change);
+        /// Scan all files and directories into the index.
+        void ScanContent();
+        /// Stop answering file system lookups.
+        void Unregister();
+        /// Return live registered index containing the absolute path and the path relative to it, or null. Registry mutex must be held.
+        static DirectoryIndex* FindIndex(const String& fullPath, String& relativePath);
+
+        /// Indexed directory.
+        String _path;
+        /// Absolute indexed directory with trailing slash, set while registered for lookups.
+        String _absolutePath;
+        /// Relative file names.
+        std::unordered_set<String> _files;
+        /// Relative directory names, without trailing slash.
+        std::unordered_set<String> _directories;
+        /// Change callback.
+        FileWatcher::Callback _changeCallback;
+        /// Mutex for the index and change callback.
+        mutable std::mutex _mutex;
+        /// File watcher.
+        FileWatcher _watcher;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(DirectoryIndex);
+    };
+}
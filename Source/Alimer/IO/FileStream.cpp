@@ -29,20 +29,19 @@
 #include "../Core/Platform.h"
 #endif
 
-#include <cstdio>
+#include <algorithm>
+#include <cstring>
 
-namespace Alimer
-{
 #if !ALIMER_PLATFORM_WINDOWS && !ALIMER_PLATFORM_UWP
-    static const char* openModes[] =
-    {
-        "rb",
-        "wb",
-        "r+b",
-        "w+b"
-    };
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #endif
 
+namespace Alimer
+{
     static bool EnsureDirectoryExistsInner(const String &path)
     {
         if (Path::IsRootPath(path))
@@ -69,23 +68,21 @@ namespace Alimer
 
     FileStream::FileStream()
         : _mode(FileAccess::ReadOnly)
-        , _canSeek(true)
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
         , _handle(INVALID_HANDLE_VALUE)
 #else
-        , _handle(nullptr)
+        , _handle(-1)
 #endif
+        , _canSeek(true)
+        , _bufferSize(FILE_STREAM_DEFAULT_BUFFER_SIZE)
+        , _pending(0)
+        , _readOffset(0)
+        , _readLength(0)
     {
     }
 
     FileStream::FileStream(const String& fileName, FileAccess mode)
-        : _mode(FileAccess::ReadOnly)
-        , _canSeek(true)
-#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
-        , _handle(INVALID_HANDLE_VALUE)
-#else
-        , _handle(nullptr)
-#endif
+        : FileStream()
     {
         Open(fileName, mode);
     }
@@ -102,13 +99,6 @@ namespace Alimer
         if (fileName.IsEmpty())
             return false;
 
-        if (mode == FileAccess::ReadOnly
-            && !FileSystem::FileExists(fileName))
-        {
-            ALIMER_LOGERROR("Cannot open file for read as it doesn't exists");
-            return false;
-        }
-
         if (mode == FileAccess::ReadWrite
             || mode == FileAccess::WriteOnly)
         {
@@ -152,6 +142,7 @@ namespace Alimer
         if (_handle == INVALID_HANDLE_VALUE)
         {
             ALIMER_LOGERRORF("Win32 - Failed to open file: '%s'.", fileName.CString());
+            return false;
         }
 
         if (mode != FileAccess::WriteOnly)
@@ -165,22 +156,34 @@ namespace Alimer
             _size = static_cast<size_t>(size.QuadPart);
         }
 #else
-        _handle = fopen(fileName.CString(), openModes[static_cast<uint32_t>(mode)]);
-        // If file did not exist in readwrite mode, retry with write-update mode
-        if (mode == FileAccess::ReadWrite
-            && !_handle)
+        int flags = O_CLOEXEC;
+        switch (mode)
         {
-            _handle = fopen(fileName.CString(), openModes[static_cast<uint32_t>(mode) + 1]);
+        case FileAccess::ReadOnly:
+            flags |= O_RDONLY;
+            break;
+
+        case FileAccess::WriteOnly:
+            flags |= O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+
+        case FileAccess::ReadWrite:
+            flags |= O_RDWR | O_CREAT;
+            break;
         }
 
-        if (!_handle)
+        _handle = open(fileName.CString(), flags, 0666);
+        if (_handle == -1)
+        {
+            ALIMER_LOGERRORF("Failed to open file '%s'", fileName.CString());
             return false;
+        }
 
         if (mode != FileAccess::WriteOnly)
         {
-            fseek((FILE*)_handle, 0, SEEK_END);
-            _size = ftell((FILE*)_handle);
-            fseek((FILE*)_handle, 0, SEEK_SET);
+            struct stat st;
+            if (fstat(_handle, &st) == 0)
+                _size = static_cast<size_t>(st.st_size);
         }
 #endif
 
@@ -193,6 +196,9 @@ namespace Alimer
 
     void FileStream::Close()
     {
+        if (IsOpen())
+            FlushWrites();
+
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
         if (_handle != INVALID_HANDLE_VALUE)
         {
@@ -200,43 +206,43 @@ namespace Alimer
             _handle = INVALID_HANDLE_VALUE;
         }
 #else
-        if (_handle != nullptr)
+        if (_handle != -1)
         {
-            fclose((FILE*)_handle);
-            _handle = nullptr;
+            close(_handle);
+            _handle = -1;
         }
 #endif
         _position = 0;
         _size = 0;
+        _pending = 0;
+        _readOffset = 0;
+        _readLength = 0;
     }
 
-    void FileStream::Flush()
+    bool FileStream::Flush()
     {
-#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
-        if (_handle != INVALID_HANDLE_VALUE)
-        {
-            if (::FlushFileBuffers(_handle) == S_FALSE)
-            {
-                //GetLastWin32Error()
-            }
-        }
-#else
-        if (_handle != nullptr)
-        {
-            fflush((FILE*)_handle);
-        }
-#endif
+        return FlushWrites();
+    }
+
+    void FileStream::SetBufferSize(size_t size)
+    {
+        FlushWrites();
+        DiscardReadBuffer();
+
+        _bufferSize = size;
+        _buffer.clear();
+        _buffer.shrink_to_fit();
     }
 
     bool FileStream::CanRead() const
     {
-        return _handle != nullptr
+        return IsOpen()
             && (_mode == FileAccess::ReadOnly || _mode == FileAccess::ReadWrite);
     }
 
     bool FileStream::CanWrite() const
     {
-        return _handle != nullptr
+        return IsOpen()
             && (_mode == FileAccess::WriteOnly || _mode == FileAccess::ReadWrite);
     }
 
@@ -247,6 +253,15 @@ namespace Alimer
 
     size_t FileStream::Read(void* dest, size_t size)
     {
+        // Read ahead data implies a readable stream with no pending output.
+        if (size && _readLength - _readOffset >= size)
+        {
+            memcpy(dest, &_buffer[_readOffset], size);
+            _readOffset += size;
+            _position += size;
+            return size;
+        }
+
         if (!CanRead())
         {
             ALIMER_LOGERROR("Cannot read for write only stream");
@@ -258,73 +273,309 @@ namespace Alimer
             size = _size - _position;
         }
 
-        if (!size)
+        if (!size || !FlushWrites())
             return 0;
 
-#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
-        DWORD byteRead;
-        if (!ReadFile(_handle, dest, static_cast<DWORD>(size), &byteRead, nullptr))
+        uint8_t* destPtr = static_cast<uint8_t*>(dest);
+        size_t totalRead = 0;
+        while (totalRead < size)
         {
-            return 0;
+            if (_readOffset < _readLength)
+            {
+                const size_t count = std::min(size - totalRead, _readLength - _readOffset);
+                memcpy(destPtr + totalRead, &_buffer[_readOffset], count);
+                _readOffset += count;
+                totalRead += count;
+                continue;
+            }
+
+            // Large reads bypass the buffer.
+            const size_t remaining = size - totalRead;
+            if (remaining >= _bufferSize)
+            {
+                _readOffset = 0;
+                _readLength = 0;
+                const size_t count = ReadFromFile(destPtr + totalRead, remaining);
+                totalRead += count;
+                if (count != remaining)
+                    break;
+                continue;
+            }
+
+            if (_buffer.size() < _bufferSize)
+                _buffer.resize(_bufferSize);
+
+            _readOffset = 0;
+            _readLength = ReadFromFile(_buffer.data(), _bufferSize);
+            if (!_readLength)
+                break;
         }
 
-        _position += byteRead;
-        return static_cast<size_t>(byteRead);
-#else
-        size_t ret = fread(dest, size, 1, (FILE*)_handle);
-        if (ret != 1)
+        _position += totalRead;
+        return totalRead;
+    }
+
+    size_t FileStream::Write(const void* data, size_t size)
+    {
+        // Pending output implies a writable stream with allocated buffer and no read ahead data.
+        if (_pending && size && _pending + size <= _bufferSize)
         {
-            // If error, return to the position where the read began
-            fseek((FILE*)_handle, (long)_position, SEEK_SET);
-            return 0;
+            memcpy(&_buffer[_pending], data, size);
+            _pending += size;
+            _position += size;
+            if (_position > _size)
+            {
+                _size = _position;
+            }
+            return size;
         }
 
-        _position += size;
-        return size;
-#endif
+        StreamBuffer buffer = { data, size };
+        return WriteGather(&buffer, 1);
     }
 
-    size_t FileStream::Write(const void* data, size_t size)
+    size_t FileStream::WriteGather(const StreamBuffer* buffers, size_t count)
     {
-        if (!_handle || _mode == FileAccess::ReadOnly)
+        if (!CanWrite() || !DiscardReadBuffer())
             return 0;
 
-        if (!size)
+        size_t totalSize = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            totalSize += buffers[i].size;
+        }
+
+        if (!totalSize)
             return 0;
 
-#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
-        DWORD byteWritten;
-        if (!WriteFile(_handle, data, static_cast<DWORD>(size), &byteWritten, nullptr))
+        size_t written = 0;
+        if (totalSize < _bufferSize)
         {
-            return 0;
+            if (_pending + totalSize > _bufferSize && !FlushWrites())
+                return 0;
+
+            if (_buffer.size() < _bufferSize)
+                _buffer.resize(_bufferSize);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (buffers[i].size)
+                {
+                    memcpy(&_buffer[_pending], buffers[i].data, buffers[i].size);
+                    _pending += buffers[i].size;
+                }
+            }
+
+            written = totalSize;
+        }
+        else
+        {
+            written = WriteThrough(buffers, count);
+        }
+
+        _position += written;
+        if (_position > _size)
+        {
+            _size = _position;
+        }
+
+        return written;
+    }
+
+    bool FileStream::Seek(size_t position)
+    {
+        if (!IsOpen())
+            return false;
+
+        // Allow sparse seeks if writing
+        if (_mode == FileAccess::ReadOnly && position > _size)
+            position = _size;
+
+        // Seek inside read ahead data without touching the file.
+        const size_t bufferStart = _position - _readOffset;
+        if (_readLength
+            && position >= bufferStart
+            && position <= bufferStart + _readLength)
+        {
+            _readOffset = position - bufferStart;
+            _position = position;
+            return true;
         }
 
-        _position += byteWritten;
+        if (!FlushWrites())
+            return false;
+
+        _readOffset = 0;
+        _readLength = 0;
+        if (!SeekFile(position))
+            return false;
+
+        _position = position;
+        return true;
+    }
+
+    bool FileStream::IsOpen() const
+    {
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        return _handle != INVALID_HANDLE_VALUE;
 #else
-        if (fwrite(data, size, 1, (FILE*)_handle) != 1)
+        return _handle != -1;
+#endif
+    }
+
+    bool FileStream::FlushWrites()
+    {
+        if (!_pending)
+            return true;
+
+        StreamBuffer buffer = { _buffer.data(), _pending };
+        const size_t written = WriteToFile(&buffer, 1);
+        if (written != _pending)
+        {
+            // Keep what could not be written for a later retry.
+            memmove(_buffer.data(), _buffer.data() + written, _pending - written);
+            _pending -= written;
+            ALIMER_LOGERRORF("Failed to write to file '%s'", _name.CString());
+            return false;
+        }
+
+        _pending = 0;
+        return true;
+    }
+
+    bool FileStream::DiscardReadBuffer()
+    {
+        if (!_readLength)
+            return true;
+
+        const bool movePointer = _readOffset != _readLength;
+        _readOffset = 0;
+        _readLength = 0;
+        return !movePointer || SeekFile(_position);
+    }
+
+    size_t FileStream::WriteThrough(const StreamBuffer* buffers, size_t count)
+    {
+        if (!_pending)
+            return WriteToFile(buffers, count);
+
+        // Gather pending output and the new ranges into a single call.
+        std::vector<StreamBuffer> gather;
+        gather.reserve(count + 1);
+        gather.push_back({ _buffer.data(), _pending });
+        gather.insert(gather.end(), buffers, buffers + count);
+
+        const size_t written = WriteToFile(gather.data(), gather.size());
+        if (written < _pending)
         {
-            // If error, return to the position where the write began
-            fseek((FILE*)_handle, (long)_position, SEEK_SET);
+            memmove(_buffer.data(), _buffer.data() + written, _pending - written);
+            _pending -= written;
+            ALIMER_LOGERRORF("Failed to write to file '%s'", _name.CString());
             return 0;
         }
 
-        _position += size;
+        const size_t pending = _pending;
+        _pending = 0;
+        return written - pending;
+    }
+
+    size_t FileStream::WriteToFile(const StreamBuffer* buffers, size_t count)
+    {
+        size_t totalWritten = 0;
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(buffers[i].data);
+            size_t remaining = buffers[i].size;
+            while (remaining)
+            {
+                DWORD chunk = static_cast<DWORD>(std::min<size_t>(remaining, 0x40000000));
+                DWORD bytesWritten;
+                if (!::WriteFile(_handle, data, chunk, &bytesWritten, nullptr) || !bytesWritten)
+                    return totalWritten;
+
+                data += bytesWritten;
+                remaining -= bytesWritten;
+                totalWritten += bytesWritten;
+            }
+        }
+#else
+        static constexpr size_t MAX_IOVECS = 64;
+        size_t index = 0;
+        size_t offset = 0;
+        while (index < count)
+        {
+            iovec iov[MAX_IOVECS];
+            int iovCount = 0;
+            for (size_t i = index; i < count && iovCount < static_cast<int>(MAX_IOVECS); ++i)
+            {
+                const size_t skip = i == index ? offset : 0;
+                if (buffers[i].size == skip)
+                    continue;
+
+                iov[iovCount].iov_base = const_cast<uint8_t*>(static_cast<const uint8_t*>(buffers[i].data) + skip);
+                iov[iovCount].iov_len = buffers[i].size - skip;
+                ++iovCount;
+            }
+
+            if (!iovCount)
+                break;
+
+            ssize_t result = writev(_handle, iov, iovCount);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+
+            // Advance over fully and partially written ranges.
+            size_t advance = static_cast<size_t>(result);
+            totalWritten += advance;
+            while (index < count && advance >= buffers[index].size - offset)
+            {
+                advance -= buffers[index].size - offset;
+                offset = 0;
+                ++index;
+            }
+            offset += advance;
+        }
 #endif
+        return totalWritten;
+    }
 
-        if (_position > _size)
+    size_t FileStream::ReadFromFile(void* dest, size_t size)
+    {
+        uint8_t* destPtr = static_cast<uint8_t*>(dest);
+        size_t totalRead = 0;
+        while (totalRead < size)
         {
-            _size = _position;
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size - totalRead, 0x40000000));
+            DWORD bytesRead;
+            if (!::ReadFile(_handle, destPtr + totalRead, chunk, &bytesRead, nullptr) || !bytesRead)
+                break;
+#else
+            ssize_t bytesRead = read(_handle, destPtr + totalRead, size - totalRead);
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            if (bytesRead <= 0)
+                break;
+#endif
+            totalRead += static_cast<size_t>(bytesRead);
         }
 
-        return _size;
+        return totalRead;
     }
 
-    bool FileStream::IsOpen() const
+    bool FileStream::SeekFile(size_t position)
     {
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
-        return _handle != INVALID_HANDLE_VALUE;
+        LARGE_INTEGER distance;
+        distance.QuadPart = static_cast<LONGLONG>(position);
+        return SetFilePointerEx(_handle, distance, nullptr, FILE_BEGIN) != 0;
 #else
-        return _handle != nullptr;
+        return lseek(_handle, static_cast<off_t>(position), SEEK_SET) != static_cast<off_t>(-1);
 #endif
     }
 }
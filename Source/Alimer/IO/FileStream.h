@@ -33,7 +33,10 @@ namespace Alimer
 		ReadWrite
 	};
 
-	/// OS file stream.
+    /// Default size of the FileStream read and write buffer.
+    static constexpr size_t FILE_STREAM_DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+	/// OS file stream. Small reads and writes go through an internal buffer, larger ones directly to the file.
 	class ALIMER_API FileStream : public Stream
 	{
 	public:
@@ -52,8 +55,14 @@ namespace Alimer
         /// Close the file.
         void Close();
 
-        /// Flush any buffered output to the file.
-        void Flush();
+        /// Flush buffered output to the file. Return true on success.
+        bool Flush();
+
+        /// Set buffer size, zero disables buffering. Flushes buffered output.
+        void SetBufferSize(size_t size);
+
+        /// Return buffer size.
+        size_t GetBufferSize() const { return _bufferSize; }
 
         bool CanRead() const override;
         bool CanWrite() const override;
@@ -61,16 +70,42 @@ namespace Alimer
 
 		size_t Read(void* dest, size_t size) override;
         size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+        size_t WriteGather(const StreamBuffer* buffers, size_t count) override;
 
         /// Return whether is open.
         bool IsOpen() const;
 
-        /// Return the file handle.
-        void* GetHandle() const { return _handle; }
-
     private:
+        /// Write pending buffered output.
+        bool FlushWrites();
+        /// Drop read ahead data and move the file pointer back to the current position.
+        bool DiscardReadBuffer();
+        /// Write ranges directly to the file, together with pending buffered output. Return number of bytes written from the ranges.
+        size_t WriteThrough(const StreamBuffer* buffers, size_t count);
+        /// Write ranges to the file. Return number of bytes written.
+        size_t WriteToFile(const StreamBuffer* buffers, size_t count);
+        /// Read from the file. Return number of bytes read.
+        size_t ReadFromFile(void* dest, size_t size);
+        /// Set file pointer.
+        bool SeekFile(size_t position);
+
         FileAccess _mode;
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
         void* _handle;
+#else
+        int _handle;
+#endif
         bool _canSeek;
+        /// Read or write buffer, allocated on first use.
+        std::vector<uint8_t> _buffer;
+        /// Buffer size.
+        size_t _bufferSize;
+        /// Buffered output not yet written to the file.
+        size_t _pending;
+        /// Read position in the buffer.
+        size_t _readOffset;
+        /// Read ahead data in the buffer.
+        size_t _readLength;
 	};
 }
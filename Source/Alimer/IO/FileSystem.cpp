@@ -21,49 +21,101 @@
 //
 
 #include "../IO/FileSystem.h"
+#include "../IO/MappedFileStream.h"
+#include "../IO/DirectoryIndex.h"
 #include "../IO/Path.h"
 #include "../Base/String.h"
 #include "../Core/Log.h"
+#include <algorithm>
+
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+#   include <sys/types.h>
+#   include <sys/utime.h>
+#else
+#   include <sys/stat.h>
+#   include <utime.h>
+#   include <unistd.h>
+#   include <dirent.h>
+#   include <errno.h>
+#   include <limits.h>
+#   include <cstring>
+#   include <cstdio>
+#   if defined(__APPLE__)
+#       include <mach-o/dyld.h>
+#   endif
+#   ifndef MAX_PATH
+#       define MAX_PATH PATH_MAX
+#   endif
+#endif
 
 namespace Alimer
 {
-    class OSFileSystemProtocol final : public FileSystemProtocol
+    OSFileSystemProtocol::OSFileSystemProtocol(const String& rootDirectory, bool indexed)
+        : _rootDirectory(rootDirectory)
+        , _indexed(indexed)
     {
-    public:
-        OSFileSystemProtocol(const String &rootDirectory)
-            : _rootDirectory(rootDirectory)
-        {
+    }
 
-        }
+    OSFileSystemProtocol::~OSFileSystemProtocol() = default;
 
-        ~OSFileSystemProtocol() override = default;
+    String OSFileSystemProtocol::GetFileSystemPath(const String& path)
+    {
+        return Path::Join(_rootDirectory, path);
+    }
 
-        String GetFileSystemPath(const String& path) override
-        {
-            return Path::Join(_rootDirectory, path);
-        }
+    bool OSFileSystemProtocol::Exists(const String& path)
+    {
+        const DirectoryIndex* index = GetIndex();
+        if (index)
+            return index->FileExists(path);
+
+        String fullPath = Path::Join(_rootDirectory, path);
+        return FileSystem::FileExists(fullPath);
+    }
 
-        bool Exists(const String &path) override
+    UniquePtr<Stream> OSFileSystemProtocol::Open(const String& path, FileAccess mode)
+    {
+        // Without an index opening fails by itself, avoid an extra existence check.
+        const DirectoryIndex* index = GetIndex();
+        if (mode == FileAccess::ReadOnly
+            && index
+            && !index->FileExists(path))
         {
-            String fullPath = Path::Join(_rootDirectory, path);
-            return FileSystem::FileExists(fullPath);
+            ALIMER_LOGERROR("Cannot open file for read as it doesn't exists");
+            return {};
         }
 
-        UniquePtr<Stream> Open(const String &path, FileAccess mode) override
-        {
-            if (mode == FileAccess::ReadOnly
-                && !Exists(path))
-            {
-                ALIMER_LOGERROR("Cannot open file for read as it doesn't exists");
-                return false;
-            }
+        return FileSystem::OpenFile(Path::Join(_rootDirectory, path), mode);
+    }
 
-            return UniquePtr<Stream>(new FileStream(Path::Join(_rootDirectory, path), mode));
-        }
+    bool OSFileSystemProtocol::SetChangeCallback(const FileWatcher::Callback& callback)
+    {
+        DirectoryIndex* index = GetIndex();
+        if (!index)
+            return false;
+
+        index->SetChangeCallback(callback);
+        return true;
+    }
+
+    bool OSFileSystemProtocol::IsReportingChanges() const
+    {
+        return _index && _index->IsLive();
+    }
+
+    DirectoryIndex* OSFileSystemProtocol::GetIndex()
+    {
+        if (!_indexed || !FileWatcher::IsSupported())
+            return nullptr;
+
+        std::call_once(_indexFlag, [this]()
+        {
+            _index.Reset(new DirectoryIndex());
+            _index->Build(_rootDirectory);
+        });
 
-    protected:
-        String _rootDirectory;
-    };
+        return _index->IsLive() ? _index.Get() : nullptr;
+    }
 
     FileSystem::FileSystem()
     {
@@ -73,7 +125,7 @@ namespace Alimer
         // Lookup assets folder at executable path first.
         if (DirectoryExists("assets"))
         {
-            RegisterProtocol("assets", new OSFileSystemProtocol("assets"));
+            RegisterProtocol("assets", new OSFileSystemProtocol("assets", true));
         }
 #ifdef ALIMER_DEFAULT_ASSETS_DIRECTORY
         else
@@ -82,7 +134,7 @@ namespace Alimer
             const char *assetsDir = ALIMER_DEFAULT_ASSETS_DIRECTORY;
             if (assetsDir)
             {
-                RegisterProtocol("assets", new OSFileSystemProtocol(assetsDir));
+                RegisterProtocol("assets", new OSFileSystemProtocol(assetsDir, true));
             }
         }
 #endif // ALIMER_DEFAULT_ASSETS_DIRECTORY
@@ -122,6 +174,100 @@ namespace Alimer
         return backend->Exists(paths.second);
     }
 
+    UniquePtr<Stream> FileSystem::OpenFile(const String& fileName, FileAccess mode)
+    {
+        if (mode == FileAccess::ReadOnly
+            && Get().GetMemoryMapping())
+        {
+            UniquePtr<MappedFileStream> mappedStream(new MappedFileStream(fileName));
+            if (mappedStream->IsOpen())
+            {
+                return UniquePtr<Stream>(mappedStream.Detach());
+            }
+        }
+
+        return UniquePtr<Stream>(new FileStream(fileName, mode));
+    }
+
+    String FileSystem::ResolvePath(const String& path)
+    {
+        auto paths = Path::ProtocolSplit(path);
+        auto *backend = GetProcotol(paths.first);
+        if (!backend)
+            return {};
+
+        return backend->GetFileSystemPath(paths.second);
+    }
+
+    AsyncFileIO& FileSystem::GetAsyncIO()
+    {
+        std::lock_guard<std::mutex> lock(_asyncIOMutex);
+        if (!_asyncIO)
+        {
+            _asyncIO.Reset(new AsyncFileIO());
+            ALIMER_LOGDEBUGF("Asynchronous I/O using %s backend", _asyncIO->GetBackendName());
+        }
+
+        return *_asyncIO;
+    }
+
+    void FileSystem::ReadAsync(const String& path, uint64_t offset, uint64_t size, AsyncReadCallback callback, WorkPriority priority)
+    {
+        AsyncReadRequest request;
+        request.fileName = path;
+        request.offset = offset;
+        request.size = size;
+        request.priority = priority;
+        request.callback = std::move(callback);
+
+        std::vector<AsyncReadRequest> requests;
+        requests.push_back(std::move(request));
+        ReadAsync(requests);
+    }
+
+    std::future<AsyncReadResult> FileSystem::ReadAsync(const String& path, uint64_t offset, uint64_t size, WorkPriority priority)
+    {
+        auto promise = std::make_shared<std::promise<AsyncReadResult>>();
+        std::future<AsyncReadResult> future = promise->get_future();
+        ReadAsync(path, offset, size, [promise](AsyncReadResult& result) {
+            promise->set_value(std::move(result));
+        }, priority);
+
+        return future;
+    }
+
+    void FileSystem::ReadAsync(std::vector<AsyncReadRequest>& requests)
+    {
+        for (AsyncReadRequest& request : requests)
+        {
+            String fileName = ResolvePath(request.fileName);
+            if (fileName.IsEmpty())
+            {
+                // Not backed by native files, report failure right away.
+                AsyncReadResult result;
+                result.fileName = request.fileName;
+                result.offset = request.offset;
+                if (request.callback)
+                    request.callback(result);
+
+                request.callback = nullptr;
+            }
+
+            request.fileName = fileName;
+        }
+
+        requests.erase(std::remove_if(requests.begin(), requests.end(), [](const AsyncReadRequest& request) {
+            return request.fileName.IsEmpty();
+        }), requests.end());
+
+        GetAsyncIO().Submit(requests);
+    }
+
+    void FileSystem::SetMemoryMapping(bool enable)
+    {
+        _memoryMapping = enable;
+    }
+
     UniquePtr<Stream> FileSystem::Open(const String &path, FileAccess mode)
     {
         auto paths = Path::ProtocolSplit(path);
@@ -269,6 +415,10 @@ namespace Alimer
     // File
     bool FileSystem::FileExists(const String& fileName)
     {
+        bool exists;
+        if (DirectoryIndex::LookupFile(fileName, exists))
+            return exists;
+
         String fixedName = GetNativePath(RemoveTrailingSlash(fileName));
 
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
@@ -295,6 +445,10 @@ namespace Alimer
             return true;
 #endif
 
+        bool exists;
+        if (DirectoryIndex::LookupDirectory(path, exists))
+            return exists;
+
         String fixedName = GetNativePath(RemoveTrailingSlash(path));
 
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
@@ -322,6 +476,87 @@ namespace Alimer
 #endif
     }
 
+    bool FileSystem::Copy(const String& srcFileName, const String& destFileName)
+    {
+        FileStream srcFile(srcFileName, FileAccess::ReadOnly);
+        if (!srcFile.IsOpen())
+            return false;
+
+        FileStream destFile(destFileName, FileAccess::WriteOnly);
+        if (!destFile.IsOpen())
+            return false;
+
+        std::vector<uint8_t> buffer(64 * 1024);
+        size_t bytesRead;
+        while ((bytesRead = srcFile.Read(buffer.data(), buffer.size())) > 0)
+        {
+            if (destFile.Write(buffer.data(), bytesRead) != bytesRead)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool FileSystem::Delete(const String& fileName)
+    {
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        return DeleteFileW(GetWideNativePath(fileName).CString()) != 0;
+#else
+        return remove(GetNativePath(fileName).CString()) == 0;
+#endif
+    }
+
+    bool FileSystem::Rename(const String& srcFileName, const String& destFileName)
+    {
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        return MoveFileExW(GetWideNativePath(srcFileName).CString(), GetWideNativePath(destFileName).CString(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return rename(GetNativePath(srcFileName).CString(), GetNativePath(destFileName).CString()) == 0;
+#endif
+    }
+
+    uint64_t FileSystem::GetLastModifiedTime(const String& fileName)
+    {
+        if (fileName.IsEmpty())
+            return 0;
+
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(GetWideNativePath(fileName).CString(), GetFileExInfoStandard, &data))
+            return 0;
+
+        // Convert from 100 ns intervals since 1601 to seconds since 1970.
+        ULARGE_INTEGER time;
+        time.LowPart = data.ftLastWriteTime.dwLowDateTime;
+        time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+        return (time.QuadPart - 116444736000000000ULL) / 10000000ULL;
+#else
+        struct stat st;
+        if (stat(fileName.CString(), &st) != 0)
+            return 0;
+
+        return static_cast<uint64_t>(st.st_mtime);
+#endif
+    }
+
+    bool FileSystem::SetLastModifiedTime(const String& fileName, uint64_t newTime)
+    {
+        if (fileName.IsEmpty())
+            return false;
+
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        struct _utimbuf newTimes;
+        newTimes.actime = static_cast<time_t>(newTime);
+        newTimes.modtime = static_cast<time_t>(newTime);
+        return _wutime(GetWideNativePath(fileName).CString(), &newTimes) == 0;
+#else
+        struct utimbuf newTimes;
+        newTimes.actime = static_cast<time_t>(newTime);
+        newTimes.modtime = static_cast<time_t>(newTime);
+        return utime(fileName.CString(), &newTimes) == 0;
+#endif
+    }
+
     String FileSystem::GetCurrentDirectory()
     {
 #if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
@@ -420,7 +655,81 @@ namespace Alimer
         }
     }
 
-    void ScanDirectory(
+    void ScanNativeDirectory(
+        std::vector<String>& result,
+        const String& pathName,
+        const String& filter,
+        ScanDirFlags flags, bool recursive)
+    {
+        result.clear();
+
+        String initialPath = AddTrailingSlash(pathName);
+        ScanDirInternal(result, initialPath, initialPath, filter, flags, recursive);
+    }
+#else
+    void ScanDirInternal(
+        std::vector<String>& result, String path, const String& startPath,
+        const String& filter, ScanDirFlags flags, bool recursive)
+    {
+        path = AddTrailingSlash(path);
+        String deltaPath;
+        if (path.Length() > startPath.Length())
+            deltaPath = path.Substring(startPath.Length());
+
+        String filterExtension = filter.Substring(filter.FindLast('.'));
+        if (filterExtension.Find('*') != String::NPOS)
+        {
+            filterExtension.Clear();
+        }
+
+        DIR* dir = opendir(path.CString());
+        if (!dir)
+            return;
+
+        while (dirent* de = readdir(dir))
+        {
+            String fileName(de->d_name);
+            if (fileName == "." || fileName == "..")
+                continue;
+
+            if (fileName[0] == '.' && !any(flags & ScanDirFlags::Hidden))
+                continue;
+
+            String pathAndName = path + fileName;
+
+            // Directory entry type avoids a stat call per entry when the file system provides it.
+            bool isDirectory = de->d_type == DT_DIR;
+            if (de->d_type == DT_UNKNOWN || de->d_type == DT_LNK)
+            {
+                struct stat st;
+                if (stat(pathAndName.CString(), &st) != 0)
+                    continue;
+                isDirectory = S_ISDIR(st.st_mode);
+            }
+
+            if (isDirectory)
+            {
+                if (any(flags & ScanDirFlags::Directories))
+                    result.push_back(deltaPath + fileName);
+                if (recursive)
+                {
+                    ScanDirInternal(result, pathAndName, startPath, filter, flags, recursive);
+                }
+            }
+            else if (any(flags & ScanDirFlags::Files))
+            {
+                if (filterExtension.IsEmpty()
+                    || fileName.EndsWith(filterExtension))
+                {
+                    result.push_back(deltaPath + fileName);
+                }
+            }
+        }
+
+        closedir(dir);
+    }
+
+    void ScanNativeDirectory(
         std::vector<String>& result,
         const String& pathName,
         const String& filter,
@@ -432,4 +741,14 @@ namespace Alimer
         ScanDirInternal(result, initialPath, initialPath, filter, flags, recursive);
     }
 #endif
+
+    void ScanDirectory(
+        std::vector<String>& result,
+        const String& pathName,
+        const String& filter,
+        ScanDirFlags flags, bool recursive)
+    {
+        if (!DirectoryIndex::LookupScan(result, pathName, filter, flags, recursive))
+            ScanNativeDirectory(result, pathName, filter, flags, recursive);
+    }
 }
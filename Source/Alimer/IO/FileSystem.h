@@ -26,7 +26,11 @@
 #include "../Core/Ptr.h"
 #include "../Core/Platform.h"
 #include "../IO/FileStream.h"
+#include "../IO/AsyncFileIO.h"
+#include "../IO/FileWatcher.h"
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
 
 namespace Alimer
 {
@@ -56,8 +60,12 @@ namespace Alimer
     /// Return whether a path is absolute.
     ALIMER_API bool IsAbsolutePath(const String& pathName);
 
-    /// Scan a directory for specified files.
+    /// Scan a directory for specified files. Answered from memory when a live directory index contains the directory.
     ALIMER_API void ScanDirectory(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive);
+    /// Scan a directory for specified files on disk, bypassing directory indexes.
+    ALIMER_API void ScanNativeDirectory(std::vector<String>& result, const String& pathName, const String& filter, ScanDirFlags flags, bool recursive);
+
+    class DirectoryIndex;
 
     /// Backend protocol for file system.
     class ALIMER_API FileSystemProtocol
@@ -73,6 +81,18 @@ namespace Alimer
             return "";
         }
 
+        /// Set callback invoked on any thread when files change. Return true if all changes are reported, so that lookups can be cached.
+        inline virtual bool SetChangeCallback(const FileWatcher::Callback&)
+        {
+            return false;
+        }
+
+        /// Return whether changes are still reported after SetChangeCallback succeeded. Becomes false when watching fails, then lookups must not be cached.
+        inline virtual bool IsReportingChanges() const
+        {
+            return true;
+        }
+
         /// Gets the name.
         String GetName() const { return _name; }
 
@@ -83,6 +103,35 @@ namespace Alimer
         String _name;
     };
 
+    /// File system protocol for a native directory, optionally indexed in memory and watched for changes.
+    class ALIMER_API OSFileSystemProtocol final : public FileSystemProtocol
+    {
+    public:
+        /// Constructor. The index is built on first use.
+        OSFileSystemProtocol(const String& rootDirectory, bool indexed = false);
+
+        /// Destructor.
+        ~OSFileSystemProtocol() override;
+
+        String GetFileSystemPath(const String& path) override;
+        bool Exists(const String& path) override;
+        UniquePtr<Stream> Open(const String& path, FileAccess mode = FileAccess::ReadOnly) override;
+        bool SetChangeCallback(const FileWatcher::Callback& callback) override;
+        bool IsReportingChanges() const override;
+
+        /// Return root directory.
+        const String& GetRootDirectory() const { return _rootDirectory; }
+
+    private:
+        /// Return live directory index, built on first use.
+        DirectoryIndex* GetIndex();
+
+        String _rootDirectory;
+        bool _indexed;
+        UniquePtr<DirectoryIndex> _index;
+        std::once_flag _indexFlag;
+    };
+
     /// Class for accessing File system.
     class ALIMER_API FileSystem
     {
@@ -101,15 +150,30 @@ namespace Alimer
         /// Return the filename and extension from a full path. The case of the extension is preserved by default, so that the file can be opened in case-sensitive operating systems.
         static String GetFileNameAndExtension(const String& fileName, bool lowercaseExtension = false);
 
-        /// Check if a file exists.
+        /// Check if a file exists. Answered from memory when a live directory index contains the file.
         static bool FileExists(const String& fileName);
 
-        /// Check if a directory exists.
+        /// Check if a directory exists. Answered from memory when a live directory index contains the directory.
         static bool DirectoryExists(const String& path);
 
         /// Create a directory.
         static bool CreateDirectory(const String& path);
 
+        /// Copy a file, overwriting destination. Return true if successful.
+        static bool Copy(const String& srcFileName, const String& destFileName);
+
+        /// Delete a file. Return true if successful.
+        static bool Delete(const String& fileName);
+
+        /// Rename a file, replacing an existing destination. Return true if successful.
+        static bool Rename(const String& srcFileName, const String& destFileName);
+
+        /// Return last modification time of a file in seconds since 1970, or 0 if not found.
+        static uint64_t GetLastModifiedTime(const String& fileName);
+
+        /// Set last modification time of a file in seconds since 1970. Return true if successful.
+        static bool SetLastModifiedTime(const String& fileName, uint64_t newTime);
+
         /// Return the absolute current working directory.
         static String GetCurrentDirectory();
 
@@ -125,13 +189,40 @@ namespace Alimer
         /// Check if file exists.
         bool Exists(const String &path);
 
-        /// Open stream from given path with given access mode.
+        /// Open stream from given path with given access mode. Read-only files are memory mapped when enabled.
         UniquePtr<Stream> Open(const String &path, FileAccess mode = FileAccess::ReadOnly);
 
+        /// Open native file path, read-only files are memory mapped when enabled.
+        static UniquePtr<Stream> OpenFile(const String& fileName, FileAccess mode = FileAccess::ReadOnly);
+
+        /// Return native file name of path with optional protocol, or empty if protocol is not backed by native files.
+        String ResolvePath(const String& path);
+
+        /// Read file range asynchronously, size 0 reads until end of file. Callback is invoked on an I/O thread.
+        void ReadAsync(const String& path, uint64_t offset, uint64_t size, AsyncReadCallback callback, WorkPriority priority = WorkPriority::Normal);
+
+        /// Read file range asynchronously and return future of the result.
+        std::future<AsyncReadResult> ReadAsync(const String& path, uint64_t offset = 0, uint64_t size = 0, WorkPriority priority = WorkPriority::Normal);
+
+        /// Submit multiple reads at once, file names may use protocols. Requests are moved from.
+        void ReadAsync(std::vector<AsyncReadRequest>& requests);
+
+        /// Return asynchronous I/O service, created on first use.
+        AsyncFileIO& GetAsyncIO();
+
+        /// Set whether read-only files are opened as MappedFileStream.
+        void SetMemoryMapping(bool enable);
+
+        /// Return whether read-only files are opened as MappedFileStream.
+        bool GetMemoryMapping() const { return _memoryMapping; }
+
     private:
         FileSystem();
 
         std::unordered_map<String, UniquePtr<FileSystemProtocol>> _protocols;
+        std::atomic<bool> _memoryMapping{ true };
+        UniquePtr<AsyncFileIO> _asyncIO;
+        std::mutex _asyncIOMutex;
 
     private:
         DISALLOW_COPY_MOVE_AND_ASSIGN(FileSystem);
@@ -0,0 +1,274 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/FileWatcher.h"
+#include "../IO/FileSystem.h"
+#include "../Core/Log.h"
+
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Alimer
+{
+    FileWatcher::FileWatcher()
+        : _recursive(false)
+        , _watching(false)
+        , _notifyHandle(-1)
+        , _wakeHandle(-1)
+    {
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        StopWatching();
+    }
+
+    bool FileWatcher::IsSupported()
+    {
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool FileWatcher::StartWatching(const String& path, bool recursive, const Callback& callback)
+    {
+        StopWatching();
+
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+        _notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        _wakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_notifyHandle == -1 || _wakeHandle == -1)
+        {
+            ALIMER_LOGERRORF("Failed to initialize inotify for '%s'", path.CString());
+            StopWatching();
+            return false;
+        }
+
+        _path = AddTrailingSlash(path);
+        _recursive = recursive;
+        _callback = callback;
+        if (!AddWatch(String::EMPTY, false))
+        {
+            ALIMER_LOGERRORF("Failed to watch directory '%s'", path.CString());
+            StopWatching();
+            return false;
+        }
+
+        _watching = true;
+        _thread = std::thread(&FileWatcher::ThreadFunction, this);
+        ALIMER_LOGDEBUGF("Started watching directory '%s'", _path.CString());
+        return true;
+#else
+        ALIMER_UNUSED(recursive);
+        ALIMER_UNUSED(callback);
+        ALIMER_LOGWARNF("File watching is not supported on this platform, not watching '%s'", path.CString());
+        return false;
+#endif
+    }
+
+    void FileWatcher::StopWatching()
+    {
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+        if (_thread.joinable())
+        {
+            uint64_t value = 1;
+            ssize_t result = write(_wakeHandle, &value, sizeof(value));
+            ALIMER_UNUSED(result);
+            _thread.join();
+        }
+
+        if (_notifyHandle != -1)
+            close(_notifyHandle);
+        if (_wakeHandle != -1)
+            close(_wakeHandle);
+#endif
+
+        _notifyHandle = -1;
+        _wakeHandle = -1;
+        _watchDirs.clear();
+        _watching = false;
+    }
+
+    bool FileWatcher::AddWatch(const String& relativePath, bool reportContent)
+    {
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO
+            | IN_DELETE_SELF | IN_ONLYDIR;
+
+        int watch = inotify_add_watch(_notifyHandle, (_path + relativePath).CString(), mask);
+        if (watch == -1)
+        {
+            // A directory removed meanwhile is reported by its parent, any other failure loses changes.
+            const int error = errno;
+            if (!relativePath.IsEmpty() && (error == ENOENT || error == ENOTDIR))
+                return true;
+
+            ALIMER_LOGERRORF("Failed to watch directory '%s': %s", (_path + relativePath).CString(), strerror(error));
+            return false;
+        }
+
+        _watchDirs[watch] = relativePath;
+        if (!_recursive && !reportContent)
+            return true;
+
+        // Content created in a new directory before its watch was added is only found by scanning.
+        std::vector<String> entries;
+        if (reportContent)
+        {
+            ScanNativeDirectory(entries, _path + relativePath, "*", ScanDirFlags::Files | ScanDirFlags::Hidden, false);
+            for (const String& entry : entries)
+            {
+                _callback({ relativePath + entry, FileChangeType::Added, false });
+            }
+            entries.clear();
+        }
+
+        ScanNativeDirectory(entries, _path + relativePath, "*", ScanDirFlags::Directories | ScanDirFlags::Hidden, false);
+        for (const String& entry : entries)
+        {
+            if (entry == "." || entry == "..")
+                continue;
+
+            const String entryPath = relativePath + entry;
+            if (reportContent)
+                _callback({ entryPath, FileChangeType::Added, true });
+
+            if (_recursive && !AddWatch(entryPath + "/", reportContent))
+                return false;
+        }
+
+        return true;
+#else
+        ALIMER_UNUSED(relativePath);
+        ALIMER_UNUSED(reportContent);
+        return false;
+#endif
+    }
+
+    void FileWatcher::ThreadFunction()
+    {
+#if ALIMER_PLATFORM_LINUX || ALIMER_PLATFORM_ANDROID
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd fds[2] = { { _notifyHandle, POLLIN, 0 }, { _wakeHandle, POLLIN, 0 } };
+
+        // Set when changes can no longer be reported.
+        bool failed = false;
+        while (!failed)
+        {
+            // Block until there are events or stop is requested.
+            if (poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                ALIMER_LOGERRORF("Failed to wait for changes in '%s': %s", _path.CString(), strerror(errno));
+                failed = true;
+                break;
+            }
+
+            if (fds[1].revents)
+                return;
+
+            while (!failed)
+            {
+                const ssize_t length = read(_notifyHandle, buffer, sizeof(buffer));
+                if (length <= 0)
+                    break;
+
+                for (const char* ptr = buffer; ptr < buffer + length && !failed;)
+                {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + event->len;
+
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        // Directories created meanwhile may lack watches, add them before the listener rescans.
+                        ALIMER_LOGWARNF("File watcher event queue overflow in '%s', rescanning", _path.CString());
+                        failed = !AddWatch(String::EMPTY, false);
+                        if (!failed)
+                            _callback({ String::EMPTY, FileChangeType::Rescan, true });
+                        continue;
+                    }
+
+                    auto it = _watchDirs.find(event->wd);
+                    if (it == _watchDirs.end())
+                        continue;
+
+                    if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+                    {
+                        // Nothing more is reported once the watched directory itself is gone.
+                        if (it->second.IsEmpty())
+                            failed = true;
+                        else if (event->mask & IN_IGNORED)
+                            _watchDirs.erase(it);
+                        continue;
+                    }
+
+                    if (!event->len)
+                        continue;
+
+                    const String fileName = it->second + String(event->name);
+                    const bool directory = (event->mask & IN_ISDIR) != 0;
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        _callback({ fileName, FileChangeType::Added, directory });
+                        if (directory && _recursive && !AddWatch(fileName + "/", true))
+                            failed = true;
+                    }
+                    else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                    {
+                        _callback({ fileName, FileChangeType::Removed, directory });
+
+                        // Watches of a directory moved elsewhere stay active, remove them.
+                        if (directory && (event->mask & IN_MOVED_FROM))
+                        {
+                            const String prefix = fileName + "/";
+                            for (auto& watchDir : _watchDirs)
+                            {
+                                if (watchDir.second.StartsWith(prefix))
+                                    inotify_rm_watch(_notifyHandle, watchDir.first);
+                            }
+                        }
+                    }
+                    else if (event->mask & (IN_MODIFY | IN_CLOSE_WRITE))
+                    {
+                        _callback({ fileName, FileChangeType::Modified, directory });
+                    }
+                }
+            }
+        }
+
+        // Listeners fall back to the file system once changes are no longer reported.
+        _watching = false;
+        ALIMER_LOGWARNF("Stopped watching directory '%s'", _path.CString());
+        _callback({ String::EMPTY, FileChangeType::Rescan, true });
+#endif
+    }
+}
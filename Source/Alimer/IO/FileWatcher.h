@@ -0,0 +1,106 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/String.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+
+namespace Alimer
+{
+    /// Type of file system change.
+    enum class FileChangeType
+    {
+        Added,
+        Modified,
+        Removed,
+        /// Changes may have been lost, everything under the watched directory must be rescanned. The file name is empty.
+        Rescan
+    };
+
+    /// File system change notification.
+    struct FileChange
+    {
+        /// File or directory name relative to the watched directory.
+        String fileName;
+        /// Change type.
+        FileChangeType type;
+        /// Whether the change is for a directory.
+        bool directory;
+    };
+
+    /// Watches a directory for changes on a background thread, blocking without polling while idle.
+    class ALIMER_API FileWatcher final
+    {
+    public:
+        using Callback = std::function<void(const FileChange& change)>;
+
+        /// Constructor.
+        FileWatcher();
+
+        /// Destructor. Stop watching.
+        ~FileWatcher();
+
+        /// Start watching a directory. Callback is invoked on the watcher thread. Return true on success.
+        bool StartWatching(const String& path, bool recursive, const Callback& callback);
+
+        /// Stop watching and join the watcher thread.
+        void StopWatching();
+
+        /// Return watched directory.
+        const String& GetPath() const { return _path; }
+
+        /// Return whether is watching. Becomes false on the watcher thread when changes can no longer be reported, for example when the directory is removed or the watch limit is reached, after which a Rescan change is sent.
+        bool IsWatching() const { return _watching; }
+
+        /// Return whether file watching is supported on this platform.
+        static bool IsSupported();
+
+    private:
+        /// Watcher thread function.
+        void ThreadFunction();
+        /// Add watch for a directory relative to the watched root and its subdirectories when recursive, optionally reporting its existing content as added. Return false if a directory could not be watched.
+        bool AddWatch(const String& relativePath, bool reportContent);
+
+        /// Watched directory with trailing slash.
+        String _path;
+        /// Recursive flag.
+        bool _recursive;
+        /// Change callback.
+        Callback _callback;
+        /// Watcher thread.
+        std::thread _thread;
+        /// Watching flag.
+        std::atomic<bool> _watching;
+        /// Notification handle.
+        int _notifyHandle;
+        /// Handle used to wake the watcher thread for stopping.
+        int _wakeHandle;
+        /// Relative directory of each watch.
+        std::unordered_map<int, String> _watchDirs;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(FileWatcher);
+    };
+}
@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/MappedFileStream.h"
+#include "../Core/Log.h"
+#include <cstring>
+
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+#   include "../Core/Platform.h"
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+namespace Alimer
+{
+    MappedFileStream::MappedFileStream()
+        : _data(nullptr)
+        , _open(false)
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        , _fileHandle(INVALID_HANDLE_VALUE)
+        , _mappingHandle(nullptr)
+#endif
+    {
+    }
+
+    MappedFileStream::MappedFileStream(const String& fileName)
+        : _data(nullptr)
+        , _open(false)
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        , _fileHandle(INVALID_HANDLE_VALUE)
+        , _mappingHandle(nullptr)
+#endif
+    {
+        Open(fileName);
+    }
+
+    MappedFileStream::~MappedFileStream()
+    {
+        Close();
+    }
+
+    bool MappedFileStream::Open(const String& fileName)
+    {
+        Close();
+
+        if (fileName.IsEmpty())
+            return false;
+
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        _fileHandle = CreateFileW(
+            WString(fileName).CString(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (_fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_fileHandle, &size))
+        {
+            ALIMER_LOGERROR("[Win32] - GetFileSizeEx: failed");
+            Close();
+            return false;
+        }
+
+        _size = static_cast<size_t>(size.QuadPart);
+        if (_size > 0)
+        {
+            _mappingHandle = CreateFileMappingW(_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!_mappingHandle)
+            {
+                Close();
+                return false;
+            }
+
+            _data = static_cast<const uint8_t*>(MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+            if (!_data)
+            {
+                Close();
+                return false;
+            }
+        }
+#else
+        int fd = open(fileName.CString(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0
+            || !S_ISREG(st.st_mode))
+        {
+            close(fd);
+            return false;
+        }
+
+        _size = static_cast<size_t>(st.st_size);
+        if (_size > 0)
+        {
+            void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED)
+            {
+                close(fd);
+                _size = 0;
+                return false;
+            }
+
+            // Loaders mostly read front to back, let the kernel read ahead aggressively.
+            madvise(data, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const uint8_t*>(data);
+        }
+
+        // Mapping keeps its own reference to the file.
+        close(fd);
+#endif
+
+        _name = fileName;
+        _position = 0;
+        _open = true;
+        return true;
+    }
+
+    void MappedFileStream::Close()
+    {
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        if (_data)
+        {
+            UnmapViewOfFile(_data);
+        }
+
+        if (_mappingHandle)
+        {
+            CloseHandle(_mappingHandle);
+            _mappingHandle = nullptr;
+        }
+
+        if (_fileHandle != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(_fileHandle);
+            _fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (_data)
+        {
+            munmap(const_cast<uint8_t*>(_data), _size);
+        }
+#endif
+
+        _data = nullptr;
+        _open = false;
+        _position = 0;
+        _size = 0;
+    }
+
+    bool MappedFileStream::CanRead() const
+    {
+        return _open;
+    }
+
+    bool MappedFileStream::CanWrite() const
+    {
+        return false;
+    }
+
+    bool MappedFileStream::CanSeek() const
+    {
+        return _open;
+    }
+
+    size_t MappedFileStream::Read(void* dest, size_t size)
+    {
+        if (size + _position > _size)
+        {
+            size = _size - _position;
+        }
+
+        if (!size)
+            return 0;
+
+        memcpy(dest, _data + _position, size);
+        _position += size;
+        return size;
+    }
+
+    size_t MappedFileStream::Write(const void* data, size_t size)
+    {
+        ALIMER_UNUSED(data);
+        ALIMER_UNUSED(size);
+        ALIMER_LOGERROR("Cannot write to memory mapped file stream");
+        return 0;
+    }
+
+    bool MappedFileStream::Seek(size_t position)
+    {
+        if (!_open || position > _size)
+            return false;
+
+        _position = position;
+        return true;
+    }
+
+    bool MappedFileStream::TryGetView(StreamView& view) const
+    {
+        if (!_open)
+            return false;
+
+        view.data = GetCurrentData();
+        view.size = _size - _position;
+        return true;
+    }
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/Stream.h"
+
+namespace Alimer
+{
+	/// Read-only stream over a memory mapped file, exposing its content without copying.
+	class ALIMER_API MappedFileStream : public Stream
+	{
+	public:
+		/// Constructor.
+        MappedFileStream();
+
+        /// Construct and map a file.
+        MappedFileStream(const String& fileName);
+
+        /// Destructor. Unmap the file if mapped.
+        ~MappedFileStream() override;
+
+        /// Map a file for reading. Return true on success.
+        bool Open(const String& fileName);
+
+        /// Unmap the file.
+        void Close();
+
+        bool CanRead() const override;
+        bool CanWrite() const override;
+        bool CanSeek() const override;
+
+		size_t Read(void* dest, size_t size) override;
+        size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+        bool TryGetView(StreamView& view) const override;
+
+        /// Return whether is open.
+        bool IsOpen() const { return _open; }
+
+        /// Return mapped file content, valid until the stream is closed. Null for empty files.
+        const uint8_t* GetData() const { return _data; }
+
+        /// Return mapped content at current position.
+        const uint8_t* GetCurrentData() const { return _data ? _data + _position : nullptr; }
+
+    private:
+        const uint8_t* _data;
+        bool _open;
+#if ALIMER_PLATFORM_WINDOWS || ALIMER_PLATFORM_UWP
+        void* _fileHandle;
+        void* _mappingHandle;
+#endif
+	};
+}
@@ -139,4 +139,23 @@ namespace Alimer
 
         return size;
     }
+
+    bool MemoryStream::Seek(size_t position)
+    {
+        if (!_buffer || position > _size)
+            return false;
+
+        _position = position;
+        return true;
+    }
+
+    bool MemoryStream::TryGetView(StreamView& view) const
+    {
+        if (!_buffer)
+            return false;
+
+        view.data = _buffer + _position;
+        view.size = _size - _position;
+        return true;
+    }
 }
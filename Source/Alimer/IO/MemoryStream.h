@@ -46,6 +46,8 @@ namespace Alimer
 
 		size_t Read(void* dest, size_t size) override;
         size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+        bool TryGetView(StreamView& view) const override;
 
         /// Return memory area.
         uint8_t* Data() { return _buffer; }
@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/PagedMemoryStream.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Alimer
+{
+    static std::vector<StreamBuffer> GetPageRanges(const std::vector<uint8_t*>& pages, size_t size, size_t pageSize)
+    {
+        std::vector<StreamBuffer> ranges;
+        ranges.reserve(pages.size());
+        for (size_t i = 0; i < pages.size() && size; ++i)
+        {
+            const size_t count = std::min(size, pageSize);
+            ranges.push_back({ pages[i], count });
+            size -= count;
+        }
+
+        return ranges;
+    }
+
+    MemoryPagePool::MemoryPagePool(size_t pageSize, size_t maxFreePages)
+        : _pageSize(pageSize)
+        , _maxFreePages(maxFreePages)
+    {
+        ALIMER_ASSERT(pageSize && !(pageSize & (pageSize - 1)));
+    }
+
+    MemoryPagePool::~MemoryPagePool()
+    {
+        Trim();
+    }
+
+    uint8_t* MemoryPagePool::Allocate()
+    {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (!_freePages.empty())
+            {
+                uint8_t* page = _freePages.back();
+                _freePages.pop_back();
+                return page;
+            }
+        }
+
+        return new uint8_t[_pageSize];
+    }
+
+    void MemoryPagePool::Free(uint8_t* page)
+    {
+        if (!page)
+            return;
+
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (_freePages.size() < _maxFreePages)
+            {
+                _freePages.push_back(page);
+                return;
+            }
+        }
+
+        delete[] page;
+    }
+
+    void MemoryPagePool::Trim()
+    {
+        std::vector<uint8_t*> pages;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            pages.swap(_freePages);
+        }
+
+        for (uint8_t* page : pages)
+        {
+            delete[] page;
+        }
+    }
+
+    size_t MemoryPagePool::GetNumFreePages() const
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _freePages.size();
+    }
+
+    MemoryPagePool& MemoryPagePool::GetDefault()
+    {
+        static MemoryPagePool pool;
+        return pool;
+    }
+
+    PagedBuffer::PagedBuffer()
+        : _pool(nullptr)
+        , _size(0)
+    {
+    }
+
+    PagedBuffer::PagedBuffer(PagedBuffer&& other) noexcept
+        : _pool(other._pool)
+        , _pages(std::move(other._pages))
+        , _size(other._size)
+    {
+        other._pages.clear();
+        other._size = 0;
+    }
+
+    PagedBuffer& PagedBuffer::operator =(PagedBuffer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            _pool = other._pool;
+            _pages = std::move(other._pages);
+            _size = other._size;
+            other._pages.clear();
+            other._size = 0;
+        }
+
+        return *this;
+    }
+
+    PagedBuffer::~PagedBuffer()
+    {
+        Reset();
+    }
+
+    void PagedBuffer::Reset()
+    {
+        for (uint8_t* page : _pages)
+        {
+            _pool->Free(page);
+        }
+
+        _pages.clear();
+        _size = 0;
+    }
+
+    std::vector<StreamBuffer> PagedBuffer::GetRanges() const
+    {
+        return _pool ? GetPageRanges(_pages, _size, _pool->GetPageSize()) : std::vector<StreamBuffer>();
+    }
+
+    void PagedBuffer::CopyTo(void* dest) const
+    {
+        uint8_t* destPtr = static_cast<uint8_t*>(dest);
+        for (const StreamBuffer& range : GetRanges())
+        {
+            memcpy(destPtr, range.data, range.size);
+            destPtr += range.size;
+        }
+    }
+
+    PagedMemoryStream::PagedMemoryStream(MemoryPagePool& pool)
+        : _pool(pool)
+        , _pageShift(0)
+        , _pageMask(pool.GetPageSize() - 1)
+    {
+        while ((static_cast<size_t>(1) << _pageShift) < pool.GetPageSize())
+            ++_pageShift;
+
+        SetName("Memory");
+    }
+
+    PagedMemoryStream::~PagedMemoryStream()
+    {
+        Clear();
+    }
+
+    bool PagedMemoryStream::CanRead() const
+    {
+        return true;
+    }
+
+    bool PagedMemoryStream::CanWrite() const
+    {
+        return true;
+    }
+
+    bool PagedMemoryStream::CanSeek() const
+    {
+        return true;
+    }
+
+    size_t PagedMemoryStream::Read(void* dest, size_t size)
+    {
+        if (size > _size - _position)
+            size = _size - _position;
+
+        uint8_t* destPtr = static_cast<uint8_t*>(dest);
+        size_t remaining = size;
+        while (remaining)
+        {
+            const size_t pageOffset = _position & _pageMask;
+            const size_t count = std::min(remaining, _pageMask + 1 - pageOffset);
+            memcpy(destPtr, _pages[_position >> _pageShift] + pageOffset, count);
+            destPtr += count;
+            _position += count;
+            remaining -= count;
+        }
+
+        return size;
+    }
+
+    size_t PagedMemoryStream::Write(const void* data, size_t size)
+    {
+        if (!size)
+            return 0;
+
+        Reserve(_position + size);
+
+        const uint8_t* srcPtr = static_cast<const uint8_t*>(data);
+        size_t remaining = size;
+        while (remaining)
+        {
+            const size_t pageOffset = _position & _pageMask;
+            const size_t count = std::min(remaining, _pageMask + 1 - pageOffset);
+            memcpy(_pages[_position >> _pageShift] + pageOffset, srcPtr, count);
+            srcPtr += count;
+            _position += count;
+            remaining -= count;
+        }
+
+        if (_position > _size)
+            _size = _position;
+
+        return size;
+    }
+
+    bool PagedMemoryStream::Seek(size_t position)
+    {
+        if (position > _size)
+            return false;
+
+        _position = position;
+        return true;
+    }
+
+    bool PagedMemoryStream::TryGetView(StreamView& view) const
+    {
+        // Only when the remaining content does not cross a page boundary.
+        if (_position < _size && (_position >> _pageShift) != ((_size - 1) >> _pageShift))
+            return false;
+
+        view.data = _position < _size ? _pages[_position >> _pageShift] + (_position & _pageMask) : nullptr;
+        view.size = _size - _position;
+        return true;
+    }
+
+    void PagedMemoryStream::Reserve(size_t size)
+    {
+        const size_t numPages = (size + _pageMask) >> _pageShift;
+        while (_pages.size() < numPages)
+        {
+            _pages.push_back(_pool.Allocate());
+        }
+    }
+
+    void PagedMemoryStream::Clear()
+    {
+        for (uint8_t* page : _pages)
+        {
+            _pool.Free(page);
+        }
+
+        _pages.clear();
+        _position = 0;
+        _size = 0;
+    }
+
+    PagedBuffer PagedMemoryStream::Detach()
+    {
+        // Pages past the end of data were only reserved.
+        const size_t usedPages = (_size + _pageMask) >> _pageShift;
+        while (_pages.size() > usedPages)
+        {
+            _pool.Free(_pages.back());
+            _pages.pop_back();
+        }
+
+        PagedBuffer buffer;
+        buffer._pool = &_pool;
+        buffer._pages.swap(_pages);
+        buffer._size = _size;
+
+        _position = 0;
+        _size = 0;
+        return buffer;
+    }
+
+    size_t PagedMemoryStream::CopyTo(Stream& dest) const
+    {
+        std::vector<StreamBuffer> ranges = GetRanges();
+        return dest.WriteGather(ranges.data(), ranges.size());
+    }
+
+    std::vector<StreamBuffer> PagedMemoryStream::GetRanges() const
+    {
+        return GetPageRanges(_pages, _size, _pool.GetPageSize());
+    }
+}
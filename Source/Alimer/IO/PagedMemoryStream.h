@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/Stream.h"
+#include <mutex>
+
+namespace Alimer
+{
+    /// Default page size of memory page pools.
+    static constexpr size_t MEMORY_PAGE_DEFAULT_SIZE = 64 * 1024;
+
+    /// Thread-safe pool of fixed size memory pages. Must outlive the streams and buffers using it.
+    class ALIMER_API MemoryPagePool final
+    {
+    public:
+        /// Constructor. Page size must be power of two.
+        MemoryPagePool(size_t pageSize = MEMORY_PAGE_DEFAULT_SIZE, size_t maxFreePages = 256);
+
+        /// Destructor. Frees cached pages.
+        ~MemoryPagePool();
+
+        /// Allocate a page.
+        uint8_t* Allocate();
+
+        /// Return a page to the pool.
+        void Free(uint8_t* page);
+
+        /// Release all cached free pages.
+        void Trim();
+
+        /// Return page size.
+        size_t GetPageSize() const { return _pageSize; }
+
+        /// Return number of cached free pages.
+        size_t GetNumFreePages() const;
+
+        /// Return the default pool.
+        static MemoryPagePool& GetDefault();
+
+    private:
+        /// Page size.
+        size_t _pageSize;
+        /// Maximum number of cached free pages.
+        size_t _maxFreePages;
+        /// Cached free pages.
+        std::vector<uint8_t*> _freePages;
+        /// Mutex for free pages.
+        mutable std::mutex _mutex;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(MemoryPagePool);
+    };
+
+    /// Data detached from a PagedMemoryStream, returned to the page pool on destruction.
+    class ALIMER_API PagedBuffer final
+    {
+        friend class PagedMemoryStream;
+
+    public:
+        /// Construct empty.
+        PagedBuffer();
+
+        /// Move-construct.
+        PagedBuffer(PagedBuffer&& other) noexcept;
+
+        /// Move-assign.
+        PagedBuffer& operator =(PagedBuffer&& other) noexcept;
+
+        /// Destructor. Return pages to the pool.
+        ~PagedBuffer();
+
+        /// Return pages to the pool and clear.
+        void Reset();
+
+        /// Return page memory ranges covering the data, for gathered writes.
+        std::vector<StreamBuffer> GetRanges() const;
+
+        /// Copy data into contiguous memory of at least GetSize() bytes.
+        void CopyTo(void* dest) const;
+
+        /// Return data size.
+        size_t GetSize() const { return _size; }
+
+        /// Return whether the data is in a single page and contiguous.
+        bool IsContiguous() const { return _pages.size() <= 1; }
+
+        /// Return first page, holding all data if contiguous.
+        const uint8_t* GetData() const { return _pages.empty() ? nullptr : _pages[0]; }
+
+    private:
+        /// Page pool.
+        MemoryPagePool* _pool;
+        /// Pages.
+        std::vector<uint8_t*> _pages;
+        /// Data size.
+        size_t _size;
+
+        PagedBuffer(const PagedBuffer&) = delete;
+        PagedBuffer& operator =(const PagedBuffer&) = delete;
+    };
+
+    /// Growable, self-owning memory stream. Grows by pooled pages without reallocating or copying existing data.
+    class ALIMER_API PagedMemoryStream final : public Stream
+    {
+    public:
+        /// Construct with a page pool.
+        PagedMemoryStream(MemoryPagePool& pool = MemoryPagePool::GetDefault());
+
+        /// Destructor. Return pages to the pool.
+        ~PagedMemoryStream() override;
+
+        bool CanRead() const override;
+        bool CanWrite() const override;
+        bool CanSeek() const override;
+
+        size_t Read(void* dest, size_t size) override;
+        size_t Write(const void* data, size_t size) override;
+        bool Seek(size_t position) override;
+        bool TryGetView(StreamView& view) const override;
+
+        /// Reserve pages for given size in bytes.
+        void Reserve(size_t size);
+
+        /// Clear content and return pages to the pool.
+        void Clear();
+
+        /// Detach written data without copying. The stream is empty afterwards.
+        PagedBuffer Detach();
+
+        /// Write content to another stream with a gathered write. Return number of bytes written.
+        size_t CopyTo(Stream& dest) const;
+
+        /// Return page memory ranges covering the data, valid until the stream is modified.
+        std::vector<StreamBuffer> GetRanges() const;
+
+    private:
+        /// Page pool.
+        MemoryPagePool& _pool;
+        /// Pages.
+        std::vector<uint8_t*> _pages;
+        /// Page size shift.
+        uint32_t _pageShift;
+        /// Page offset mask.
+        size_t _pageMask;
+    };
+}
@@ -75,6 +75,25 @@ namespace Alimer
 		return result;
 	}
 
+    size_t Stream::WriteGather(const StreamBuffer* buffers, size_t count)
+    {
+        size_t written = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const size_t size = Write(buffers[i].data, buffers[i].size);
+            written += size;
+            if (size != buffers[i].size)
+                break;
+        }
+
+        return written;
+    }
+
+    bool Stream::TryGetView(MAYBE_UNUSED StreamView& view) const
+    {
+        return false;
+    }
+
     void Stream::WriteUByte(uint8_t value)
     {
         Write(&value, sizeof value);
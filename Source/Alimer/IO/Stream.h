@@ -27,6 +27,25 @@
 
 namespace Alimer
 {
+    /// Memory range for gathered writes.
+    struct StreamBuffer
+    {
+        const void* data;
+        size_t size;
+    };
+
+    /// Contiguous read-only view of stream content.
+    struct StreamView
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+
+        /// Return start of the view.
+        const uint8_t* begin() const { return data; }
+        /// Return end of the view.
+        const uint8_t* end() const { return data + size; }
+    };
+
 	/// Abstract stream for reading and writing.
 	class ALIMER_API Stream
 	{
@@ -68,6 +87,15 @@ namespace Alimer
 		*/
 		virtual size_t Write(const void* data, size_t size) = 0;
 
+        /// Set position in bytes from the beginning of the stream. Return true if successful.
+        virtual bool Seek(size_t position) = 0;
+
+        /// Write multiple memory ranges in order. Return number of bytes actually written.
+        virtual size_t WriteGather(const StreamBuffer* buffers, size_t count);
+
+        /// Return content from the current position to the end without copying, if the stream holds it in contiguous memory. The view is valid until the stream is modified or destroyed and does not advance the position.
+        virtual bool TryGetView(StreamView& view) const;
+
 		/// Read entire file as text.
 		String ReadAllText();
 
@@ -0,0 +1,416 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../IO/VirtualFileSystem.h"
+#include "../IO/MemoryStream.h"
+#include "../IO/Path.h"
+#include "../Core/Log.h"
+
+namespace Alimer
+{
+    namespace
+    {
+        /// Shared file data, initialized before the MemoryStream base.
+        struct MemoryFileData
+        {
+            MemoryFileData(const std::shared_ptr<const std::vector<uint8_t>>& data) : _data(data) {}
+
+            std::shared_ptr<const std::vector<uint8_t>> _data;
+        };
+
+        /// Read-only stream over a memory file, keeping its data alive while open.
+        class MemoryFileStream final : private MemoryFileData, public MemoryStream
+        {
+        public:
+            MemoryFileStream(const std::shared_ptr<const std::vector<uint8_t>>& data)
+                : MemoryFileData(data)
+                , MemoryStream(*_data)
+            {
+            }
+        };
+    }
+
+    void MemoryFileSystemProtocol::AddFile(const String& path, std::vector<uint8_t> data)
+    {
+        FileChangeType type = FileChangeType::Added;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            auto& file = _files[path];
+            if (file)
+                type = FileChangeType::Modified;
+
+            // Streams already open keep the previous data.
+            file = std::make_shared<const std::vector<uint8_t>>(std::move(data));
+        }
+
+        NotifyChange(path, type);
+    }
+
+    bool MemoryFileSystemProtocol::RemoveFile(const String& path)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            if (!_files.erase(path))
+                return false;
+        }
+
+        NotifyChange(path, FileChangeType::Removed);
+        return true;
+    }
+
+    bool MemoryFileSystemProtocol::Exists(const String& path)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        return _files.find(path) != _files.end();
+    }
+
+    UniquePtr<Stream> MemoryFileSystemProtocol::Open(const String& path, FileAccess mode)
+    {
+        if (mode != FileAccess::ReadOnly)
+        {
+            ALIMER_LOGERROR("Memory files can only be opened for reading");
+            return {};
+        }
+
+        std::lock_guard<std::mutex> guard(_mutex);
+        auto it = _files.find(path);
+        if (it == _files.end())
+            return {};
+
+        UniquePtr<Stream> stream(new MemoryFileStream(it->second));
+        stream->SetName(path);
+        return stream;
+    }
+
+    bool MemoryFileSystemProtocol::SetChangeCallback(const FileWatcher::Callback& callback)
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _changeCallback = callback;
+        return true;
+    }
+
+    void MemoryFileSystemProtocol::NotifyChange(const String& path, FileChangeType type)
+    {
+        FileWatcher::Callback callback;
+        {
+            std::lock_guard<std::mutex> guard(_mutex);
+            callback = _changeCallback;
+        }
+
+        if (callback)
+            callback({ path, type, false });
+    }
+
+    VirtualFileSystem::VirtualFileSystem()
+    {
+    }
+
+    VirtualFileSystem::~VirtualFileSystem()
+    {
+        // Stop change notifications before the cache goes away.
+        std::unique_lock<std::shared_timed_mutex> lock(_mountMutex);
+        std::vector<MountEntry> mounts;
+        mounts.swap(_mounts);
+        lock.unlock();
+    }
+
+    FileSystemProtocol* VirtualFileSystem::MountDirectory(const String& path, uint32_t priority)
+    {
+        if (!FileSystem::DirectoryExists(path))
+        {
+            ALIMER_LOGERRORF("Directory '%s' does not exists", path.CString());
+            return nullptr;
+        }
+
+        String directory = AddTrailingSlash(path);
+        if (!IsAbsolutePath(directory))
+            directory = AddTrailingSlash(Path::Join(FileSystem::GetCurrentDirectory(), directory));
+        directory = directory.Replaced("/./", "/").Trimmed();
+
+        return MountInternal(directory, new OSFileSystemProtocol(directory, true), directory, priority);
+    }
+
+    FileSystemProtocol* VirtualFileSystem::Mount(const String& name, FileSystemProtocol* mount, uint32_t priority)
+    {
+        return MountInternal(name, mount, String::EMPTY, priority);
+    }
+
+    FileSystemProtocol* VirtualFileSystem::MountInternal(const String& name, FileSystemProtocol* mount, const String& directory, uint32_t priority)
+    {
+        ALIMER_ASSERT(mount);
+
+        MountEntry entry;
+        entry.protocol.Reset(mount);
+        entry.protocol->SetName(name);
+        entry.directory = directory;
+
+        // Register for changes before the mount becomes visible, a directory index is built here.
+        entry.reportsChanges = mount->SetChangeCallback([this](const FileChange& change) {
+            OnMountChange(change);
+        });
+
+        {
+            std::lock_guard<std::shared_timed_mutex> lock(_mountMutex);
+            if (FindMount(name) == NO_MOUNT)
+            {
+                if (priority < _mounts.size())
+                    _mounts.insert(_mounts.begin() + priority, std::move(entry));
+                else
+                    _mounts.push_back(std::move(entry));
+
+                ClearCache();
+                ALIMER_LOGDEBUGF("Mounted '%s'", name.CString());
+                return mount;
+            }
+        }
+
+        // Destroyed outside the lock, a watcher thread may be delivering a change.
+        ALIMER_LOGERRORF("Mount '%s' already exists", name.CString());
+        return nullptr;
+    }
+
+    bool VirtualFileSystem::Unmount(const String& name)
+    {
+        UniquePtr<FileSystemProtocol> protocol;
+        {
+            std::lock_guard<std::shared_timed_mutex> lock(_mountMutex);
+            size_t index = FindMount(name);
+            if (index == NO_MOUNT)
+                return false;
+
+            protocol = std::move(_mounts[index].protocol);
+            _mounts.erase(_mounts.begin() + index);
+            ClearCache();
+        }
+
+        return true;
+    }
+
+    bool VirtualFileSystem::SetMountPriority(const String& name, uint32_t priority)
+    {
+        std::lock_guard<std::shared_timed_mutex> lock(_mountMutex);
+        size_t index = FindMount(name);
+        if (index == NO_MOUNT)
+            return false;
+
+        MountEntry entry = std::move(_mounts[index]);
+        _mounts.erase(_mounts.begin() + index);
+        if (priority < _mounts.size())
+            _mounts.insert(_mounts.begin() + priority, std::move(entry));
+        else
+            _mounts.push_back(std::move(entry));
+
+        ClearCache();
+        return true;
+    }
+
+    FileSystemProtocol* VirtualFileSystem::GetMount(const String& name) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        size_t index = FindMount(name);
+        return index != NO_MOUNT ? _mounts[index].protocol.Get() : nullptr;
+    }
+
+    size_t VirtualFileSystem::GetNumMounts() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        return _mounts.size();
+    }
+
+    std::vector<String> VirtualFileSystem::GetDirectories() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        std::vector<String> directories;
+        for (const MountEntry& entry : _mounts)
+        {
+            if (!entry.directory.IsEmpty())
+                directories.push_back(entry.directory);
+        }
+
+        return directories;
+    }
+
+    bool VirtualFileSystem::Exists(const String& name)
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        String resolvedName;
+        return Resolve(name, resolvedName) != NO_MOUNT;
+    }
+
+    UniquePtr<Stream> VirtualFileSystem::Open(const String& name)
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        String resolvedName;
+        size_t index = Resolve(name, resolvedName);
+        if (index == NO_MOUNT)
+            return {};
+
+        UniquePtr<Stream> stream = _mounts[index].protocol->Open(resolvedName);
+        if (stream && stream->GetName().IsEmpty())
+            stream->SetName(resolvedName);
+
+        return stream;
+    }
+
+    String VirtualFileSystem::GetFileSystemPath(const String& name)
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        String resolvedName;
+        size_t index = Resolve(name, resolvedName);
+        if (index == NO_MOUNT)
+            return String::EMPTY;
+
+        return _mounts[index].protocol->GetFileSystemPath(resolvedName);
+    }
+
+    String VirtualFileSystem::SanitateName(const String& name) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(_mountMutex);
+        return SanitateNameInternal(name);
+    }
+
+    void VirtualFileSystem::SetChangeCallback(const FileWatcher::Callback& callback)
+    {
+        std::lock_guard<std::mutex> guard(_cacheMutex);
+        _changeCallback = callback;
+    }
+
+    size_t VirtualFileSystem::Resolve(const String& name, String& resolvedName)
+    {
+        const StringHash key(name);
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> guard(_cacheMutex);
+            auto it = _cache.find(key);
+            if (it != _cache.end() && it->second.name == name)
+            {
+                resolvedName = it->second.resolvedName;
+                return it->second.mountIndex;
+            }
+
+            generation = _cacheGeneration;
+        }
+
+        resolvedName = SanitateNameInternal(name);
+        if (resolvedName.IsEmpty())
+            return NO_MOUNT;
+
+        // The result can be cached only if every mount searched reports its changes.
+        size_t index = NO_MOUNT;
+        bool cacheable = true;
+        for (size_t i = 0; i < _mounts.size(); ++i)
+        {
+            cacheable &= _mounts[i].reportsChanges && _mounts[i].protocol->IsReportingChanges();
+            if (_mounts[i].protocol->Exists(resolvedName))
+            {
+                index = i;
+                break;
+            }
+        }
+
+        if (cacheable)
+        {
+            std::lock_guard<std::mutex> guard(_cacheMutex);
+            if (generation == _cacheGeneration)
+                _cache[key] = { name, resolvedName, index };
+        }
+
+        return index;
+    }
+
+    String VirtualFileSystem::SanitateNameInternal(const String& name) const
+    {
+        // Sanitate unsupported constructs from the name
+        String sanitatedName = name.Replaced("../", "");
+        sanitatedName.Replace("./", "");
+
+        // If the path refers to one of the mounted directories, make the name relative to it
+        bool hasDirectories = false;
+        for (const MountEntry& entry : _mounts)
+            hasDirectories |= !entry.directory.IsEmpty();
+
+        if (hasDirectories)
+        {
+            String namePath = FileSystem::GetPath(sanitatedName);
+            // The executable does not move, avoid querying its location for every name.
+            static const String exePath = FileSystem::GetExecutableFolder().Replaced("/./", "/");
+            for (const MountEntry& entry : _mounts)
+            {
+                if (entry.directory.IsEmpty())
+                    continue;
+
+                String relativeDirectory = entry.directory;
+                if (relativeDirectory.StartsWith(exePath))
+                    relativeDirectory = relativeDirectory.Substring(exePath.Length());
+
+                if (namePath.StartsWith(entry.directory, false))
+                    namePath = namePath.Substring(entry.directory.Length());
+                else if (namePath.StartsWith(relativeDirectory, false))
+                    namePath = namePath.Substring(relativeDirectory.Length());
+            }
+
+            sanitatedName = namePath + FileSystem::GetFileNameAndExtension(sanitatedName);
+        }
+
+        return sanitatedName.Trimmed();
+    }
+
+    size_t VirtualFileSystem::FindMount(const String& name) const
+    {
+        for (size_t i = 0; i < _mounts.size(); ++i)
+        {
+            if (_mounts[i].protocol->GetName() == name)
+                return i;
+        }
+
+        return NO_MOUNT;
+    }
+
+    void VirtualFileSystem::OnMountChange(const FileChange& change)
+    {
+        FileWatcher::Callback callback;
+        {
+            std::lock_guard<std::mutex> guard(_cacheMutex);
+
+            // Modification does not change which mount provides a file.
+            if (change.type != FileChangeType::Modified)
+                ClearCacheInternal();
+
+            callback = _changeCallback;
+        }
+
+        if (callback)
+            callback(change);
+    }
+
+    void VirtualFileSystem::ClearCache()
+    {
+        std::lock_guard<std::mutex> guard(_cacheMutex);
+        ClearCacheInternal();
+    }
+
+    void VirtualFileSystem::ClearCacheInternal()
+    {
+        _cache.clear();
+        ++_cacheGeneration;
+    }
+}
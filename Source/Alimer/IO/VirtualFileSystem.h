@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/FileSystem.h"
+#include "../Base/StringHash.h"
+#include <memory>
+#include <shared_mutex>
+#include <vector>
+
+namespace Alimer
+{
+    /// Sets to priority so that a mount, package or file is pushed to the end of the search order.
+    static constexpr uint32_t PRIORITY_LAST = 0xffffffff;
+
+    /// File system protocol serving files from memory.
+    class ALIMER_API MemoryFileSystemProtocol final : public FileSystemProtocol
+    {
+    public:
+        /// Add or replace a file.
+        void AddFile(const String& path, std::vector<uint8_t> data);
+
+        /// Remove a file. Return true if it existed.
+        bool RemoveFile(const String& path);
+
+        bool Exists(const String& path) override;
+        UniquePtr<Stream> Open(const String& path, FileAccess mode = FileAccess::ReadOnly) override;
+        bool SetChangeCallback(const FileWatcher::Callback& callback) override;
+
+    private:
+        /// Invoke change callback.
+        void NotifyChange(const String& path, FileChangeType type);
+
+        /// File contents, shared with open streams.
+        std::unordered_map<String, std::shared_ptr<const std::vector<uint8_t>>> _files;
+        /// Change callback.
+        FileWatcher::Callback _changeCallback;
+        /// Mutex for the files and change callback.
+        std::mutex _mutex;
+    };
+
+    /// Virtual file system overlaying mounted directories, packages and memory files. Mounts earlier in the search order hide files of later mounts. Name resolutions are cached until mounts or their content change.
+    class ALIMER_API VirtualFileSystem final
+    {
+    public:
+        /// Constructor.
+        VirtualFileSystem();
+
+        /// Destructor.
+        ~VirtualFileSystem();
+
+        /// Mount a native directory, indexed and watched for changes when supported. Priority is the position in the search order. Return the mount or null on failure.
+        FileSystemProtocol* MountDirectory(const String& path, uint32_t priority = PRIORITY_LAST);
+
+        /// Mount a protocol under a unique name, taking ownership. Priority is the position in the search order. Return the mount or null if the name is in use.
+        FileSystemProtocol* Mount(const String& name, FileSystemProtocol* mount, uint32_t priority = PRIORITY_LAST);
+
+        /// Unmount and destroy a mount by name. Return true if it was mounted.
+        bool Unmount(const String& name);
+
+        /// Move a mount to a new position in the search order. Return true if it was mounted.
+        bool SetMountPriority(const String& name, uint32_t priority);
+
+        /// Return mount by name or null if not mounted.
+        FileSystemProtocol* GetMount(const String& name) const;
+
+        /// Return number of mounts.
+        size_t GetNumMounts() const;
+
+        /// Return mounted directories in search order.
+        std::vector<String> GetDirectories() const;
+
+        /// Check if a file exists in any mount.
+        bool Exists(const String& name);
+
+        /// Open a file from the first mount containing it.
+        UniquePtr<Stream> Open(const String& name);
+
+        /// Return native file name of a file, or empty if not found or not backed by a native file.
+        String GetFileSystemPath(const String& name);
+
+        /// Remove unsupported constructs from a file name, and make an absolute name relative to the mounted directory containing it.
+        String SanitateName(const String& name) const;
+
+        /// Set callback invoked on the watcher thread when a file in any mount changes.
+        void SetChangeCallback(const FileWatcher::Callback& callback);
+
+    private:
+        /// Mounted protocol.
+        struct MountEntry
+        {
+            /// Protocol.
+            UniquePtr<FileSystemProtocol> protocol;
+            /// Native root directory with trailing slash, empty if not a directory.
+            String directory;
+            /// Whether the protocol reports all changes to its files.
+            bool reportsChanges;
+        };
+
+        /// Cached name resolution.
+        struct CacheEntry
+        {
+            /// Requested name.
+            String name;
+            /// Sanitated name.
+            String resolvedName;
+            /// Index of the mount containing the file, or NO_MOUNT.
+            size_t mountIndex;
+        };
+
+        /// Mount a protocol with its native root directory, if any.
+        FileSystemProtocol* MountInternal(const String& name, FileSystemProtocol* mount, const String& directory, uint32_t priority);
+        /// Resolve a name to a mount index and sanitated name. Must be called with the mount mutex held.
+        size_t Resolve(const String& name, String& resolvedName);
+        /// Sanitate name. Must be called with the mount mutex held.
+        String SanitateNameInternal(const String& name) const;
+        /// Return mount index by name or NO_MOUNT. Must be called with the mount mutex held.
+        size_t FindMount(const String& name) const;
+        /// Handle a change reported by a mount.
+        void OnMountChange(const FileChange& change);
+        /// Discard cached resolutions.
+        void ClearCache();
+        /// Discard cached resolutions. Must be called with the cache mutex held.
+        void ClearCacheInternal();
+
+        /// Index for names not found in any mount.
+        static constexpr size_t NO_MOUNT = ~static_cast<size_t>(0);
+
+        /// Mounts in search order.
+        std::vector<MountEntry> _mounts;
+        /// Mutex for the mounts, shared by lookups.
+        mutable std::shared_timed_mutex _mountMutex;
+        /// Cached resolutions by requested name hash.
+        std::unordered_map<StringHash, CacheEntry> _cache;
+        /// Incremented when the cache is cleared, so that resolutions racing with a change are not cached.
+        uint64_t _cacheGeneration{ 0 };
+        /// Change callback.
+        FileWatcher::Callback _changeCallback;
+        /// Mutex for the cache and change callback.
+        std::mutex _cacheMutex;
+
+    private:
+        DISALLOW_COPY_MOVE_AND_ASSIGN(VirtualFileSystem);
+    };
+}
@@ -22,9 +22,84 @@
 
 #include "../Renderer/Mesh.h"
 #include "../Graphics/GraphicsDevice.h"
+#include "../Resource/CookedAsset.h"
+#include "../Core/Log.h"
 
 namespace Alimer
 {
+    /// Cooked mesh description, followed by the vertex and index data.
+    struct CookedMeshInfo
+    {
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        uint32_t indexCount;
+        uint32_t indexStride;
+        uint32_t attributeFormats[ecast(MeshAttribute::Count)];
+        uint32_t attributeOffsets[ecast(MeshAttribute::Count)];
+    };
+
+    bool CookedMesh::Save(Stream& dest, uint64_t sourceHash) const
+    {
+        CookedMeshInfo info;
+        info.vertexCount = vertexCount;
+        info.vertexStride = vertexStride;
+        info.indexCount = indexCount;
+        info.indexStride = indexStride;
+        for (unsigned i = 0; i < ecast(MeshAttribute::Count); ++i)
+        {
+            info.attributeFormats[i] = ecast(attributes[i].format);
+            info.attributeOffsets[i] = attributes[i].offset;
+        }
+
+        CookedAssetWriter writer(dest);
+        return writer.WriteHeader(CookedAssetType::Mesh, sourceHash)
+            && writer.Write(info)
+            && writer.WriteData(vertexData.data(), vertexData.size())
+            && writer.WriteData(indexData.data(), indexData.size());
+    }
+
+    bool CookedMesh::Load(CookedAssetReader& reader)
+    {
+        CookedMeshInfo info;
+        if (!reader.ReadHeader(CookedAssetType::Mesh) || !reader.Read(info))
+            return false;
+
+        if (!info.vertexStride || (info.indexStride != 2 && info.indexStride != 4))
+            return false;
+
+        const size_t vertexSize = static_cast<size_t>(info.vertexCount) * info.vertexStride;
+        const size_t indexSize = static_cast<size_t>(info.indexCount) * info.indexStride;
+        const uint8_t* vertices = reader.ReadData(vertexSize);
+        const uint8_t* indices = vertices ? reader.ReadData(indexSize) : nullptr;
+        if (!indices)
+            return false;
+
+        for (unsigned i = 0; i < ecast(MeshAttribute::Count); ++i)
+        {
+            if (info.attributeFormats[i] >= ecast(VertexFormat::Count))
+                return false;
+
+            // Used attributes must lie within the vertex, the GPU would read past it otherwise.
+            const VertexFormat format = static_cast<VertexFormat>(info.attributeFormats[i]);
+            if (format != VertexFormat::Invalid
+                && static_cast<uint64_t>(info.attributeOffsets[i]) + GetVertexFormatSize(format) > info.vertexStride)
+            {
+                return false;
+            }
+
+            attributes[i].format = format;
+            attributes[i].offset = info.attributeOffsets[i];
+        }
+
+        vertexCount = info.vertexCount;
+        vertexStride = info.vertexStride;
+        indexCount = info.indexCount;
+        indexStride = info.indexStride;
+        vertexData.assign(vertices, vertices + vertexSize);
+        indexData.assign(indices, indices + indexSize);
+        return true;
+    }
+
     Mesh::Mesh()
     {
         
@@ -82,6 +157,49 @@ namespace Alimer
         return true;
     }
 
+    bool Mesh::Define(const CookedMesh& data)
+    {
+        GraphicsDevice* device = Object::GetSubsystem<GraphicsDevice>();
+        if (!device)
+        {
+            ALIMER_LOGERROR("Can not define mesh without graphics device");
+            return false;
+        }
+
+        SafeDelete(_vertexBuffer);
+        SafeDelete(_indexBuffer);
+
+        for (unsigned i = 0; i < ecast(MeshAttribute::Count); ++i)
+            _attributes[i] = data.attributes[i];
+
+        _device = device;
+        _vertexCount = data.vertexCount;
+        _vertexStride = data.vertexStride;
+        _indexCount = data.indexCount;
+        _indexStride = data.indexStride;
+
+        BufferDescriptor vertexBufferDesc = {};
+        vertexBufferDesc.resourceUsage = ResourceUsage::Default;
+        vertexBufferDesc.usage = BufferUsage::Vertex;
+        vertexBufferDesc.size = data.vertexData.size();
+        vertexBufferDesc.stride = _vertexStride;
+        _vertexBuffer = device->CreateBuffer(&vertexBufferDesc, data.vertexData.data());
+
+        if (_indexCount)
+        {
+            BufferDescriptor indexBufferDesc = {};
+            indexBufferDesc.resourceUsage = ResourceUsage::Default;
+            indexBufferDesc.usage = BufferUsage::Index;
+            indexBufferDesc.size = data.indexData.size();
+            indexBufferDesc.stride = _indexStride;
+            _indexBuffer = device->CreateBuffer(&indexBufferDesc, data.indexData.data());
+        }
+
+        // The vertex and index data live only in the GPU buffers.
+        SetGpuMemoryUse(data.vertexData.size() + data.indexData.size());
+        return _vertexBuffer != nullptr;
+    }
+
     void Mesh::SetVertexData(const void* vertexData, uint32_t vertexStart, uint32_t vertexCount)
     {
         if (vertexStart == 0
@@ -190,4 +308,36 @@ namespace Alimer
         newMesh->Define(positions, colors, indices);
         return newMesh;
     }
+
+    StringHash MeshLoader::GetType() const
+    {
+        return Mesh::GetTypeStatic();
+    }
+
+    ResourceLoader* MeshLoader::CreateInstance() const
+    {
+        return new MeshLoader();
+    }
+
+    bool MeshLoader::BeginLoad(Stream& source)
+    {
+        CookedAssetReader reader(source);
+        if (!_data.Load(reader))
+        {
+            ALIMER_LOGERRORF("Mesh '%s' is not a cooked mesh", _fileName.CString());
+            return false;
+        }
+
+        return true;
+    }
+
+    Object* MeshLoader::EndLoad()
+    {
+        SharedPtr<Mesh> mesh(new Mesh());
+        if (!mesh->Define(_data))
+            return nullptr;
+
+        _data = CookedMesh();
+        return mesh.Detach();
+    }
 }
@@ -23,12 +23,15 @@
 #pragma once
 
 #include "../Resource/Resource.h"
+#include "../Resource/ResourceLoader.h"
 #include "../Graphics/GpuBuffer.h"
+#include <vector>
 
 namespace Alimer
 {
     class GpuBuffer;
     class CommandContext;
+    class CookedAssetReader;
     class GraphicsDevice;
 
     enum class MeshAttribute : unsigned
@@ -50,6 +53,31 @@ namespace Alimer
         uint32_t offset = 0;
     };
 
+    /// Indexed vertex data of a mesh, as stored in cooked mesh files.
+    struct ALIMER_API CookedMesh
+    {
+        /// Vertex attribute layouts, Invalid format for attributes not present.
+        MeshAttributeLayout attributes[ecast(MeshAttribute::Count)];
+        /// Number of vertices.
+        uint32_t vertexCount = 0;
+        /// Vertex size in bytes.
+        uint32_t vertexStride = 0;
+        /// Number of indices.
+        uint32_t indexCount = 0;
+        /// Index size in bytes, 2 or 4.
+        uint32_t indexStride = 2;
+        /// Vertex data.
+        std::vector<uint8_t> vertexData;
+        /// Index data.
+        std::vector<uint8_t> indexData;
+
+        /// Save as a cooked asset.
+        bool Save(Stream& dest, uint64_t sourceHash) const;
+
+        /// Load a cooked mesh. Return false if the content is not a valid cooked mesh.
+        bool Load(CookedAssetReader& reader);
+    };
+
     /// Defines a Mesh.
     class ALIMER_API Mesh final : public Resource
     {
@@ -61,6 +89,9 @@ namespace Alimer
 
         bool Define(const std::vector<vec3>& positions, const std::vector<Color4>& colors, const std::vector<uint16_t>& indices);
 
+        /// Define from indexed vertex data with given attribute layout. Index stride is 2 or 4 bytes.
+        bool Define(const CookedMesh& data);
+
         void SetVertexData(const void* vertexData, uint32_t vertexStart = 0, uint32_t vertexCount = 0);
 
         void Draw(SharedPtr<CommandContext> context, uint32_t instanceCount = 1);
@@ -88,4 +119,19 @@ namespace Alimer
         uint32_t _indexCount = 0;
         uint32_t _indexStride = 2;
     };
+
+    /// Mesh loader, loads cooked meshes.
+    class ALIMER_API MeshLoader final : public ResourceLoader
+    {
+    public:
+        StringHash GetType() const override;
+        ResourceLoader* CreateInstance() const override;
+
+        bool BeginLoad(Stream& source) override;
+        Object* EndLoad() override;
+
+    private:
+        /// Mesh data read in BeginLoad.
+        CookedMesh _data;
+    };
 }
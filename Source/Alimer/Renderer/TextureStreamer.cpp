@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Renderer/TextureStreamer.h"
+#include "../Graphics/GraphicsDevice.h"
+#include "../IO/FileStream.h"
+#include "../IO/FileSystem.h"
+#include "../Resource/ResourceManager.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Alimer
+{
+    void StreamedTexture::RequestLevel(uint32_t level)
+    {
+        _requestedLevel = std::min(_requestedLevel, level);
+    }
+
+    void StreamedTexture::RequestScreenSize(float width, float height)
+    {
+        // The level where one texel covers about one pixel.
+        const float ratio = std::max(_layout.size.x / std::max(width, 1.0f), _layout.size.y / std::max(height, 1.0f));
+        const float level = std::floor(std::log2(std::max(ratio, 1.0f)));
+        RequestLevel(static_cast<uint32_t>(std::min(level, 31.0f)));
+    }
+
+    uint64_t StreamedTexture::GetResidentSize() const
+    {
+        uint64_t size = 0;
+        for (uint32_t level = _residentLevel; level < _layout.mipLevels; ++level)
+            size += _layout.levelSizes[level];
+        return size;
+    }
+
+    TextureStreamer::TextureStreamer(GraphicsDevice* device, uint64_t budget)
+        : _device(device)
+        , _budget(budget)
+    {
+    }
+
+    TextureStreamer::~TextureStreamer()
+    {
+        // Completion callbacks refer to the streamer and its textures.
+        if (_numPendingReads)
+            FileSystem::Get().GetAsyncIO().WaitIdle();
+
+        _residentSize = 0;
+        ReportMemoryUse();
+    }
+
+    void TextureStreamer::SetResourceManager(ResourceManager* resources)
+    {
+        _resources = resources;
+        _reportedSize = 0;
+        ReportMemoryUse();
+    }
+
+    SharedPtr<StreamedTexture> TextureStreamer::Load(const String& fileName)
+    {
+        const String nativeFileName = FileSystem::Get().ResolvePath(fileName);
+        FileStream file(nativeFileName, FileAccess::ReadOnly);
+        if (!file.IsOpen())
+            return SharedPtr<StreamedTexture>();
+
+        SharedPtr<StreamedTexture> texture(new StreamedTexture());
+        texture->_fileName = nativeFileName;
+        if (!Image::ReadCookedLayout(file, texture->_layout))
+        {
+            ALIMER_LOGERRORF("Can not stream '%s', not a cooked image", fileName.CString());
+            return SharedPtr<StreamedTexture>();
+        }
+
+        const CookedImageLayout& layout = texture->_layout;
+        uint32_t tailLevel = layout.mipLevels - 1;
+        while (tailLevel > 0 && std::max(layout.size.x >> (tailLevel - 1), layout.size.y >> (tailLevel - 1)) <= TEXTURE_STREAMING_TAIL_SIZE)
+            --tailLevel;
+
+        // The tail is small, read it in one go so that the texture is usable right away.
+        texture->_levelData.resize(layout.mipLevels);
+        const uint64_t tailOffset = layout.levelOffsets[tailLevel];
+        const uint64_t tailSize = layout.levelOffsets[layout.mipLevels - 1] + layout.levelSizes[layout.mipLevels - 1] - tailOffset;
+        std::vector<uint8_t> tailData(static_cast<size_t>(tailSize));
+        if (!file.Seek(static_cast<size_t>(tailOffset)) || file.Read(tailData.data(), tailData.size()) != tailData.size())
+        {
+            ALIMER_LOGERRORF("Truncated cooked image '%s'", fileName.CString());
+            return SharedPtr<StreamedTexture>();
+        }
+
+        for (uint32_t level = tailLevel; level < layout.mipLevels; ++level)
+        {
+            const uint8_t* levelData = tailData.data() + (layout.levelOffsets[level] - tailOffset);
+            texture->_levelData[level].assign(levelData, levelData + layout.levelSizes[level]);
+        }
+
+        texture->_tailLevel = tailLevel;
+        texture->_residentLevel = tailLevel;
+        texture->_requestedLevel = layout.mipLevels;
+        texture->_wantedLevel = tailLevel;
+        texture->_lastRequestFrame = _frameNumber;
+        _residentSize += texture->GetResidentSize();
+
+        UpdateTexture(texture.Get());
+        _textures.push_back(texture);
+        return texture;
+    }
+
+    void TextureStreamer::Update()
+    {
+        ++_frameNumber;
+
+        std::vector<CompletedRead> completedReads;
+        {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            completedReads.swap(_completedReads);
+        }
+
+        for (CompletedRead& read : completedReads)
+        {
+            StreamedTexture* texture = read.texture;
+            const uint64_t levelSize = texture->_layout.levelSizes[read.level];
+            texture->_pending = false;
+            _pendingSize -= levelSize;
+            --_numPendingReads;
+
+            if (!read.result.success || read.result.data.size() != levelSize)
+            {
+                ALIMER_LOGERRORF("Failed to read mip level %u of '%s'", read.level, texture->_fileName.CString());
+                continue;
+            }
+
+            // Levels become resident only next to the finest resident level.
+            if (read.level + 1 != texture->_residentLevel)
+                continue;
+
+            texture->_levelData[read.level] = std::move(read.result.data);
+            texture->_residentLevel = read.level;
+            texture->_dirty = true;
+            _residentSize += levelSize;
+        }
+
+        // Release textures no longer used outside the streamer.
+        for (auto it = _textures.begin(); it != _textures.end();)
+        {
+            StreamedTexture* texture = it->Get();
+            if (it->Refs() == 1 && !texture->_pending)
+            {
+                _residentSize -= texture->GetResidentSize();
+                it = _textures.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        // Gather the demand of this frame.
+        std::vector<StreamedTexture*> requests;
+        for (const SharedPtr<StreamedTexture>& texture : _textures)
+        {
+            if (texture->_requestedLevel < texture->_layout.mipLevels)
+            {
+                texture->_wantedLevel = std::min(texture->_requestedLevel, texture->_tailLevel);
+                texture->_lastRequestFrame = _frameNumber;
+            }
+            else
+            {
+                texture->_wantedLevel = texture->_tailLevel;
+            }
+
+            texture->_requestedLevel = texture->_layout.mipLevels;
+            if (texture->_wantedLevel < texture->_residentLevel && !texture->_pending)
+                requests.push_back(texture.Get());
+        }
+
+        // Get under a lowered budget first.
+        MakeRoom(0, nullptr);
+
+        // Refine the textures missing most levels first, coarse levels are cheaper so they win ties.
+        std::sort(requests.begin(), requests.end(), [](const StreamedTexture* lhs, const StreamedTexture* rhs) {
+            const uint32_t lhsMissing = lhs->_residentLevel - lhs->_wantedLevel;
+            const uint32_t rhsMissing = rhs->_residentLevel - rhs->_wantedLevel;
+            if (lhsMissing != rhsMissing)
+                return lhsMissing > rhsMissing;
+            return lhs->_layout.levelSizes[lhs->_residentLevel - 1] < rhs->_layout.levelSizes[rhs->_residentLevel - 1];
+        });
+
+        for (StreamedTexture* texture : requests)
+        {
+            if (_numPendingReads >= MAX_TEXTURE_STREAMING_READS)
+                break;
+
+            if (MakeRoom(texture->_layout.levelSizes[texture->_residentLevel - 1], texture))
+                RequestNextLevel(texture);
+        }
+
+        for (const SharedPtr<StreamedTexture>& texture : _textures)
+        {
+            if (texture->_dirty)
+                UpdateTexture(texture.Get());
+        }
+
+        ReportMemoryUse();
+    }
+
+    void TextureStreamer::EvictLevel(StreamedTexture* texture)
+    {
+        const uint32_t level = texture->_residentLevel;
+        _residentSize -= texture->_layout.levelSizes[level];
+        texture->_levelData[level].clear();
+        texture->_levelData[level].shrink_to_fit();
+        texture->_residentLevel = level + 1;
+        texture->_dirty = true;
+    }
+
+    bool TextureStreamer::MakeRoom(uint64_t size, const StreamedTexture* requester)
+    {
+        if (_residentSize + _pendingSize + size <= _budget)
+            return true;
+
+        // Candidates hold levels finer than they want, least recently requested first.
+        std::vector<StreamedTexture*> candidates;
+        for (const SharedPtr<StreamedTexture>& texture : _textures)
+        {
+            if (texture.Get() != requester && texture->_residentLevel < texture->_wantedLevel)
+                candidates.push_back(texture.Get());
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const StreamedTexture* lhs, const StreamedTexture* rhs) {
+            return lhs->_lastRequestFrame < rhs->_lastRequestFrame;
+        });
+
+        for (StreamedTexture* texture : candidates)
+        {
+            while (texture->_residentLevel < texture->_wantedLevel && _residentSize + _pendingSize + size > _budget)
+                EvictLevel(texture);
+
+            if (_residentSize + _pendingSize + size <= _budget)
+                return true;
+        }
+
+        return false;
+    }
+
+    void TextureStreamer::RequestNextLevel(StreamedTexture* texture)
+    {
+        const uint32_t level = texture->_residentLevel - 1;
+        const uint64_t levelSize = texture->_layout.levelSizes[level];
+        texture->_pending = true;
+        _pendingSize += levelSize;
+        ++_numPendingReads;
+
+        AsyncReadRequest request;
+        request.fileName = texture->_fileName;
+        request.offset = texture->_layout.levelOffsets[level];
+        request.size = levelSize;
+        // Coarse levels are visible improvements sooner.
+        request.priority = level + 1 >= texture->_tailLevel ? WorkPriority::High : WorkPriority::Normal;
+        request.callback = [this, texture, level](AsyncReadResult& result) {
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _completedReads.push_back({ texture, level, std::move(result) });
+        };
+        FileSystem::Get().GetAsyncIO().Submit(std::move(request));
+    }
+
+    void TextureStreamer::UpdateTexture(StreamedTexture* texture)
+    {
+        texture->_dirty = false;
+        if (!_device)
+            return;
+
+        const CookedImageLayout& layout = texture->_layout;
+        const uint32_t firstLevel = texture->_residentLevel;
+
+        TextureDescriptor descriptor;
+        descriptor.type = TextureType::Type2D;
+        descriptor.usage = TextureUsage::ShaderRead;
+        descriptor.format = layout.format;
+        descriptor.width = std::max(layout.size.x >> firstLevel, 1u);
+        descriptor.height = std::max(layout.size.y >> firstLevel, 1u);
+        descriptor.mipLevels = layout.mipLevels - firstLevel;
+
+        std::vector<ImageLevel> levels(descriptor.mipLevels);
+        for (uint32_t i = 0; i < descriptor.mipLevels; ++i)
+        {
+            const uint32_t level = firstLevel + i;
+            levels[i].data = texture->_levelData[level].data();
+            CalculateDataSize(std::max(layout.size.x >> level, 1u), std::max(layout.size.y >> level, 1u), layout.format, nullptr, &levels[i].rowPitch);
+        }
+
+        texture->_texture = _device->CreateTexture(&descriptor, levels.data());
+    }
+
+    void TextureStreamer::ReportMemoryUse()
+    {
+        if (!_resources || _residentSize == _reportedSize)
+            return;
+
+        // The resident level data is kept for recreating the textures, so it takes CPU memory besides the textures.
+        _reportedSize = _residentSize;
+        const size_t size = static_cast<size_t>(_residentSize);
+        _resources->SetExternalMemoryUse(StringHash("StreamedTexture"), "StreamedTexture", size, _device ? size : 0);
+    }
+}
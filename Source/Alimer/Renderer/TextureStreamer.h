@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/Texture.h"
+#include "../IO/AsyncFileIO.h"
+#include <mutex>
+#include <vector>
+
+namespace Alimer
+{
+    class GraphicsDevice;
+    class ResourceManager;
+
+    /// Default memory budget of streamed texture mip levels in bytes.
+    static constexpr uint64_t DEFAULT_TEXTURE_STREAMING_BUDGET = 256ull * 1024ull * 1024ull;
+    /// Mip levels up to this size in pixels are loaded with the texture and always stay resident.
+    static constexpr uint32_t TEXTURE_STREAMING_TAIL_SIZE = 64;
+    /// Maximum number of mip level reads in flight.
+    static constexpr uint32_t MAX_TEXTURE_STREAMING_READS = 8;
+
+    /// Texture with mip levels streamed from a cooked image file, see TextureStreamer.
+    class ALIMER_API StreamedTexture final : public RefCounted
+    {
+        friend class TextureStreamer;
+
+    public:
+        /// Request the texture be resident from given mip level this frame. The finest request of the frame applies.
+        void RequestLevel(uint32_t level);
+        /// Request the texture for drawing over given screen-space size in pixels this frame.
+        void RequestScreenSize(float width, float height);
+
+        /// Return the texture holding the resident mip levels. Recreated when residency changes, so query every frame instead of keeping it.
+        Texture* GetTexture() const { return _texture.Get(); }
+        /// Return the cooked image file name.
+        const String& GetFileName() const { return _fileName; }
+        /// Return full width in pixels.
+        uint32_t GetWidth() const { return _layout.size.x; }
+        /// Return full height in pixels.
+        uint32_t GetHeight() const { return _layout.size.y; }
+        /// Return pixel format.
+        PixelFormat GetFormat() const { return _layout.format; }
+        /// Return number of mip levels in the file.
+        uint32_t GetMipLevels() const { return _layout.mipLevels; }
+        /// Return the finest resident mip level.
+        uint32_t GetResidentLevel() const { return _residentLevel; }
+        /// Return the finest mip level wanted by the last update.
+        uint32_t GetWantedLevel() const { return _wantedLevel; }
+        /// Return size of the resident mip levels in bytes.
+        uint64_t GetResidentSize() const;
+
+    private:
+        /// Construct. Created by TextureStreamer.
+        StreamedTexture() = default;
+
+        /// Cooked image file name.
+        String _fileName;
+        /// Layout of the cooked image file.
+        CookedImageLayout _layout;
+        /// Data of resident levels, empty for levels not resident. Kept for recreating the texture.
+        std::vector<std::vector<uint8_t>> _levelData;
+        /// Texture holding the resident levels.
+        SharedPtr<Texture> _texture;
+        /// Finest resident level. Levels from it to the last are resident.
+        uint32_t _residentLevel = 0;
+        /// First level of the tail that always stays resident.
+        uint32_t _tailLevel = 0;
+        /// Finest level requested since the last update.
+        uint32_t _requestedLevel = 0;
+        /// Finest level wanted by the last update.
+        uint32_t _wantedLevel = 0;
+        /// Update frame number of the last request.
+        uint64_t _lastRequestFrame = 0;
+        /// Whether a level read is in flight.
+        bool _pending = false;
+        /// Whether the texture must be recreated.
+        bool _dirty = false;
+    };
+
+    /// Streams texture mip levels from cooked image files under a memory budget. Textures load with their coarse mip tail and are refined one level at a time towards the level requested by rendering. When the budget is exhausted, fine levels of the least recently requested textures are evicted. The graphics API has no mip level updates, so the resident level data is kept and textures are recreated when residency changes.
+    class ALIMER_API TextureStreamer final
+    {
+    public:
+        /// Construct with a graphics device to create textures with, or null to track residency only.
+        TextureStreamer(GraphicsDevice* device, uint64_t budget = DEFAULT_TEXTURE_STREAMING_BUDGET);
+        /// Destruct. Waits for reads in flight.
+        ~TextureStreamer();
+
+        /// Open a cooked image file for streaming and load its mip tail. Return null on failure.
+        SharedPtr<StreamedTexture> Load(const String& fileName);
+
+        /// Apply completed reads, evict and request mip levels and recreate changed textures. Call once per frame on the rendering thread after the frame's requests.
+        void Update();
+
+        /// Set resource manager to report the resident size to, as external memory use of streamed textures, or null to not report. It must outlive the streamer.
+        void SetResourceManager(ResourceManager* resources);
+
+        /// Set memory budget of resident and in flight mip levels in bytes.
+        void SetBudget(uint64_t budget) { _budget = budget; }
+        /// Return memory budget in bytes.
+        uint64_t GetBudget() const { return _budget; }
+        /// Return size of resident mip levels in bytes.
+        uint64_t GetResidentSize() const { return _residentSize; }
+        /// Return number of mip level reads in flight.
+        uint32_t GetNumPendingReads() const { return _numPendingReads; }
+        /// Return number of streamed textures.
+        size_t GetNumTextures() const { return _textures.size(); }
+
+    private:
+        /// Completed mip level read.
+        struct CompletedRead
+        {
+            StreamedTexture* texture;
+            uint32_t level;
+            AsyncReadResult result;
+        };
+
+        /// Evict the finest resident level of a texture.
+        void EvictLevel(StreamedTexture* texture);
+        /// Evict fine levels of least recently requested textures not wanting them, until given size fits the budget. Return true if it fits.
+        bool MakeRoom(uint64_t size, const StreamedTexture* requester);
+        /// Start reading the next finer level of a texture.
+        void RequestNextLevel(StreamedTexture* texture);
+        /// Recreate the texture from the resident levels.
+        void UpdateTexture(StreamedTexture* texture);
+        /// Report the resident size to the resource manager if changed.
+        void ReportMemoryUse();
+
+        /// Graphics device.
+        GraphicsDevice* _device;
+        /// Resource manager to report memory use to.
+        ResourceManager* _resources = nullptr;
+        /// Resident size last reported to the resource manager.
+        uint64_t _reportedSize = 0;
+        /// Memory budget in bytes.
+        uint64_t _budget;
+        /// Size of resident levels in bytes.
+        uint64_t _residentSize = 0;
+        /// Size of levels being read in bytes.
+        uint64_t _pendingSize = 0;
+        /// Number of reads in flight.
+        uint32_t _numPendingReads = 0;
+        /// Update frame number.
+        uint64_t _frameNumber = 1;
+        /// Streamed textures.
+        std::vector<SharedPtr<StreamedTexture>> _textures;
+        /// Reads completed on I/O threads.
+        std::vector<CompletedRead> _completedReads;
+        /// Mutex for completed reads.
+        std::mutex _completedMutex;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(TextureStreamer);
+    };
+}
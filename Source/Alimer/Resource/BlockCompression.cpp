@@ -0,0 +1,827 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/BlockCompression.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if ALIMER_SSE2
+#   include <immintrin.h>
+#endif
+
+namespace Alimer
+{
+    /// Interpolation weights of BC7 4-bit indices in 64ths.
+    static const uint32_t BC7_INDEX_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    /// Pixels of a 4x4 block as channel planes, so that the SIMD kernels process 4 pixels at a time.
+    struct alignas(16) BlockPixels
+    {
+        float channels[4][16];
+    };
+
+    /// Palette of a block indexed by entry and channel.
+    typedef float BlockPalette[16][4];
+
+    /// Write bits of a 16-byte block starting from the least significant bit.
+    struct BlockBitWriter
+    {
+        BlockBitWriter(uint8_t* dest_)
+            : dest(dest_)
+        {
+            memset(dest, 0, 16);
+        }
+
+        void Write(uint32_t value, uint32_t numBits)
+        {
+            for (uint32_t i = 0; i < numBits; ++i, ++position)
+            {
+                if ((value >> i) & 1)
+                    dest[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+            }
+        }
+
+        uint8_t* dest;
+        uint32_t position = 0;
+    };
+
+    /// Read bits of a 16-byte block starting from the least significant bit.
+    struct BlockBitReader
+    {
+        BlockBitReader(const uint8_t* source_)
+            : source(source_)
+        {
+        }
+
+        uint32_t Read(uint32_t numBits)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < numBits; ++i, ++position)
+                value |= ((source[position >> 3] >> (position & 7)) & 1u) << i;
+            return value;
+        }
+
+        const uint8_t* source;
+        uint32_t position = 0;
+    };
+
+    static float ClampByte(float value)
+    {
+        return std::min(std::max(value, 0.0f), 255.0f);
+    }
+
+    static uint32_t GetRefineIterations(CompressionQuality quality)
+    {
+        switch (quality)
+        {
+        case CompressionQuality::Fast:
+            return 0;
+        case CompressionQuality::Normal:
+            return 1;
+        default:
+            return 3;
+        }
+    }
+
+    /// Assign each pixel the nearest palette entry over the given channels and return the total squared error. Pixels in skipMask are left out of the error.
+    static float FitPalette(const BlockPixels& block, uint32_t firstChannel, uint32_t numChannels, const BlockPalette& palette, uint32_t paletteSize, uint8_t* indices, uint32_t skipMask = 0)
+    {
+        float total = 0.0f;
+#if ALIMER_SSE2
+        for (uint32_t group = 0; group < 16; group += 4)
+        {
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (uint32_t p = 0; p < paletteSize; ++p)
+            {
+                __m128 error = _mm_setzero_ps();
+                for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c)
+                {
+                    const __m128 diff = _mm_sub_ps(_mm_load_ps(&block.channels[c][group]), _mm_set1_ps(palette[p][c]));
+                    error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+                }
+
+                const __m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(static_cast<int>(p))), _mm_andnot_si128(better, bestIndex));
+            }
+
+            alignas(16) float errors[4];
+            alignas(16) int32_t groupIndices[4];
+            _mm_store_ps(errors, bestError);
+            _mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                indices[group + i] = static_cast<uint8_t>(groupIndices[i]);
+                if (!(skipMask & (1u << (group + i))))
+                    total += errors[i];
+            }
+        }
+#else
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float bestError = FLT_MAX;
+            uint32_t bestIndex = 0;
+            for (uint32_t p = 0; p < paletteSize; ++p)
+            {
+                float error = 0.0f;
+                for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c)
+                {
+                    const float diff = block.channels[c][i] - palette[p][c];
+                    error += diff * diff;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestIndex = p;
+                }
+            }
+
+            indices[i] = static_cast<uint8_t>(bestIndex);
+            if (!(skipMask & (1u << i)))
+                total += bestError;
+        }
+#endif
+        return total;
+    }
+
+    /// Find endpoints along the principal axis of the block over the given channels, moved inwards by the inset fraction of their distance.
+    static void FindEndpoints(const BlockPixels& block, uint32_t firstChannel, uint32_t numChannels, float inset, float (&endpoint0)[4], float (&endpoint1)[4])
+    {
+        const uint32_t lastChannel = firstChannel + numChannels;
+        float mean[4] = {};
+        float axis[4] = {};
+        for (uint32_t c = firstChannel; c < lastChannel; ++c)
+        {
+            float minValue = 255.0f;
+            float maxValue = 0.0f;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                mean[c] += block.channels[c][i];
+                minValue = std::min(minValue, block.channels[c][i]);
+                maxValue = std::max(maxValue, block.channels[c][i]);
+            }
+
+            mean[c] /= 16.0f;
+            axis[c] = maxValue - minValue;
+            endpoint0[c] = endpoint1[c] = mean[c];
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            for (uint32_t a = firstChannel; a < lastChannel; ++a)
+            {
+                for (uint32_t b = a; b < lastChannel; ++b)
+                    covariance[a][b] += (block.channels[a][i] - mean[a]) * (block.channels[b][i] - mean[b]);
+            }
+        }
+
+        // Power iteration from the bounding box diagonal converges to the principal axis.
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float largest = 0.0f;
+            for (uint32_t a = firstChannel; a < lastChannel; ++a)
+            {
+                for (uint32_t b = firstChannel; b < lastChannel; ++b)
+                    next[a] += (a <= b ? covariance[a][b] : covariance[b][a]) * axis[b];
+                largest = std::max(largest, std::abs(next[a]));
+            }
+
+            if (largest == 0.0f)
+                break;
+
+            for (uint32_t c = firstChannel; c < lastChannel; ++c)
+                axis[c] = next[c] / largest;
+        }
+
+        float length = 0.0f;
+        for (uint32_t c = firstChannel; c < lastChannel; ++c)
+            length += axis[c] * axis[c];
+
+        // Uniform block, both endpoints are the mean.
+        if (length == 0.0f)
+            return;
+
+        length = std::sqrt(length);
+        float minProjection = FLT_MAX;
+        float maxProjection = -FLT_MAX;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float projection = 0.0f;
+            for (uint32_t c = firstChannel; c < lastChannel; ++c)
+                projection += (block.channels[c][i] - mean[c]) * axis[c] / length;
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+
+        const float margin = (maxProjection - minProjection) * inset;
+        for (uint32_t c = firstChannel; c < lastChannel; ++c)
+        {
+            endpoint0[c] = ClampByte(mean[c] + axis[c] / length * (maxProjection - margin));
+            endpoint1[c] = ClampByte(mean[c] + axis[c] / length * (minProjection + margin));
+        }
+    }
+
+    /// Solve the endpoints minimizing the squared error of an index assignment. Weights give the position of each index from endpoint 0 to 1, negative weights leave the pixel out. Return false if the solution is not unique.
+    static bool RefineEndpoints(const BlockPixels& block, uint32_t firstChannel, uint32_t numChannels, const uint8_t* indices, const float* weights, float (&endpoint0)[4], float (&endpoint1)[4])
+    {
+        float sum00 = 0.0f;
+        float sum01 = 0.0f;
+        float sum11 = 0.0f;
+        float sum0[4] = {};
+        float sum1[4] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const float weight = weights[indices[i]];
+            if (weight < 0.0f)
+                continue;
+
+            const float inverse = 1.0f - weight;
+            sum00 += inverse * inverse;
+            sum01 += inverse * weight;
+            sum11 += weight * weight;
+            for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c)
+            {
+                sum0[c] += inverse * block.channels[c][i];
+                sum1[c] += weight * block.channels[c][i];
+            }
+        }
+
+        const float determinant = sum00 * sum11 - sum01 * sum01;
+        if (std::abs(determinant) < 1e-4f)
+            return false;
+
+        for (uint32_t c = firstChannel; c < firstChannel + numChannels; ++c)
+        {
+            endpoint0[c] = ClampByte((sum11 * sum0[c] - sum01 * sum1[c]) / determinant);
+            endpoint1[c] = ClampByte((sum00 * sum1[c] - sum01 * sum0[c]) / determinant);
+        }
+
+        return true;
+    }
+
+    static uint16_t PackColor565(const float* color)
+    {
+        const uint32_t r = static_cast<uint32_t>(color[0] * (31.0f / 255.0f) + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(color[1] * (63.0f / 255.0f) + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(color[2] * (31.0f / 255.0f) + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    static void UnpackColor565(uint16_t value, float* color)
+    {
+        const uint32_t r = (value >> 11) & 31;
+        const uint32_t g = (value >> 5) & 63;
+        const uint32_t b = value & 31;
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    /// Encode a BC1 color block from endpoints and return the squared error. BC3 color blocks always decode with four colors. Pixels of transparentMask take the transparent index of three color mode.
+    static float EncodeColorBlock(const BlockPixels& block, const float (&endpoint0)[4], const float (&endpoint1)[4], bool threeColor, bool alwaysFourColor, uint32_t transparentMask, uint8_t* dest, uint8_t (&indices)[16])
+    {
+        uint16_t color0 = PackColor565(endpoint0);
+        uint16_t color1 = PackColor565(endpoint1);
+
+        // Four color mode is selected by color0 > color1.
+        if (!alwaysFourColor && (threeColor ? color0 > color1 : color0 < color1))
+            std::swap(color0, color1);
+
+        // Equal colors select three color mode, where index 3 is transparent. Move one endpoint so that the block keeps four colors.
+        if (!alwaysFourColor && !threeColor && color0 == color1)
+        {
+            if (color0)
+                --color1;
+            else
+                ++color0;
+        }
+
+        const bool fourColor = alwaysFourColor || color0 > color1;
+        BlockPalette palette;
+        UnpackColor565(color0, palette[0]);
+        UnpackColor565(color1, palette[1]);
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (fourColor)
+            {
+                palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+                palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) * 0.5f;
+                palette[3][c] = 0.0f;
+            }
+        }
+
+        // Index 3 of three color mode decodes as transparent black in BC1, so only transparent pixels take it.
+        const float error = FitPalette(block, 0, 3, palette, fourColor ? 4 : 3, indices, transparentMask);
+        uint32_t bits = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (transparentMask & (1u << i))
+                indices[i] = 3;
+            bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+        }
+
+        dest[0] = static_cast<uint8_t>(color0);
+        dest[1] = static_cast<uint8_t>(color0 >> 8);
+        dest[2] = static_cast<uint8_t>(color1);
+        dest[3] = static_cast<uint8_t>(color1 >> 8);
+        for (uint32_t i = 0; i < 4; ++i)
+            dest[4 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        return error;
+    }
+
+    /// Compress the color of a block to BC1, or to the color part of BC3 which has no three color mode.
+    static void CompressColorBlock(const BlockPixels& block, uint8_t* dest, CompressionQuality quality, bool alwaysFourColor)
+    {
+        static const float fourColorWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        static const float threeColorWeights[4] = { 0.0f, 1.0f, 0.5f, -1.0f };
+
+        // Pixels with alpha below half are transparent in BC1.
+        uint32_t transparentMask = 0;
+        if (!alwaysFourColor)
+        {
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (block.channels[3][i] < 128.0f)
+                    transparentMask |= 1u << i;
+            }
+        }
+
+        if (transparentMask == 0xffff)
+        {
+            memset(dest, 0, 4);
+            memset(dest + 4, 0xff, 4);
+            return;
+        }
+
+        // The color of transparent pixels is lost, replace it with the mean of the opaque pixels so it does not steer the endpoints.
+        BlockPixels colors = block;
+        if (transparentMask)
+        {
+            float mean[3] = {};
+            uint32_t numOpaque = 0;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (transparentMask & (1u << i))
+                    continue;
+                for (uint32_t c = 0; c < 3; ++c)
+                    mean[c] += block.channels[c][i];
+                ++numOpaque;
+            }
+
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (transparentMask & (1u << i))
+                {
+                    for (uint32_t c = 0; c < 3; ++c)
+                        colors.channels[c][i] = mean[c] / numOpaque;
+                }
+            }
+        }
+
+        const uint32_t iterations = GetRefineIterations(quality);
+        float bestError = FLT_MAX;
+        uint8_t best[8] = {};
+        auto tryMode = [&](bool threeColor) {
+            float endpoint0[4];
+            float endpoint1[4];
+            FindEndpoints(colors, 0, 3, 1.0f / 16.0f, endpoint0, endpoint1);
+            for (uint32_t i = 0; ; ++i)
+            {
+                uint8_t encoded[8];
+                uint8_t indices[16];
+                const float error = EncodeColorBlock(colors, endpoint0, endpoint1, threeColor, alwaysFourColor, transparentMask, encoded, indices);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    memcpy(best, encoded, sizeof(best));
+                }
+
+                if (i == iterations || error == 0.0f || !RefineEndpoints(colors, 0, 3, indices, threeColor ? threeColorWeights : fourColorWeights, endpoint0, endpoint1))
+                    break;
+            }
+        };
+
+        if (!transparentMask)
+            tryMode(false);
+        if (transparentMask || (!alwaysFourColor && quality == CompressionQuality::High))
+            tryMode(true);
+
+        memcpy(dest, best, sizeof(best));
+    }
+
+    /// Encode a BC4 block of one channel from endpoints and return the squared error. Six value mode adds exact 0 and 255 entries.
+    static float EncodeChannelBlock(const BlockPixels& block, uint32_t channel, float endpoint0, float endpoint1, bool sixValue, uint8_t* dest, uint8_t (&indices)[16])
+    {
+        uint32_t value0 = static_cast<uint32_t>(ClampByte(endpoint0) + 0.5f);
+        uint32_t value1 = static_cast<uint32_t>(ClampByte(endpoint1) + 0.5f);
+
+        // Eight value mode is selected by value0 > value1.
+        if (sixValue ? value0 > value1 : value0 < value1)
+            std::swap(value0, value1);
+
+        BlockPalette palette;
+        palette[0][channel] = static_cast<float>(value0);
+        palette[1][channel] = static_cast<float>(value1);
+        if (value0 > value1)
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+                palette[i][channel] = ((8 - i) * value0 + (i - 1) * value1) / 7.0f;
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+                palette[i][channel] = ((6 - i) * value0 + (i - 1) * value1) / 5.0f;
+            palette[6][channel] = 0.0f;
+            palette[7][channel] = 255.0f;
+        }
+
+        const float error = FitPalette(block, channel, 1, palette, 8, indices);
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 16; ++i)
+            bits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+
+        dest[0] = static_cast<uint8_t>(value0);
+        dest[1] = static_cast<uint8_t>(value1);
+        for (uint32_t i = 0; i < 6; ++i)
+            dest[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+        return error;
+    }
+
+    /// Compress one channel of a block to BC4, also used for BC3 alpha and the channels of BC5.
+    static void CompressChannelBlock(const BlockPixels& block, uint32_t channel, uint8_t* dest, CompressionQuality quality)
+    {
+        static const float eightValueWeights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+        static const float sixValueWeights[8] = { 0.0f, 1.0f, 1.0f / 5.0f, 2.0f / 5.0f, 3.0f / 5.0f, 4.0f / 5.0f, -1.0f, -1.0f };
+
+        float minValue = 255.0f;
+        float maxValue = 0.0f;
+        float minInner = 255.0f;
+        float maxInner = 0.0f;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const float value = block.channels[channel][i];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            if (value > 0.0f && value < 255.0f)
+            {
+                minInner = std::min(minInner, value);
+                maxInner = std::max(maxInner, value);
+            }
+        }
+
+        const uint32_t iterations = GetRefineIterations(quality);
+        float bestError = FLT_MAX;
+        uint8_t best[8] = {};
+        auto tryMode = [&](bool sixValue, float value0, float value1) {
+            float endpoint0[4];
+            float endpoint1[4];
+            endpoint0[channel] = value0;
+            endpoint1[channel] = value1;
+            for (uint32_t i = 0; ; ++i)
+            {
+                uint8_t encoded[8];
+                uint8_t indices[16];
+                const float error = EncodeChannelBlock(block, channel, endpoint0[channel], endpoint1[channel], sixValue, encoded, indices);
+                if (error < bestError)
+                {
+                    bestError = error;
+                    memcpy(best, encoded, sizeof(best));
+                }
+
+                if (i == iterations || error == 0.0f || !RefineEndpoints(block, channel, 1, indices, sixValue ? sixValueWeights : eightValueWeights, endpoint0, endpoint1))
+                    break;
+            }
+        };
+
+        tryMode(false, maxValue, minValue);
+        // Six value mode spends its interpolated values between the extremes when the block also holds 0 or 255.
+        if (quality == CompressionQuality::High && minInner <= maxInner && (minValue == 0.0f || maxValue == 255.0f))
+            tryMode(true, minInner, maxInner);
+
+        memcpy(dest, best, sizeof(best));
+    }
+
+    /// Encode a BC7 mode 6 block from endpoints and return the squared error. P-bit combinations p0 + 2 * p1 set in pbitMask are tried. Indices are returned relative to the given endpoint order.
+    static float EncodeBC7Mode6(const BlockPixels& block, const float (&endpoint0)[4], const float (&endpoint1)[4], uint32_t pbitMask, uint8_t* dest, uint8_t (&indices)[16])
+    {
+        float bestError = FLT_MAX;
+        uint32_t best0[4] = {};
+        uint32_t best1[4] = {};
+        uint32_t bestP0 = 0;
+        uint32_t bestP1 = 0;
+        for (uint32_t combination = 0; combination < 4; ++combination)
+        {
+            if (!(pbitMask & (1u << combination)))
+                continue;
+
+            const uint32_t p0 = combination & 1;
+            const uint32_t p1 = combination >> 1;
+            uint32_t quantized0[4];
+            uint32_t quantized1[4];
+            BlockPalette palette;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                quantized0[c] = static_cast<uint32_t>(std::min(std::max((endpoint0[c] - p0) * 0.5f + 0.5f, 0.0f), 127.0f));
+                quantized1[c] = static_cast<uint32_t>(std::min(std::max((endpoint1[c] - p1) * 0.5f + 0.5f, 0.0f), 127.0f));
+                const uint32_t value0 = (quantized0[c] << 1) | p0;
+                const uint32_t value1 = (quantized1[c] << 1) | p1;
+                for (uint32_t i = 0; i < 16; ++i)
+                    palette[i][c] = static_cast<float>(((64 - BC7_INDEX_WEIGHTS[i]) * value0 + BC7_INDEX_WEIGHTS[i] * value1 + 32) >> 6);
+            }
+
+            uint8_t candidate[16];
+            const float error = FitPalette(block, 0, 4, palette, 16, candidate);
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(best0, quantized0, sizeof(best0));
+                memcpy(best1, quantized1, sizeof(best1));
+                bestP0 = p0;
+                bestP1 = p1;
+                memcpy(indices, candidate, sizeof(candidate));
+            }
+        }
+
+        // The most significant bit of the first index is implied zero, swap the endpoints to clear it.
+        uint8_t encodedIndices[16];
+        memcpy(encodedIndices, indices, sizeof(encodedIndices));
+        if (encodedIndices[0] & 8)
+        {
+            std::swap(best0, best1);
+            std::swap(bestP0, bestP1);
+            for (uint8_t& index : encodedIndices)
+                index = static_cast<uint8_t>(15 - index);
+        }
+
+        BlockBitWriter writer(dest);
+        writer.Write(1u << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            writer.Write(best0[c], 7);
+            writer.Write(best1[c], 7);
+        }
+        writer.Write(bestP0, 1);
+        writer.Write(bestP1, 1);
+        writer.Write(encodedIndices[0], 3);
+        for (uint32_t i = 1; i < 16; ++i)
+            writer.Write(encodedIndices[i], 4);
+        return bestError;
+    }
+
+    /// Compress a block to BC7 with mode 6, which has one subset of RGBA endpoints and 4-bit indices.
+    static void CompressBC7Block(const BlockPixels& block, uint8_t* dest, CompressionQuality quality)
+    {
+        float weights[16];
+        for (uint32_t i = 0; i < 16; ++i)
+            weights[i] = BC7_INDEX_WEIGHTS[i] / 64.0f;
+
+        bool opaque = true;
+        for (uint32_t i = 0; i < 16; ++i)
+            opaque &= block.channels[3][i] == 255.0f;
+
+        // Alpha 255 needs both p-bits set, fast quality only tries equal p-bits.
+        const uint32_t pbitMask = opaque ? 0x8 : (quality == CompressionQuality::Fast ? 0x9 : 0xf);
+        float endpoint0[4];
+        float endpoint1[4];
+        FindEndpoints(block, 0, 4, 1.0f / 32.0f, endpoint0, endpoint1);
+
+        const uint32_t iterations = GetRefineIterations(quality);
+        float bestError = FLT_MAX;
+        for (uint32_t i = 0; ; ++i)
+        {
+            uint8_t encoded[16];
+            uint8_t indices[16];
+            const float error = EncodeBC7Mode6(block, endpoint0, endpoint1, pbitMask, encoded, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                memcpy(dest, encoded, sizeof(encoded));
+            }
+
+            if (i == iterations || error == 0.0f || !RefineEndpoints(block, 0, 4, indices, weights, endpoint0, endpoint1))
+                break;
+        }
+    }
+
+    bool IsBlockCompressorFormat(PixelFormat format)
+    {
+        switch (format)
+        {
+        case PixelFormat::BC1UNorm:
+        case PixelFormat::BC1UNormSrgb:
+        case PixelFormat::BC3UNorm:
+        case PixelFormat::BC3UNormSrgb:
+        case PixelFormat::BC4UNorm:
+        case PixelFormat::BC5UNorm:
+        case PixelFormat::BC7UNorm:
+        case PixelFormat::BC7UNormSrgb:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void CompressBlockRow(PixelFormat format, const uint8_t* const* rows, uint32_t channels, uint32_t width, uint8_t* dest, CompressionQuality quality)
+    {
+        const uint32_t blockSize = FormatDesc[static_cast<uint32_t>(format)].bytesPerBlock;
+        const uint32_t numBlocks = (width + 3) / 4;
+        BlockPixels block;
+        for (uint32_t blockX = 0; blockX < numBlocks; ++blockX, dest += blockSize)
+        {
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint8_t* pixel = rows[y] + std::min(blockX * 4 + x, width - 1) * channels;
+                    const uint32_t i = y * 4 + x;
+                    block.channels[0][i] = pixel[0];
+                    block.channels[1][i] = channels > 1 ? pixel[1] : 0.0f;
+                    block.channels[2][i] = channels > 2 ? pixel[2] : 0.0f;
+                    block.channels[3][i] = channels > 3 ? pixel[3] : 255.0f;
+                }
+            }
+
+            switch (format)
+            {
+            case PixelFormat::BC1UNorm:
+            case PixelFormat::BC1UNormSrgb:
+                CompressColorBlock(block, dest, quality, false);
+                break;
+            case PixelFormat::BC3UNorm:
+            case PixelFormat::BC3UNormSrgb:
+                CompressChannelBlock(block, 3, dest, quality);
+                CompressColorBlock(block, dest + 8, quality, true);
+                break;
+            case PixelFormat::BC4UNorm:
+                CompressChannelBlock(block, 0, dest, quality);
+                break;
+            case PixelFormat::BC5UNorm:
+                CompressChannelBlock(block, 0, dest, quality);
+                CompressChannelBlock(block, 1, dest + 8, quality);
+                break;
+            case PixelFormat::BC7UNorm:
+            case PixelFormat::BC7UNormSrgb:
+                CompressBC7Block(block, dest, quality);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    /// Decode a BC1 color block. BC3 color blocks always decode with four colors.
+    static void DecompressColorBlock(const uint8_t* source, bool alwaysFourColor, uint8_t (&pixels)[16][4])
+    {
+        const uint16_t color0 = static_cast<uint16_t>(source[0] | (source[1] << 8));
+        const uint16_t color1 = static_cast<uint16_t>(source[2] | (source[3] << 8));
+        uint32_t palette[4][4];
+        for (uint32_t e = 0; e < 2; ++e)
+        {
+            const uint16_t color = e ? color1 : color0;
+            const uint32_t r = color >> 11;
+            const uint32_t g = (color >> 5) & 0x3f;
+            const uint32_t b = color & 0x1f;
+            palette[e][0] = (r << 3) | (r >> 2);
+            palette[e][1] = (g << 2) | (g >> 4);
+            palette[e][2] = (b << 3) | (b >> 2);
+            palette[e][3] = 255;
+        }
+
+        const bool fourColor = alwaysFourColor || color0 > color1;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (fourColor)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c] + 1) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColor ? 255 : 0;
+
+        const uint32_t bits = source[4] | (source[5] << 8) | (source[6] << 16) | (static_cast<uint32_t>(source[7]) << 24);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t index = (bits >> (i * 2)) & 3;
+            for (uint32_t c = 0; c < 4; ++c)
+                pixels[i][c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+
+    /// Decode a BC4 block into one channel of the pixels.
+    static void DecompressChannelBlock(const uint8_t* source, uint32_t channel, uint8_t (&pixels)[16][4])
+    {
+        const uint32_t value0 = source[0];
+        const uint32_t value1 = source[1];
+        uint32_t palette[8] = { value0, value1 };
+        if (value0 > value1)
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+                palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+                palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 6; ++i)
+            bits |= static_cast<uint64_t>(source[2 + i]) << (i * 8);
+        for (uint32_t i = 0; i < 16; ++i)
+            pixels[i][channel] = static_cast<uint8_t>(palette[(bits >> (i * 3)) & 7]);
+    }
+
+    /// Decode a BC7 mode 6 block. Return false for other modes.
+    static bool DecompressBC7Block(const uint8_t* source, uint8_t (&pixels)[16][4])
+    {
+        BlockBitReader reader(source);
+        if (reader.Read(7) != 1u << 6)
+            return false;
+
+        uint32_t endpoint0[4];
+        uint32_t endpoint1[4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            endpoint0[c] = reader.Read(7) << 1;
+            endpoint1[c] = reader.Read(7) << 1;
+        }
+
+        const uint32_t p0 = reader.Read(1);
+        const uint32_t p1 = reader.Read(1);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t weight = BC7_INDEX_WEIGHTS[reader.Read(i ? 4 : 3)];
+            for (uint32_t c = 0; c < 4; ++c)
+                pixels[i][c] = static_cast<uint8_t>(((64 - weight) * (endpoint0[c] | p0) + weight * (endpoint1[c] | p1) + 32) >> 6);
+        }
+
+        return true;
+    }
+
+    bool DecompressBlock(PixelFormat format, const uint8_t* source, uint8_t (&pixels)[16][4])
+    {
+        switch (format)
+        {
+        case PixelFormat::BC1UNorm:
+        case PixelFormat::BC1UNormSrgb:
+            DecompressColorBlock(source, false, pixels);
+            return true;
+        case PixelFormat::BC3UNorm:
+        case PixelFormat::BC3UNormSrgb:
+            DecompressColorBlock(source + 8, true, pixels);
+            DecompressChannelBlock(source, 3, pixels);
+            return true;
+        case PixelFormat::BC4UNorm:
+        case PixelFormat::BC5UNorm:
+            memset(pixels, 0, sizeof(pixels));
+            DecompressChannelBlock(source, 0, pixels);
+            if (format == PixelFormat::BC5UNorm)
+                DecompressChannelBlock(source + 8, 1, pixels);
+            for (uint32_t i = 0; i < 16; ++i)
+                pixels[i][3] = 255;
+            return true;
+        case PixelFormat::BC7UNorm:
+        case PixelFormat::BC7UNormSrgb:
+            return DecompressBC7Block(source, pixels);
+        default:
+            return false;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/PixelFormat.h"
+
+namespace Alimer
+{
+    /// Quality of block compression, higher quality searches more endpoints and is slower.
+    enum class CompressionQuality : uint32_t
+    {
+        /// Principal axis endpoints only.
+        Fast,
+        /// Endpoints refined once by least squares.
+        Normal,
+        /// Endpoints refined several times and alternative block modes tried.
+        High
+    };
+
+    /// Return whether blocks of the format can be produced by the block compressor. Supported are BC1, BC3, BC4, BC5 and BC7 in unsigned variants.
+    bool IsBlockCompressorFormat(PixelFormat format);
+
+    /// Compress a row of 4x4 blocks from 4 rows of 8-bit pixels with 1, 2 or 4 channels. Columns past the width repeat the last pixel. Missing channels read as 0 and alpha as 255.
+    void CompressBlockRow(PixelFormat format, const uint8_t* const* rows, uint32_t channels, uint32_t width, uint8_t* dest, CompressionQuality quality);
+
+    /// Decompress a 4x4 block to RGBA8 pixels in row order, for verifying compressed data. BC7 is supported in mode 6 only, as written by CompressBlockRow. Return false for other formats and modes.
+    bool DecompressBlock(PixelFormat format, const uint8_t* source, uint8_t (&pixels)[16][4]);
+}
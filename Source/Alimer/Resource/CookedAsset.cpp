@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/CookedAsset.h"
+#include <cstring>
+
+namespace Alimer
+{
+    static size_t AlignOffset(size_t offset)
+    {
+        return (offset + COOKED_ASSET_ALIGNMENT - 1) & ~static_cast<size_t>(COOKED_ASSET_ALIGNMENT - 1);
+    }
+
+    CookedAssetReader::CookedAssetReader(Stream& source)
+    {
+        if (source.TryGetView(_view))
+        {
+            source.Seek(source.GetSize());
+        }
+        else
+        {
+            _buffer = source.ReadBytes();
+            _view.data = _buffer.data();
+            _view.size = _buffer.size();
+        }
+    }
+
+    bool CookedAssetReader::IsCookedAsset(CookedAssetType type) const
+    {
+        CookedAssetHeader header;
+        if (_offset != 0 || _view.size < sizeof(header))
+            return false;
+
+        memcpy(&header, _view.data, sizeof(header));
+        return header.magic == COOKED_ASSET_MAGIC && header.version == COOKED_ASSET_VERSION && header.type == type;
+    }
+
+    bool CookedAssetReader::ReadHeader(CookedAssetType type)
+    {
+        if (!IsCookedAsset(type))
+            return false;
+
+        memcpy(&_header, _view.data, sizeof(_header));
+        _offset = sizeof(_header);
+        return true;
+    }
+
+    bool CookedAssetReader::Read(void* dest, size_t size)
+    {
+        if (size > _view.size - _offset)
+            return false;
+
+        memcpy(dest, _view.data + _offset, size);
+        _offset += size;
+        return true;
+    }
+
+    const uint8_t* CookedAssetReader::ReadData(size_t size)
+    {
+        const size_t offset = AlignOffset(_offset);
+        if (offset > _view.size || size > _view.size - offset)
+            return nullptr;
+
+        _offset = offset + size;
+        return _view.data + offset;
+    }
+
+    CookedAssetWriter::CookedAssetWriter(Stream& dest)
+        : _dest(dest)
+        , _start(dest.GetPosition())
+    {
+    }
+
+    bool CookedAssetWriter::WriteHeader(CookedAssetType type, uint64_t sourceHash)
+    {
+        CookedAssetHeader header;
+        header.magic = COOKED_ASSET_MAGIC;
+        header.version = COOKED_ASSET_VERSION;
+        header.type = type;
+        header.flags = 0;
+        header.sourceHash = sourceHash;
+        return Write(header);
+    }
+
+    bool CookedAssetWriter::Write(const void* data, size_t size)
+    {
+        return _dest.Write(data, size) == size;
+    }
+
+    bool CookedAssetWriter::WriteData(const void* data, size_t size)
+    {
+        static const uint8_t padding[COOKED_ASSET_ALIGNMENT] = {};
+        const size_t offset = _dest.GetPosition() - _start;
+        return Write(padding, AlignOffset(offset) - offset) && Write(data, size);
+    }
+}
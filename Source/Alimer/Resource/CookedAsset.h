@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../IO/Stream.h"
+#include <vector>
+
+namespace Alimer
+{
+    /// Cooked asset magic, "ACKD".
+    static constexpr uint32_t COOKED_ASSET_MAGIC = 0x444B4341;
+    /// Cooked asset format version, cooked files of another version are rejected.
+    static constexpr uint32_t COOKED_ASSET_VERSION = 1;
+    /// Alignment of bulk data in cooked assets, from the start of the file.
+    static constexpr uint32_t COOKED_ASSET_ALIGNMENT = 16;
+
+    /// Cooked asset content type.
+    enum class CookedAssetType : uint32_t
+    {
+        Shader = 0,
+        Image,
+        Mesh
+    };
+
+    /// Cooked asset header, stored at the beginning of the file.
+    struct CookedAssetHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        CookedAssetType type;
+        uint32_t flags;
+        /// Hash of the source content the asset was cooked from.
+        uint64_t sourceHash;
+    };
+
+    static_assert(sizeof(CookedAssetHeader) == 24, "Invalid CookedAssetHeader size");
+
+    /// Reader for cooked asset content. Uses the stream memory directly when available, such as a memory mapped file.
+    class ALIMER_API CookedAssetReader
+    {
+    public:
+        /// Construct over the stream content from the current position. The stream must outlive the reader.
+        explicit CookedAssetReader(Stream& source);
+
+        /// Return whether the content is a cooked asset of given type and the header has not been read yet.
+        bool IsCookedAsset(CookedAssetType type) const;
+
+        /// Read the header if the content is a cooked asset of given type. Return false without consuming anything otherwise.
+        bool ReadHeader(CookedAssetType type);
+
+        /// Read bytes. Return false if past the end.
+        bool Read(void* dest, size_t size);
+
+        /// Read a value. Return false if past the end.
+        template <class T> bool Read(T& value) { return Read(&value, sizeof(T)); }
+
+        /// Return aligned bulk data without copying and advance past it. Return null if past the end.
+        const uint8_t* ReadData(size_t size);
+
+        /// Return number of bytes left to read.
+        size_t GetRemaining() const { return _view.size - _offset; }
+
+        /// Return the header, valid after ReadHeader succeeded.
+        const CookedAssetHeader& GetHeader() const { return _header; }
+
+        /// Return the whole content, also for content that is not a cooked asset.
+        const StreamView& GetView() const { return _view; }
+
+    private:
+        /// Content read from a stream that has no view.
+        std::vector<uint8_t> _buffer;
+        /// Content.
+        StreamView _view;
+        /// Read offset.
+        size_t _offset = 0;
+        /// Header.
+        CookedAssetHeader _header{};
+    };
+
+    /// Writer for cooked asset content.
+    class ALIMER_API CookedAssetWriter
+    {
+    public:
+        /// Construct for writing to the stream from the current position.
+        explicit CookedAssetWriter(Stream& dest);
+
+        /// Write the header.
+        bool WriteHeader(CookedAssetType type, uint64_t sourceHash);
+
+        /// Write bytes.
+        bool Write(const void* data, size_t size);
+
+        /// Write a value.
+        template <class T> bool Write(const T& value) { return Write(&value, sizeof(T)); }
+
+        /// Write aligned bulk data.
+        bool WriteData(const void* data, size_t size);
+
+    private:
+        /// Destination stream.
+        Stream& _dest;
+        /// Stream position of the header.
+        size_t _start;
+    };
+}
@@ -0,0 +1,303 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/DerivedDataCache.h"
+#include "../IO/FileStream.h"
+#include "../IO/FileSystem.h"
+#include "../IO/PagedMemoryStream.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <thread>
+
+namespace Alimer
+{
+    /// Derived data entry magic, "ADDC".
+    static constexpr uint32_t DERIVED_DATA_MAGIC = 0x43444441;
+    /// Derived data entry format version.
+    static constexpr uint32_t DERIVED_DATA_VERSION = 1;
+    /// Age in seconds after which temporary files of interrupted writes are removed.
+    static constexpr uint64_t STALE_TEMP_FILE_AGE = 60 * 60;
+
+    /// Header of a cache entry file, followed by the data.
+    struct DerivedDataHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t size;
+        /// Hash of the data to detect corrupt entries.
+        uint64_t dataHash;
+    };
+
+    static_assert(sizeof(DerivedDataHeader) == 32, "Invalid DerivedDataHeader size");
+
+    static uint64_t GetFileSize(const String& fileName)
+    {
+        FileStream file(fileName, FileAccess::ReadOnly);
+        return file.IsOpen() ? file.GetSize() : 0;
+    }
+
+    DerivedDataCache& DerivedDataCache::Get()
+    {
+        static DerivedDataCache cache;
+        return cache;
+    }
+
+    void DerivedDataCache::HashData(Hasher& hasher, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        hasher.UInt64(size);
+        hasher.Data(reinterpret_cast<const uint32_t*>(bytes), size & ~size_t(3));
+        for (size_t i = size & ~size_t(3); i < size; ++i)
+            hasher.UInt32(bytes[i]);
+    }
+
+    bool DerivedDataCache::SetDirectory(const String& directory, uint64_t maxSize)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        _directory.Clear();
+        _maxSize = maxSize;
+        _size = 0;
+        _sizeKnown = false;
+
+        if (directory.IsEmpty())
+            return true;
+
+        String cacheDirectory = AddTrailingSlash(directory);
+        if (!FileSystem::CreateDirectory(cacheDirectory))
+        {
+            ALIMER_LOGERRORF("Could not create derived data cache directory '%s'", cacheDirectory.CString());
+            return false;
+        }
+
+        _directory = cacheDirectory;
+        return true;
+    }
+
+    String DerivedDataCache::GetEntryFileName(uint64_t key) const
+    {
+        return _directory + String::Format("%016llx.ddc", static_cast<unsigned long long>(key));
+    }
+
+    bool DerivedDataCache::Get(uint64_t key, std::vector<uint8_t>& data)
+    {
+        if (!IsEnabled())
+            return false;
+
+        const String fileName = GetEntryFileName(key);
+        if (!FileSystem::FileExists(fileName))
+        {
+            ++_numMisses;
+            return false;
+        }
+
+        FileStream file(fileName, FileAccess::ReadOnly);
+
+        DerivedDataHeader header;
+        bool valid = file.IsOpen()
+            && file.Read(&header, sizeof(header)) == sizeof(header)
+            && header.magic == DERIVED_DATA_MAGIC
+            && header.version == DERIVED_DATA_VERSION
+            && header.key == key
+            && header.size == file.GetSize() - sizeof(header);
+
+        if (valid)
+        {
+            data.resize(static_cast<size_t>(header.size));
+            valid = file.Read(data.data(), data.size()) == data.size();
+        }
+
+        if (valid)
+        {
+            Hasher hasher;
+            HashData(hasher, data.data(), data.size());
+            valid = hasher.GetValue() == header.dataHash;
+        }
+
+        file.Close();
+
+        if (!valid)
+        {
+            ALIMER_LOGWARNF("Removing corrupt derived data cache entry '%s'", fileName.CString());
+            FileSystem::Delete(fileName);
+            data.clear();
+            ++_numMisses;
+            return false;
+        }
+
+        // Mark as recently used for eviction.
+        FileSystem::SetLastModifiedTime(fileName, static_cast<uint64_t>(std::time(nullptr)));
+        ++_numHits;
+        return true;
+    }
+
+    bool DerivedDataCache::Put(uint64_t key, const void* data, size_t size)
+    {
+        std::vector<StreamBuffer> buffers;
+        buffers.push_back({ data, size });
+        return PutEntry(key, buffers);
+    }
+
+    bool DerivedDataCache::Put(uint64_t key, const PagedMemoryStream& source)
+    {
+        return PutEntry(key, source.GetRanges());
+    }
+
+    bool DerivedDataCache::PutEntry(uint64_t key, const std::vector<StreamBuffer>& buffers)
+    {
+        if (!IsEnabled())
+            return false;
+
+        DerivedDataHeader header;
+        header.magic = DERIVED_DATA_MAGIC;
+        header.version = DERIVED_DATA_VERSION;
+        header.key = key;
+        header.size = 0;
+
+        Hasher hasher;
+        for (const StreamBuffer& buffer : buffers)
+        {
+            HashData(hasher, buffer.data, buffer.size);
+            header.size += buffer.size;
+        }
+        header.dataHash = hasher.GetValue();
+
+        std::vector<StreamBuffer> fileBuffers;
+        fileBuffers.reserve(buffers.size() + 1);
+        fileBuffers.push_back({ &header, sizeof(header) });
+        fileBuffers.insert(fileBuffers.end(), buffers.begin(), buffers.end());
+
+        // Write to a temporary file first, so that other threads and processes never see a partial entry.
+        const String fileName = GetEntryFileName(key);
+        String tempFileName;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            const uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id())
+                ^ static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+            tempFileName = fileName + String::Format(".%016llx%u.tmp", static_cast<unsigned long long>(unique), _tempCounter++);
+        }
+
+        const uint64_t fileSize = sizeof(header) + header.size;
+        bool success;
+        {
+            FileStream file(tempFileName, FileAccess::WriteOnly);
+            success = file.IsOpen()
+                && file.WriteGather(fileBuffers.data(), fileBuffers.size()) == fileSize
+                && file.Flush();
+        }
+
+        success = success && FileSystem::Rename(tempFileName, fileName);
+        if (!success)
+        {
+            ALIMER_LOGWARNF("Could not write derived data cache entry '%s'", fileName.CString());
+            FileSystem::Delete(tempFileName);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_sizeKnown)
+        {
+            _size += fileSize;
+            if (_size > _maxSize)
+                TrimLocked(_maxSize - _maxSize / 4);
+        }
+        else
+        {
+            // Scan the size of the entries left by earlier runs on first store.
+            TrimLocked(_maxSize);
+        }
+
+        return true;
+    }
+
+    void DerivedDataCache::Trim(uint64_t size)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        TrimLocked(size);
+    }
+
+    void DerivedDataCache::TrimLocked(uint64_t size)
+    {
+        if (!IsEnabled())
+            return;
+
+        struct Entry
+        {
+            String fileName;
+            uint64_t lastUsed;
+            uint64_t size;
+        };
+
+        std::vector<String> files;
+        ScanDirectory(files, _directory, "*", ScanDirFlags::Files, false);
+
+        const uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+        for (const String& file : files)
+        {
+            const String fileName = _directory + file;
+            const String extension = FileSystem::GetExtension(file);
+            if (extension == ".tmp")
+            {
+                // Remove leftovers of interrupted writes, leaving the ones possibly in progress.
+                if (FileSystem::GetLastModifiedTime(fileName) + STALE_TEMP_FILE_AGE < now)
+                    FileSystem::Delete(fileName);
+            }
+            else if (extension == ".ddc")
+            {
+                Entry entry = { fileName, FileSystem::GetLastModifiedTime(fileName), GetFileSize(fileName) };
+                totalSize += entry.size;
+                entries.push_back(entry);
+            }
+        }
+
+        if (totalSize > size)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+                return lhs.lastUsed < rhs.lastUsed;
+            });
+
+            uint32_t numEvicted = 0;
+            for (const Entry& entry : entries)
+            {
+                if (totalSize <= size)
+                    break;
+
+                if (FileSystem::Delete(entry.fileName))
+                {
+                    totalSize -= entry.size;
+                    ++numEvicted;
+                }
+            }
+
+            ALIMER_LOGDEBUGF("Evicted %u derived data cache entries", numEvicted);
+        }
+
+        _size = totalSize;
+        _sizeKnown = true;
+    }
+}
@@ -0,0 +1,108 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Base/HashMap.h"
+#include "../Base/String.h"
+#include "../IO/Stream.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Alimer
+{
+    class PagedMemoryStream;
+
+    /// Default maximum size of the derived data cache in bytes.
+    static constexpr uint64_t DEFAULT_DERIVED_DATA_CACHE_SIZE = 1024ull * 1024ull * 1024ull;
+
+    /// Local on-disk cache of data derived from source content, such as compiled shaders and decoded images. Entries are addressed by a hash of everything the data depends on: the source bytes, the version of the code producing it and its options. Least recently used entries are evicted when the cache grows over its maximum size. Thread-safe, and the directory may be shared by several processes.
+    class ALIMER_API DerivedDataCache final
+    {
+    public:
+        /// Return the process wide cache, disabled until a directory is set.
+        static DerivedDataCache& Get();
+
+        /// Add bytes to a key hash. Faster than hashing byte by byte for large source data.
+        static void HashData(Hasher& hasher, const void* data, size_t size);
+
+        /// Set the cache directory and maximum size in bytes, creating the directory if necessary. An empty directory disables the cache. Return true if successful.
+        bool SetDirectory(const String& directory, uint64_t maxSize = DEFAULT_DERIVED_DATA_CACHE_SIZE);
+
+        /// Return data cached with given key. Return false if not cached or the entry is corrupt.
+        bool Get(uint64_t key, std::vector<uint8_t>& data);
+
+        /// Store data with given key. Return true if successful.
+        bool Put(uint64_t key, const void* data, size_t size);
+
+        /// Store the content of a paged memory stream with given key. Return true if successful.
+        bool Put(uint64_t key, const PagedMemoryStream& source);
+
+        /// Evict least recently used entries until the cache is under given size in bytes.
+        void Trim(uint64_t size);
+
+        /// Return whether a directory has been set.
+        bool IsEnabled() const { return !_directory.IsEmpty(); }
+
+        /// Return the cache directory.
+        const String& GetDirectory() const { return _directory; }
+
+        /// Return the maximum size in bytes.
+        uint64_t GetMaxSize() const { return _maxSize; }
+
+        /// Return the number of lookups found in the cache.
+        uint32_t GetNumHits() const { return _numHits; }
+
+        /// Return the number of lookups not found in the cache.
+        uint32_t GetNumMisses() const { return _numMisses; }
+
+    private:
+        DerivedDataCache() = default;
+
+        /// Return file name of an entry.
+        String GetEntryFileName(uint64_t key) const;
+        /// Write an entry gathered from memory ranges to a temporary file and move it in place.
+        bool PutEntry(uint64_t key, const std::vector<StreamBuffer>& buffers);
+        /// Evict entries until under given size. The mutex must be held.
+        void TrimLocked(uint64_t size);
+
+        /// Cache directory with trailing slash.
+        String _directory;
+        /// Maximum size in bytes.
+        uint64_t _maxSize = DEFAULT_DERIVED_DATA_CACHE_SIZE;
+        /// Estimated total size in bytes. Scanned on first store.
+        uint64_t _size = 0;
+        /// Whether the total size has been scanned.
+        bool _sizeKnown = false;
+        /// Counter for unique temporary file names.
+        uint32_t _tempCounter = 0;
+        /// Number of lookups found.
+        std::atomic<uint32_t> _numHits{ 0 };
+        /// Number of lookups not found.
+        std::atomic<uint32_t> _numMisses{ 0 };
+        /// Mutex for the size bookkeeping and eviction.
+        mutable std::mutex _mutex;
+
+        DISALLOW_COPY_MOVE_AND_ASSIGN(DerivedDataCache);
+    };
+}
@@ -21,8 +21,17 @@
 //
 
 #include "../Resource/Image.h"
+#include "../Resource/CookedAsset.h"
+#include "../Resource/DerivedDataCache.h"
+#include "../Resource/ImageKernels.h"
+#include "../Resource/PngDecoder.h"
 #include "../Core/Log.h"
-#include "../IO/Stream.h"
+#include "../Core/WorkQueue.h"
+#include "../IO/MemoryStream.h"
+#include "../IO/PagedMemoryStream.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #ifdef _MSC_VER
@@ -33,23 +42,44 @@
 
 namespace Alimer
 {
+    /// Version of the image decoding rules. Part of the derived data cache key of decoded images.
+    static constexpr uint32_t IMAGE_DECODE_VERSION = 2;
+
+    /// Cooked image description, followed by the size of each level and the level data.
+    struct CookedImageInfo
+    {
+        uint32_t width;
+        uint32_t height;
+        PixelFormat format;
+        uint32_t mipLevels;
+    };
+
+    static uint32_t GetLevelDimension(uint32_t size, uint32_t level)
+    {
+        return std::max(size >> level, 1u);
+    }
+
+    static bool IsValidCookedImageInfo(const CookedImageInfo& info)
+    {
+        return info.width && info.height && info.mipLevels > 0 && info.mipLevels <= 32 && static_cast<uint32_t>(info.format) <= static_cast<uint32_t>(PixelFormat::BC7UNormSrgb);
+    }
+
     Image::Image()
     {
     }
 
     void Image::Define(const uvec2& newSize, PixelFormat newFormat)
     {
-        if (all(equal(newSize, _size)) && newFormat == _format)
+        if (all(equal(newSize, _size)) && newFormat == _format && _mipLevels == 1)
             return;
 
-        const uint32_t formatSize = GetPixelFormatSize(newFormat);
-        if (formatSize == 0)
+        if (FormatDesc[static_cast<uint32_t>(newFormat)].bytesPerBlock == 0)
         {
-            ALIMER_LOGERROR("Can not set image size with unspecified pixel byte size (including compressed formats)");
+            ALIMER_LOGERROR("Can not set image size with unspecified pixel byte size");
             return;
         }
 
-        _memorySize = newSize.x * newSize.y * formatSize;
+        _memorySize = CalculateDataSize(newSize.x, newSize.y, newFormat);
         _data = new uint8_t[_memorySize];
         _size = newSize;
         _format = newFormat;
@@ -58,14 +88,466 @@ namespace Alimer
 
     void Image::SetData(const uint8_t* pixelData)
     {
-        if (!IsCompressed(_format))
-        {
+        if (_data)
             memcpy(_data.Get(), pixelData, _memorySize);
+    }
+
+    bool Image::Decode(const void* data, size_t size)
+    {
+        // PNG rows are decoded straight into the image, other files go through a temporary buffer of stb_image.
+        PngDecoder png(data, size);
+        if (png.ReadHeader())
+        {
+            if (static_cast<uint64_t>(png.GetWidth()) * png.GetHeight() * 4 > UINT32_MAX)
+            {
+                ALIMER_LOGERRORF("Could not decode image '%s': too large", GetName().CString());
+                return false;
+            }
+
+            Define(uvec2(png.GetWidth(), png.GetHeight()), PixelFormat::RGBA8UNorm);
+            if (!png.Decode(_data.Get(), png.GetWidth() * 4))
+            {
+                ALIMER_LOGERRORF("Could not decode image '%s': corrupt PNG data", GetName().CString());
+                return false;
+            }
+
+            return true;
         }
+
+        int width, height, components;
+        stbi_uc* pixels = stbi_load_from_memory(static_cast<const stbi_uc*>(data), static_cast<int>(size), &width, &height, &components, 4);
+        if (!pixels)
+        {
+            ALIMER_LOGERRORF("Could not decode image '%s': %s", GetName().CString(), stbi_failure_reason());
+            return false;
+        }
+
+        Define(uvec2(static_cast<uint32_t>(width), static_cast<uint32_t>(height)), PixelFormat::RGBA8UNorm);
+        SetData(pixels);
+        stbi_image_free(pixels);
+        return true;
+    }
+
+    /// Image data size processed per parallel batch in bytes.
+    static constexpr size_t IMAGE_BATCH_SIZE = 64 * 1024;
+    /// Number of taps of the Kaiser mipmap filter.
+    static constexpr uint32_t KAISER_FILTER_TAPS = 6;
+
+    /// Execute func(begin, end) over image rows, split in batches over the work queue when available.
+    static void ForEachRowBatch(uint32_t rows, size_t rowSize, const std::function<void(uint32_t begin, uint32_t end)>& func)
+    {
+        WorkQueue* workQueue = Object::GetSubsystem<WorkQueue>();
+        const uint32_t batchSize = static_cast<uint32_t>(std::max(IMAGE_BATCH_SIZE / std::max(rowSize, size_t(1)), size_t(1)));
+        if (workQueue)
+            workQueue->ParallelFor(rows, batchSize, func);
         else
+            func(0, rows);
+    }
+
+    /// Compute weights of a Kaiser windowed sinc for downsampling by two, at the source texels around a destination texel.
+    static void GetKaiserWeights(float (&weights)[KAISER_FILTER_TAPS])
+    {
+        // Zeroth order modified Bessel function of the first kind.
+        auto bessel = [](float x) {
+            float sum = 1.0f;
+            float term = 1.0f;
+            for (uint32_t k = 1; k < 16; ++k)
+            {
+                term *= (x * 0.5f / k) * (x * 0.5f / k);
+                sum += term;
+            }
+            return sum;
+        };
+
+        const float alpha = 4.0f;
+        const float radius = KAISER_FILTER_TAPS * 0.5f;
+        float total = 0.0f;
+        for (uint32_t i = 0; i < KAISER_FILTER_TAPS; ++i)
+        {
+            // Distance from the destination texel center in destination texels.
+            const float x = (i + 0.5f - radius) * 0.5f;
+            const float sinc = x == 0.0f ? 1.0f : std::sin(M_PI * x) / (M_PI * x);
+            const float window = x / (radius * 0.5f);
+            weights[i] = sinc * bessel(alpha * std::sqrt(std::max(1.0f - window * window, 0.0f))) / bessel(alpha);
+            total += weights[i];
+        }
+
+        for (float& weight : weights)
+            weight /= total;
+    }
+
+    bool Image::GenerateMipmaps(MipmapFilter filter)
+    {
+        const PixelFormatDesc& desc = FormatDesc[static_cast<uint32_t>(_format)];
+        if (!_data || !IsImageKernelFormat(_format))
+        {
+            ALIMER_LOGERRORF("Can not generate mipmaps for image '%s' of format %s", GetName().CString(), EnumToString(_format).c_str());
+            return false;
+        }
+
+        uint32_t mipLevels = 1;
+        while ((std::max(_size.x, _size.y) >> mipLevels) > 0)
+            ++mipLevels;
+
+        size_t memorySize = 0;
+        for (uint32_t level = 0; level < mipLevels; ++level)
+            memorySize += CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), _format);
+
+        AutoArrayPtr<uint8_t> data(new uint8_t[memorySize]);
+        memcpy(data.Get(), _data.Get(), CalculateDataSize(_size.x, _size.y, _format));
+
+        // Plain 8-bit data box filters exactly in integers, everything else through linear float texels.
+        const bool integerBox = filter == MipmapFilter::Box && desc.Type == PixelFormatType::UNorm && desc.bytesPerBlock == desc.channelCount;
+        float weights[KAISER_FILTER_TAPS];
+        GetKaiserWeights(weights);
+
+        const uint32_t pixelSize = desc.bytesPerBlock;
+        const uint8_t* source = data.Get();
+        uint8_t* dest = data.Get() + CalculateDataSize(_size.x, _size.y, _format);
+        for (uint32_t level = 1; level < mipLevels; ++level)
         {
-            ALIMER_LOGERROR("Can not set pixel data of a compressed image");
+            const uint32_t sourceWidth = GetLevelDimension(_size.x, level - 1);
+            const uint32_t sourceHeight = GetLevelDimension(_size.y, level - 1);
+            const uint32_t width = GetLevelDimension(_size.x, level);
+            const uint32_t height = GetLevelDimension(_size.y, level);
+            const size_t sourcePitch = sourceWidth * pixelSize;
+            const size_t pitch = width * pixelSize;
+            const uint8_t* levelSource = source;
+            uint8_t* levelDest = dest;
+
+            ForEachRowBatch(height, sourcePitch * 2, [&](uint32_t begin, uint32_t end) {
+                auto sourceRow = [&](int32_t y) {
+                    return levelSource + std::min(std::max(y, 0), static_cast<int32_t>(sourceHeight) - 1) * sourcePitch;
+                };
+
+                if (integerBox)
+                {
+                    for (uint32_t y = begin; y < end; ++y)
+                        DownsampleBoxRow8(sourceRow(y * 2), sourceRow(y * 2 + 1), levelDest + y * pitch, sourceWidth, width, pixelSize);
+                    return;
+                }
+
+                std::vector<ImageTexel> rows(sourceWidth * 2);
+                std::vector<ImageTexel> result(width);
+                if (filter == MipmapFilter::Box)
+                {
+                    for (uint32_t y = begin; y < end; ++y)
+                    {
+                        DecodeImageRow(_format, sourceRow(y * 2), rows.data(), sourceWidth);
+                        DecodeImageRow(_format, sourceRow(y * 2 + 1), rows.data() + sourceWidth, sourceWidth);
+                        DownsampleBoxRow(rows.data(), rows.data() + sourceWidth, result.data(), sourceWidth, width);
+                        EncodeImageRow(_format, result.data(), levelDest + y * pitch, width);
+                    }
+                    return;
+                }
+
+                // Filter the source rows of the batch horizontally once, then combine them vertically.
+                const int32_t firstRow = static_cast<int32_t>(begin * 2) + 1 - static_cast<int32_t>(KAISER_FILTER_TAPS / 2);
+                const uint32_t numRows = (end - begin) * 2 + KAISER_FILTER_TAPS - 2;
+                std::vector<ImageTexel> filtered(static_cast<size_t>(numRows) * width);
+                for (uint32_t i = 0; i < numRows; ++i)
+                {
+                    DecodeImageRow(_format, sourceRow(firstRow + static_cast<int32_t>(i)), rows.data(), sourceWidth);
+                    DownsampleFilterRow(rows.data(), filtered.data() + i * width, sourceWidth, width, weights, KAISER_FILTER_TAPS);
+                }
+
+                for (uint32_t y = begin; y < end; ++y)
+                {
+                    std::fill(result.begin(), result.end(), ImageTexel{ 0.0f, 0.0f, 0.0f, 0.0f });
+                    for (uint32_t i = 0; i < KAISER_FILTER_TAPS; ++i)
+                        AccumulateRow(filtered.data() + ((y - begin) * 2 + i) * width, result.data(), weights[i], width);
+                    EncodeImageRow(_format, result.data(), levelDest + y * pitch, width);
+                }
+            });
+
+            source = dest;
+            dest += pitch * height;
         }
+
+        _data = data;
+        _memorySize = memorySize;
+        _mipLevels = mipLevels;
+        return true;
+    }
+
+    bool Image::Convert(PixelFormat newFormat)
+    {
+        if (newFormat == _format)
+            return true;
+
+        if (!_data || !IsImageKernelFormat(_format) || !IsImageKernelFormat(newFormat))
+        {
+            ALIMER_LOGERRORF("Can not convert image '%s' from %s to %s", GetName().CString(), EnumToString(_format).c_str(), EnumToString(newFormat).c_str());
+            return false;
+        }
+
+        // Swapping red and blue keeps the data otherwise.
+        const bool swapRedBlue = (_format == PixelFormat::RGBA8UNorm && newFormat == PixelFormat::BGRA8UNorm)
+            || (_format == PixelFormat::BGRA8UNorm && newFormat == PixelFormat::RGBA8UNorm)
+            || (_format == PixelFormat::RGBA8UNormSrgb && newFormat == PixelFormat::BGRA8UNormSrgb)
+            || (_format == PixelFormat::BGRA8UNormSrgb && newFormat == PixelFormat::RGBA8UNormSrgb);
+        static const uint32_t swapMap[4] = { 2, 1, 0, 3 };
+
+        size_t memorySize = 0;
+        for (uint32_t level = 0; level < _mipLevels; ++level)
+            memorySize += CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), newFormat);
+
+        AutoArrayPtr<uint8_t> data(new uint8_t[memorySize]);
+        const uint32_t sourcePixelSize = FormatDesc[static_cast<uint32_t>(_format)].bytesPerBlock;
+        const uint32_t pixelSize = FormatDesc[static_cast<uint32_t>(newFormat)].bytesPerBlock;
+        const uint8_t* source = _data.Get();
+        uint8_t* dest = data.Get();
+        for (uint32_t level = 0; level < _mipLevels; ++level)
+        {
+            const uint32_t width = GetLevelDimension(_size.x, level);
+            const uint32_t height = GetLevelDimension(_size.y, level);
+            const uint8_t* levelSource = source;
+            uint8_t* levelDest = dest;
+
+            ForEachRowBatch(height, width * sourcePixelSize, [&](uint32_t begin, uint32_t end) {
+                if (swapRedBlue)
+                {
+                    for (uint32_t y = begin; y < end; ++y)
+                        SwizzleRow8(levelSource + y * width * sourcePixelSize, levelDest + y * width * pixelSize, width, 4, swapMap);
+                    return;
+                }
+
+                std::vector<ImageTexel> row(width);
+                for (uint32_t y = begin; y < end; ++y)
+                {
+                    DecodeImageRow(_format, levelSource + y * width * sourcePixelSize, row.data(), width);
+                    EncodeImageRow(newFormat, row.data(), levelDest + y * width * pixelSize, width);
+                }
+            });
+
+            source += width * height * sourcePixelSize;
+            dest += width * height * pixelSize;
+        }
+
+        _data = data;
+        _memorySize = memorySize;
+        _format = newFormat;
+        return true;
+    }
+
+    bool Image::Swizzle(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha)
+    {
+        const PixelFormatDesc& desc = FormatDesc[static_cast<uint32_t>(_format)];
+        const uint32_t map[4] = { red, green, blue, alpha };
+        if (!_data || !IsImageKernelFormat(_format) || desc.bytesPerBlock != desc.channelCount
+            || std::any_of(map, map + desc.channelCount, [&desc](uint32_t channel) { return channel >= desc.channelCount; }))
+        {
+            ALIMER_LOGERRORF("Can not swizzle image '%s' of format %s", GetName().CString(), EnumToString(_format).c_str());
+            return false;
+        }
+
+        // Rows are swizzled in place, each pixel is read before it is written.
+        const uint32_t channels = desc.channelCount;
+        uint8_t* levelData = _data.Get();
+        for (uint32_t level = 0; level < _mipLevels; ++level)
+        {
+            const uint32_t width = GetLevelDimension(_size.x, level);
+            const uint32_t height = GetLevelDimension(_size.y, level);
+            uint8_t* levelRows = levelData;
+            ForEachRowBatch(height, width * channels, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t y = begin; y < end; ++y)
+                    SwizzleRow8(levelRows + y * width * channels, levelRows + y * width * channels, width, channels, map);
+            });
+
+            levelData += width * height * channels;
+        }
+
+        return true;
+    }
+
+    bool Image::Compress(PixelFormat newFormat, CompressionQuality quality)
+    {
+        const PixelFormatDesc& desc = FormatDesc[static_cast<uint32_t>(_format)];
+        const bool sourceSrgb = _format == PixelFormat::RGBA8UNormSrgb;
+        const bool destSrgb = FormatDesc[static_cast<uint32_t>(newFormat)].Type == PixelFormatType::UNormSrgb;
+        if (!_data || !IsBlockCompressorFormat(newFormat) || sourceSrgb != destSrgb
+            || (_format != PixelFormat::R8UNorm && _format != PixelFormat::RG8UNorm && _format != PixelFormat::RGBA8UNorm && !sourceSrgb))
+        {
+            ALIMER_LOGERRORF("Can not compress image '%s' from %s to %s", GetName().CString(), EnumToString(_format).c_str(), EnumToString(newFormat).c_str());
+            return false;
+        }
+
+        size_t memorySize = 0;
+        for (uint32_t level = 0; level < _mipLevels; ++level)
+            memorySize += CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), newFormat);
+
+        AutoArrayPtr<uint8_t> data(new uint8_t[memorySize]);
+        const uint32_t channels = desc.channelCount;
+        const uint8_t* source = _data.Get();
+        uint8_t* dest = data.Get();
+        for (uint32_t level = 0; level < _mipLevels; ++level)
+        {
+            const uint32_t width = GetLevelDimension(_size.x, level);
+            const uint32_t height = GetLevelDimension(_size.y, level);
+            uint32_t blockRows;
+            uint32_t blockRowPitch;
+            CalculateDataSize(width, height, newFormat, &blockRows, &blockRowPitch);
+            const uint8_t* levelSource = source;
+            uint8_t* levelDest = dest;
+
+            // Each batch compresses whole rows of blocks, rows past the height repeat the last one.
+            ForEachRowBatch(blockRows, width * channels * 4, [&](uint32_t begin, uint32_t end) {
+                for (uint32_t blockY = begin; blockY < end; ++blockY)
+                {
+                    const uint8_t* rows[4];
+                    for (uint32_t y = 0; y < 4; ++y)
+                        rows[y] = levelSource + std::min(blockY * 4 + y, height - 1) * width * channels;
+                    CompressBlockRow(newFormat, rows, channels, width, levelDest + blockY * blockRowPitch, quality);
+                }
+            });
+
+            source += width * height * channels;
+            dest += blockRows * blockRowPitch;
+        }
+
+        _data = data;
+        _memorySize = memorySize;
+        _format = newFormat;
+        return true;
+    }
+
+    ImageLevel Image::GetLevel(uint32_t level) const
+    {
+        ImageLevel result;
+        result.data = nullptr;
+        if (level >= _mipLevels || !_data)
+            return result;
+
+        size_t offset = 0;
+        for (uint32_t i = 0; i < level; ++i)
+            offset += CalculateDataSize(GetLevelDimension(_size.x, i), GetLevelDimension(_size.y, i), _format);
+
+        CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), _format, nullptr, &result.rowPitch);
+        result.data = _data.Get() + offset;
+        return result;
+    }
+
+    bool Image::SaveCooked(Stream& dest, uint64_t sourceHash) const
+    {
+        if (!_data)
+        {
+            ALIMER_LOGERRORF("Can not save zero-sized image '%s'", GetName().CString());
+            return false;
+        }
+
+        CookedImageInfo info;
+        info.width = _size.x;
+        info.height = _size.y;
+        info.format = _format;
+        info.mipLevels = _mipLevels;
+
+        CookedAssetWriter writer(dest);
+        bool success = writer.WriteHeader(CookedAssetType::Image, sourceHash) && writer.Write(info);
+        for (uint32_t level = 0; level < _mipLevels && success; ++level)
+        {
+            const uint64_t levelSize = CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), _format);
+            success = writer.Write(levelSize);
+        }
+
+        for (uint32_t level = 0; level < _mipLevels && success; ++level)
+        {
+            const size_t levelSize = CalculateDataSize(GetLevelDimension(_size.x, level), GetLevelDimension(_size.y, level), _format);
+            success = writer.WriteData(GetLevel(level).data, levelSize);
+        }
+
+        return success;
+    }
+
+    bool Image::LoadCooked(CookedAssetReader& reader)
+    {
+        CookedImageInfo info;
+        if (!reader.ReadHeader(CookedAssetType::Image) || !reader.Read(info))
+            return false;
+
+        if (!IsValidCookedImageInfo(info))
+        {
+            ALIMER_LOGERRORF("Invalid cooked image '%s'", GetName().CString());
+            return false;
+        }
+
+        // Level sizes must match the format, so that GetLevel addresses the same data.
+        size_t memorySize = 0;
+        for (uint32_t level = 0; level < info.mipLevels; ++level)
+        {
+            uint64_t levelSize;
+            if (!reader.Read(levelSize) || levelSize != CalculateDataSize(GetLevelDimension(info.width, level), GetLevelDimension(info.height, level), info.format))
+            {
+                ALIMER_LOGERRORF("Invalid cooked image '%s'", GetName().CString());
+                return false;
+            }
+
+            memorySize += static_cast<size_t>(levelSize);
+        }
+
+        AutoArrayPtr<uint8_t> data(new uint8_t[memorySize]);
+        size_t offset = 0;
+        for (uint32_t level = 0; level < info.mipLevels; ++level)
+        {
+            const size_t levelSize = CalculateDataSize(GetLevelDimension(info.width, level), GetLevelDimension(info.height, level), info.format);
+            const uint8_t* levelData = reader.ReadData(levelSize);
+            if (!levelData)
+            {
+                ALIMER_LOGERRORF("Truncated cooked image '%s'", GetName().CString());
+                return false;
+            }
+
+            memcpy(data.Get() + offset, levelData, levelSize);
+            offset += levelSize;
+        }
+
+        _data = data;
+        _size = uvec2(info.width, info.height);
+        _format = info.format;
+        _mipLevels = info.mipLevels;
+        _memorySize = memorySize;
+        return true;
+    }
+
+    bool Image::ReadCookedLayout(Stream& source, CookedImageLayout& layout)
+    {
+        const size_t start = source.GetPosition();
+        CookedAssetHeader header;
+        CookedImageInfo info;
+        if (source.Read(&header, sizeof(header)) != sizeof(header)
+            || header.magic != COOKED_ASSET_MAGIC
+            || header.version != COOKED_ASSET_VERSION
+            || header.type != CookedAssetType::Image
+            || source.Read(&info, sizeof(info)) != sizeof(info)
+            || !IsValidCookedImageInfo(info))
+        {
+            return false;
+        }
+
+        layout.size = uvec2(info.width, info.height);
+        layout.format = info.format;
+        layout.mipLevels = info.mipLevels;
+        layout.levelSizes.resize(info.mipLevels);
+        layout.levelOffsets.resize(info.mipLevels);
+        for (uint32_t level = 0; level < info.mipLevels; ++level)
+        {
+            uint64_t& levelSize = layout.levelSizes[level];
+            if (source.Read(&levelSize, sizeof(levelSize)) != sizeof(levelSize)
+                || levelSize != CalculateDataSize(GetLevelDimension(info.width, level), GetLevelDimension(info.height, level), info.format))
+            {
+                return false;
+            }
+        }
+
+        // Level data follows aligned from the start of the cooked image.
+        uint64_t offset = source.GetPosition() - start;
+        for (uint32_t level = 0; level < info.mipLevels; ++level)
+        {
+            offset = (offset + COOKED_ASSET_ALIGNMENT - 1) & ~static_cast<uint64_t>(COOKED_ASSET_ALIGNMENT - 1);
+            layout.levelOffsets[level] = offset;
+            offset += layout.levelSizes[level];
+        }
+
+        return offset <= source.GetSize() - start;
     }
 
     void StbiWriteCallback(void *context, void *data, int len)
@@ -135,4 +617,69 @@ namespace Alimer
             _data.Get(),
             0) != 0;
     }
+
+    /// Decode a source image through the derived data cache, which holds decoded images in cooked format.
+    static bool DecodeCached(Image& image, const StreamView& view)
+    {
+        DerivedDataCache& cache = DerivedDataCache::Get();
+        if (!cache.IsEnabled())
+            return image.Decode(view.data, view.size);
+
+        Hasher hasher;
+        hasher.String("Image");
+        hasher.UInt32(IMAGE_DECODE_VERSION);
+        DerivedDataCache::HashData(hasher, view.data, view.size);
+        const uint64_t key = hasher.GetValue();
+
+        std::vector<uint8_t> data;
+        if (cache.Get(key, data))
+        {
+            MemoryStream stream(data);
+            CookedAssetReader reader(stream);
+            if (reader.IsCookedAsset(CookedAssetType::Image) && image.LoadCooked(reader))
+                return true;
+        }
+
+        if (!image.Decode(view.data, view.size))
+            return false;
+
+        PagedMemoryStream cooked;
+        if (image.SaveCooked(cooked, key))
+            cache.Put(key, cooked);
+
+        return true;
+    }
+
+    StringHash ImageLoader::GetType() const
+    {
+        return Image::GetTypeStatic();
+    }
+
+    ResourceLoader* ImageLoader::CreateInstance() const
+    {
+        return new ImageLoader();
+    }
+
+    bool ImageLoader::BeginLoad(Stream& source)
+    {
+        _image = new Image();
+        _image->SetName(source.GetName());
+
+        // Cooked images are copied as stored, source images are decoded.
+        CookedAssetReader reader(source);
+        const bool success = reader.IsCookedAsset(CookedAssetType::Image) ? _image->LoadCooked(reader) : DecodeCached(*_image, reader.GetView());
+        if (!success)
+        {
+            _image.Reset();
+            return false;
+        }
+
+        _image->SetMemoryUse(_image->GetMemorySize());
+        return true;
+    }
+
+    Object* ImageLoader::EndLoad()
+    {
+        return _image.Detach();
+    }
 }
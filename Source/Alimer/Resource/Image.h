@@ -24,10 +24,14 @@
 
 #include "../Math/Math.h"
 #include "../Resource/Resource.h"
+#include "../Resource/ResourceLoader.h"
+#include "../Resource/BlockCompression.h"
 #include "../Graphics/PixelFormat.h"
 
 namespace Alimer
 {
+    class CookedAssetReader;
+
     /// Description of image mip level data.
     struct ALIMER_API ImageLevel
     {
@@ -38,6 +42,30 @@ namespace Alimer
         uint32_t rowPitch = 0;
     };
 
+    /// Layout of a cooked image, for reading single mip levels from the file.
+    struct ALIMER_API CookedImageLayout
+    {
+        /// Dimensions of the first level in pixels.
+        uvec2 size;
+        /// Pixel format.
+        PixelFormat format = PixelFormat::Unknown;
+        /// Number of mip levels.
+        uint32_t mipLevels = 0;
+        /// Offset of each level from the start of the cooked image in bytes.
+        std::vector<uint64_t> levelOffsets;
+        /// Size of each level in bytes.
+        std::vector<uint64_t> levelSizes;
+    };
+
+    /// Filter for generating mip levels.
+    enum class MipmapFilter : uint32_t
+    {
+        /// Average of 2x2 texels.
+        Box,
+        /// Kaiser windowed sinc over 6x6 texels, sharper than box.
+        Kaiser
+    };
+
     enum class ImageFormat : uint32_t
     {
         Bmp,
@@ -56,15 +84,39 @@ namespace Alimer
         /// Destructor.
         ~Image() = default;
 
-        /// Set new image pixel dimensions and format. Setting a compressed format is not supported.
+        /// Set new image pixel dimensions and format with a single mip level.
         void Define(const uvec2& newSize, PixelFormat newFormat);
 
-        /// Set new pixel data.
+        /// Set new pixel data, or blocks for compressed formats.
         void SetData(const uint8_t* pixelData);
 
+        /// Decode a PNG, BMP, JPEG or TGA file from memory into RGBA8 pixels. Return true on success.
+        bool Decode(const void* data, size_t size);
+
+        /// Generate the full mip chain from the first level. sRGB formats are filtered in linear space. Supported for uncompressed color formats. Return true on success.
+        bool GenerateMipmaps(MipmapFilter filter = MipmapFilter::Box);
+
+        /// Convert all mip levels to another uncompressed color format. Conversions to and from sRGB formats go through linear space. Return true on success.
+        bool Convert(PixelFormat newFormat);
+
+        /// Reorder the channels of all mip levels, each destination channel takes the given source channel. Supported for formats of 8 bits per channel. Return true on success.
+        bool Swizzle(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha);
+
+        /// Compress all mip levels to BC1, BC3, BC4, BC5 or BC7 from R8, RG8 or RGBA8 pixels. sRGB pixels compress only to sRGB formats and vice versa. Return true on success.
+        bool Compress(PixelFormat newFormat, CompressionQuality quality = CompressionQuality::Normal);
+
         /// Save the image to a stream in given format.
         bool Save(Stream* dest, ImageFormat format) const;
 
+        /// Save the image with all mip levels as a cooked asset that loads without decoding.
+        bool SaveCooked(Stream& dest, uint64_t sourceHash) const;
+
+        /// Load a cooked image. Return false if the content is not a cooked image.
+        bool LoadCooked(CookedAssetReader& reader);
+
+        /// Read the layout of a cooked image without its level data. Return false if the content is not a valid cooked image.
+        static bool ReadCookedLayout(Stream& source, CookedImageLayout& layout);
+
         /// Return image dimensions in pixels.
         const uvec2& GetSize() const { return _size; }
         /// Return image width in pixels.
@@ -72,6 +124,15 @@ namespace Alimer
         /// Return image height in pixels.
         uint32_t GetHeight() const { return _size.y; }
 
+        /// Return pixel format.
+        PixelFormat GetFormat() const { return _format; }
+        /// Return number of mip levels.
+        uint32_t GetMipLevels() const { return _mipLevels; }
+        /// Return mip level data, or null data if the level does not exist.
+        ImageLevel GetLevel(uint32_t level) const;
+        /// Return size of all pixel data in bytes.
+        size_t GetMemorySize() const { return _memorySize; }
+
         /// Return pixel data.
         uint8_t* Data() const { return _data.Get(); }
 
@@ -83,12 +144,27 @@ namespace Alimer
         uvec2 _size;
         /// Image format.
         PixelFormat _format = PixelFormat::Unknown;
-        /// Number of mip levels. 1 for uncompressed images.
+        /// Number of mip levels.
         uint32_t _mipLevels = 1;
-        /// Image pixel data.
+        /// Image pixel data, mip levels stored one after another.
         AutoArrayPtr<uint8_t> _data;
 
         /// Memory size.
         size_t _memorySize = 0;
 	};
+
+    /// Image loader, loads cooked images as stored and decodes source image files.
+    class ALIMER_API ImageLoader final : public ResourceLoader
+    {
+    public:
+        StringHash GetType() const override;
+        ResourceLoader* CreateInstance() const override;
+
+        bool BeginLoad(Stream& source) override;
+        Object* EndLoad() override;
+
+    private:
+        /// Image being loaded.
+        SharedPtr<Image> _image;
+    };
 }
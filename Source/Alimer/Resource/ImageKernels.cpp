@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/ImageKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if ALIMER_SSE2
+#   include <immintrin.h>
+#endif
+
+namespace Alimer
+{
+    /// Number of steps of the linear to sRGB encoding table, fine enough to round trip every 8-bit value.
+    static constexpr uint32_t SRGB_ENCODE_STEPS = 4096;
+
+    /// Channel layout of a format supported by the kernels.
+    struct KernelFormat
+    {
+        uint32_t channels;
+        uint32_t bytesPerChannel;
+        bool isSigned;
+        bool isSrgb;
+        bool isBgra;
+    };
+
+    static bool GetKernelFormat(PixelFormat format, KernelFormat& result)
+    {
+        switch (format)
+        {
+        case PixelFormat::R8UNorm:          result = { 1, 1, false, false, false }; return true;
+        case PixelFormat::R8SNorm:          result = { 1, 1, true, false, false }; return true;
+        case PixelFormat::R16UNorm:         result = { 1, 2, false, false, false }; return true;
+        case PixelFormat::R16SNorm:         result = { 1, 2, true, false, false }; return true;
+        case PixelFormat::RG8UNorm:         result = { 2, 1, false, false, false }; return true;
+        case PixelFormat::RG8SNorm:         result = { 2, 1, true, false, false }; return true;
+        case PixelFormat::RG16UNorm:        result = { 2, 2, false, false, false }; return true;
+        case PixelFormat::RG16SNorm:        result = { 2, 2, true, false, false }; return true;
+        case PixelFormat::RGB16UNorm:       result = { 3, 2, false, false, false }; return true;
+        case PixelFormat::RGB16SNorm:       result = { 3, 2, true, false, false }; return true;
+        case PixelFormat::RGBA8UNorm:       result = { 4, 1, false, false, false }; return true;
+        case PixelFormat::RGBA8UNormSrgb:   result = { 4, 1, false, true, false }; return true;
+        case PixelFormat::RGBA8SNorm:       result = { 4, 1, true, false, false }; return true;
+        case PixelFormat::BGRA8UNorm:       result = { 4, 1, false, false, true }; return true;
+        case PixelFormat::BGRA8UNormSrgb:   result = { 4, 1, false, true, true }; return true;
+        default:
+            return false;
+        }
+    }
+
+    /// Conversion tables between 8-bit sRGB and linear values.
+    struct SrgbTables
+    {
+        SrgbTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                const float value = i / 255.0f;
+                decode[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < SRGB_ENCODE_STEPS; ++i)
+            {
+                const float value = i / static_cast<float>(SRGB_ENCODE_STEPS - 1);
+                const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+                encode[i] = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+            }
+        }
+
+        float decode[256];
+        uint8_t encode[SRGB_ENCODE_STEPS];
+    };
+
+    static const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    static inline uint8_t EncodeSrgb(const SrgbTables& tables, float value)
+    {
+        const float clamped = std::min(std::max(value, 0.0f), 1.0f);
+        return tables.encode[static_cast<uint32_t>(clamped * (SRGB_ENCODE_STEPS - 1) + 0.5f)];
+    }
+
+    static inline float DecodeChannel(const uint8_t* source, const KernelFormat& format)
+    {
+        if (format.bytesPerChannel == 1)
+        {
+            if (format.isSigned)
+                return std::max(static_cast<int8_t>(*source) / 127.0f, -1.0f);
+            return *source / 255.0f;
+        }
+
+        uint16_t value;
+        memcpy(&value, source, sizeof(value));
+        if (format.isSigned)
+            return std::max(static_cast<int16_t>(value) / 32767.0f, -1.0f);
+        return value / 65535.0f;
+    }
+
+    static inline void EncodeChannel(float value, uint8_t* dest, const KernelFormat& format)
+    {
+        if (format.bytesPerChannel == 1)
+        {
+            if (format.isSigned)
+                *dest = static_cast<uint8_t>(static_cast<int8_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 127.0f)));
+            else
+                *dest = static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+            return;
+        }
+
+        uint16_t encoded;
+        if (format.isSigned)
+            encoded = static_cast<uint16_t>(static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f)));
+        else
+            encoded = static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+        memcpy(dest, &encoded, sizeof(encoded));
+    }
+
+    bool IsImageKernelFormat(PixelFormat format)
+    {
+        KernelFormat kernelFormat;
+        return GetKernelFormat(format, kernelFormat);
+    }
+
+    void DecodeImageRow(PixelFormat format, const uint8_t* source, ImageTexel* dest, uint32_t width)
+    {
+        KernelFormat kernelFormat;
+        if (!GetKernelFormat(format, kernelFormat))
+            return;
+
+        uint32_t x = 0;
+#if ALIMER_SSE2
+        if (format == PixelFormat::RGBA8UNorm || format == PixelFormat::BGRA8UNorm)
+        {
+            const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+            const __m128i zero = _mm_setzero_si128();
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+                const __m128i low = _mm_unpacklo_epi8(pixels, zero);
+                const __m128i high = _mm_unpackhi_epi8(pixels, zero);
+                __m128 texels[4] = {
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale),
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale)
+                };
+
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    if (kernelFormat.isBgra)
+                        texels[i] = _mm_shuffle_ps(texels[i], texels[i], _MM_SHUFFLE(3, 0, 1, 2));
+                    _mm_storeu_ps(&dest[x + i].r, texels[i]);
+                }
+            }
+        }
+#endif
+
+        const SrgbTables& tables = GetSrgbTables();
+        const uint32_t pixelSize = kernelFormat.channels * kernelFormat.bytesPerChannel;
+        for (; x < width; ++x)
+        {
+            const uint8_t* pixel = source + x * pixelSize;
+            float values[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            for (uint32_t c = 0; c < kernelFormat.channels; ++c)
+            {
+                if (kernelFormat.isSrgb && c < 3)
+                    values[c] = tables.decode[pixel[c]];
+                else
+                    values[c] = DecodeChannel(pixel + c * kernelFormat.bytesPerChannel, kernelFormat);
+            }
+
+            if (kernelFormat.isBgra)
+                std::swap(values[0], values[2]);
+
+            dest[x] = { values[0], values[1], values[2], values[3] };
+        }
+    }
+
+    void EncodeImageRow(PixelFormat format, const ImageTexel* source, uint8_t* dest, uint32_t width)
+    {
+        KernelFormat kernelFormat;
+        if (!GetKernelFormat(format, kernelFormat))
+            return;
+
+        uint32_t x = 0;
+#if ALIMER_SSE2
+        if (format == PixelFormat::RGBA8UNorm || format == PixelFormat::BGRA8UNorm)
+        {
+            const __m128 scale = _mm_set1_ps(255.0f);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i values[4];
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    __m128 texel = _mm_loadu_ps(&source[x + i].r);
+                    if (kernelFormat.isBgra)
+                        texel = _mm_shuffle_ps(texel, texel, _MM_SHUFFLE(3, 0, 1, 2));
+                    values[i] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(texel, zero), one), scale));
+                }
+
+                const __m128i low = _mm_packs_epi32(values[0], values[1]);
+                const __m128i high = _mm_packs_epi32(values[2], values[3]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_packus_epi16(low, high));
+            }
+        }
+#endif
+
+        const SrgbTables& tables = GetSrgbTables();
+        const uint32_t pixelSize = kernelFormat.channels * kernelFormat.bytesPerChannel;
+        for (; x < width; ++x)
+        {
+            uint8_t* pixel = dest + x * pixelSize;
+            float values[4] = { source[x].r, source[x].g, source[x].b, source[x].a };
+            if (kernelFormat.isBgra)
+                std::swap(values[0], values[2]);
+
+            for (uint32_t c = 0; c < kernelFormat.channels; ++c)
+            {
+                if (kernelFormat.isSrgb && c < 3)
+                    pixel[c] = EncodeSrgb(tables, values[c]);
+                else
+                    EncodeChannel(values[c], pixel + c * kernelFormat.bytesPerChannel, kernelFormat);
+            }
+        }
+    }
+
+    void DownsampleBoxRow8(const uint8_t* row0, const uint8_t* row1, uint8_t* dest, uint32_t sourceWidth, uint32_t width, uint32_t channels)
+    {
+        uint32_t x = 0;
+#if ALIMER_SSE2
+        if (channels == 4)
+        {
+            // Destination texels with both source columns inside the row.
+            const uint32_t pairs = std::min(width, sourceWidth / 2);
+#if defined(__AVX2__)
+            const __m256i zero256 = _mm256_setzero_si256();
+            const __m256i round256 = _mm256_set1_epi16(2);
+            for (; x + 4 <= pairs; x += 4)
+            {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + x * 8));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + x * 8));
+                const __m256i low = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero256), _mm256_unpacklo_epi8(b, zero256));
+                const __m256i high = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero256), _mm256_unpackhi_epi8(b, zero256));
+                const __m256i lowSum = _mm256_add_epi16(low, _mm256_srli_si256(low, 8));
+                const __m256i highSum = _mm256_add_epi16(high, _mm256_srli_si256(high, 8));
+                const __m256i sum = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(lowSum, highSum), round256), 2);
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm256_castsi256_si128(packed));
+            }
+#endif
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(2);
+            for (; x + 2 <= pairs; x += 2)
+            {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+                const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                const __m128i lowSum = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+                const __m128i highSum = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+                const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lowSum, highSum), round), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + x * 4), _mm_packus_epi16(sum, sum));
+            }
+        }
+#endif
+
+        for (; x < width; ++x)
+        {
+            const uint32_t x0 = std::min(x * 2, sourceWidth - 1) * channels;
+            const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1) * channels;
+            for (uint32_t c = 0; c < channels; ++c)
+                dest[x * channels + c] = static_cast<uint8_t>((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+        }
+    }
+
+    void DownsampleBoxRow(const ImageTexel* row0, const ImageTexel* row1, ImageTexel* dest, uint32_t sourceWidth, uint32_t width)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+#if ALIMER_SSE2
+            const __m128 sum = _mm_add_ps(
+                _mm_add_ps(_mm_loadu_ps(&row0[x0].r), _mm_loadu_ps(&row0[x1].r)),
+                _mm_add_ps(_mm_loadu_ps(&row1[x0].r), _mm_loadu_ps(&row1[x1].r)));
+            _mm_storeu_ps(&dest[x].r, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+            dest[x].r = (row0[x0].r + row0[x1].r + row1[x0].r + row1[x1].r) * 0.25f;
+            dest[x].g = (row0[x0].g + row0[x1].g + row1[x0].g + row1[x1].g) * 0.25f;
+            dest[x].b = (row0[x0].b + row0[x1].b + row1[x0].b + row1[x1].b) * 0.25f;
+            dest[x].a = (row0[x0].a + row0[x1].a + row1[x0].a + row1[x1].a) * 0.25f;
+#endif
+        }
+    }
+
+    void DownsampleFilterRow(const ImageTexel* source, ImageTexel* dest, uint32_t sourceWidth, uint32_t width, const float* weights, uint32_t numWeights)
+    {
+        const int32_t lastColumn = static_cast<int32_t>(sourceWidth) - 1;
+        const int32_t firstOffset = 1 - static_cast<int32_t>(numWeights / 2);
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const int32_t first = static_cast<int32_t>(x * 2) + firstOffset;
+#if ALIMER_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t i = 0; i < numWeights; ++i)
+            {
+                const int32_t column = std::min(std::max(first + static_cast<int32_t>(i), 0), lastColumn);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&source[column].r), _mm_set1_ps(weights[i])));
+            }
+            _mm_storeu_ps(&dest[x].r, sum);
+#else
+            ImageTexel sum = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (uint32_t i = 0; i < numWeights; ++i)
+            {
+                const ImageTexel& texel = source[std::min(std::max(first + static_cast<int32_t>(i), 0), lastColumn)];
+                sum.r += texel.r * weights[i];
+                sum.g += texel.g * weights[i];
+                sum.b += texel.b * weights[i];
+                sum.a += texel.a * weights[i];
+            }
+            dest[x] = sum;
+#endif
+        }
+    }
+
+    void AccumulateRow(const ImageTexel* source, ImageTexel* dest, float weight, uint32_t width)
+    {
+        float* destValues = &dest->r;
+        const float* sourceValues = &source->r;
+        const uint32_t count = width * 4;
+        uint32_t i = 0;
+#if defined(__AVX2__)
+        const __m256 weight256 = _mm256_set1_ps(weight);
+        for (; i + 8 <= count; i += 8)
+            _mm256_storeu_ps(destValues + i, _mm256_add_ps(_mm256_loadu_ps(destValues + i), _mm256_mul_ps(_mm256_loadu_ps(sourceValues + i), weight256)));
+#endif
+#if ALIMER_SSE2
+        const __m128 weight128 = _mm_set1_ps(weight);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(destValues + i, _mm_add_ps(_mm_loadu_ps(destValues + i), _mm_mul_ps(_mm_loadu_ps(sourceValues + i), weight128)));
+#endif
+        for (; i < count; ++i)
+            destValues[i] += sourceValues[i] * weight;
+    }
+
+    void SwizzleRow8(const uint8_t* source, uint8_t* dest, uint32_t width, uint32_t channels, const uint32_t* map)
+    {
+        uint32_t x = 0;
+#if defined(__SSSE3__) || defined(__AVX2__)
+        if (channels == 4)
+        {
+            alignas(16) uint8_t shuffle[16];
+            for (uint32_t i = 0; i < 16; ++i)
+                shuffle[i] = static_cast<uint8_t>((i & ~3u) + map[i & 3]);
+
+            const __m128i mask = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle));
+#if defined(__AVX2__)
+            const __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+            for (; x + 8 <= width; x += 8)
+            {
+                const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + x * 4));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + x * 4), _mm256_shuffle_epi8(pixels, mask256));
+            }
+#endif
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), _mm_shuffle_epi8(pixels, mask));
+            }
+        }
+#elif ALIMER_SSE2
+        if (channels == 4)
+        {
+            // Move each channel with shifts of the 32-bit pixels, the shift counts are uniform for all pixels.
+            __m128i shiftRight[4];
+            __m128i shiftLeft[4];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                shiftRight[c] = _mm_cvtsi32_si128(static_cast<int>(map[c] * 8));
+                shiftLeft[c] = _mm_cvtsi32_si128(static_cast<int>(c * 8));
+            }
+
+            const __m128i byteMask = _mm_set1_epi32(0xff);
+            for (; x + 4 <= width; x += 4)
+            {
+                const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+                __m128i result = _mm_setzero_si128();
+                for (uint32_t c = 0; c < 4; ++c)
+                    result = _mm_or_si128(result, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(pixels, shiftRight[c]), byteMask), shiftLeft[c]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + x * 4), result);
+            }
+        }
+#endif
+
+        for (; x < width; ++x)
+        {
+            uint8_t pixel[4];
+            for (uint32_t c = 0; c < channels; ++c)
+                pixel[c] = source[x * channels + map[c]];
+            memcpy(dest + x * channels, pixel, channels);
+        }
+    }
+}
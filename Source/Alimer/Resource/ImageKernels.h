@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/PixelFormat.h"
+
+namespace Alimer
+{
+    /// Texel of the floating point image kernels. Color of sRGB formats is decoded to linear, alpha stays linear.
+    struct alignas(16) ImageTexel
+    {
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    /// Return whether the format can be decoded to and encoded from texels.
+    bool IsImageKernelFormat(PixelFormat format);
+
+    /// Decode a row of pixels to texels. Missing channels decode as 0 and alpha as 1.
+    void DecodeImageRow(PixelFormat format, const uint8_t* source, ImageTexel* dest, uint32_t width);
+
+    /// Encode a row of texels to pixels, clamping to the range of the format.
+    void EncodeImageRow(PixelFormat format, const ImageTexel* source, uint8_t* dest, uint32_t width);
+
+    /// Downsample two rows of 8-bit pixels with a 2x2 box filter and exact rounding. The last source column repeats for odd widths.
+    void DownsampleBoxRow8(const uint8_t* row0, const uint8_t* row1, uint8_t* dest, uint32_t sourceWidth, uint32_t width, uint32_t channels);
+
+    /// Downsample two rows of texels with a 2x2 box filter. The last source column repeats for odd widths.
+    void DownsampleBoxRow(const ImageTexel* row0, const ImageTexel* row1, ImageTexel* dest, uint32_t sourceWidth, uint32_t width);
+
+    /// Downsample a row of texels horizontally by two with symmetric weights around each destination texel, clamping at the edges. The number of weights must be even.
+    void DownsampleFilterRow(const ImageTexel* source, ImageTexel* dest, uint32_t sourceWidth, uint32_t width, const float* weights, uint32_t numWeights);
+
+    /// Add a weighted row of texels to the destination.
+    void AccumulateRow(const ImageTexel* source, ImageTexel* dest, float weight, uint32_t width);
+
+    /// Reorder the channels of a row of 8-bit pixels. Each destination channel takes the source channel given by map.
+    void SwizzleRow8(const uint8_t* source, uint8_t* dest, uint32_t width, uint32_t channels, const uint32_t* map);
+}
@@ -0,0 +1,483 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/PackageFile.h"
+#include "../IO/FileSystem.h"
+#include "../IO/MappedFileStream.h"
+#include "../IO/MemoryStream.h"
+#include "../IO/Compression.h"
+#include "../Core/Log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Alimer
+{
+    namespace
+    {
+        /// Owned decompressed data, initialized before the MemoryStream base.
+        struct PackageEntryBuffer
+        {
+            PackageEntryBuffer() = default;
+            PackageEntryBuffer(std::vector<uint8_t>&& data) : _data(std::move(data)) {}
+
+            std::vector<uint8_t> _data;
+        };
+
+        /// Read-only stream over package entry data, keeping the package alive while open.
+        class PackageEntryStream final : private PackageEntryBuffer, public MemoryStream
+        {
+        public:
+            /// Construct over memory mapped package data. A package that is not reference counted must outlive the stream.
+            PackageEntryStream(PackageFile* package, const uint8_t* data, size_t size)
+                : MemoryStream(static_cast<const void*>(data), size)
+            {
+                if (package->Refs() > 0)
+                    _package = package;
+            }
+
+            /// Construct over owned data.
+            PackageEntryStream(std::vector<uint8_t>&& data)
+                : PackageEntryBuffer(std::move(data))
+                , MemoryStream(static_cast<const std::vector<uint8_t>&>(_data))
+            {
+            }
+
+        private:
+            SharedPtr<PackageFile> _package;
+        };
+
+        uint64_t AlignOffset(uint64_t offset, uint32_t alignment)
+        {
+            return (offset + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+        }
+
+        bool WritePadding(Stream& stream, uint64_t alignedOffset)
+        {
+            static const uint8_t zeros[256] = {};
+            while (stream.GetPosition() < alignedOffset)
+            {
+                size_t count = std::min(sizeof(zeros), static_cast<size_t>(alignedOffset - stream.GetPosition()));
+                if (stream.Write(zeros, count) != count)
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+    PackageFile::PackageFile()
+        : _packageSize(0)
+    {
+    }
+
+    PackageFile::PackageFile(const String& fileName)
+        : _packageSize(0)
+    {
+        Open(fileName);
+    }
+
+    PackageFile::~PackageFile()
+    {
+        Close();
+    }
+
+    bool PackageFile::Open(const String& fileName)
+    {
+        Close();
+
+        if (FileSystem::Get().GetMemoryMapping())
+        {
+            _mapped.Reset(new MappedFileStream(fileName));
+            if (!_mapped->IsOpen())
+                _mapped.Reset();
+        }
+
+        if (!_mapped)
+        {
+            _file.Reset(new FileStream(fileName));
+            if (!_file->IsOpen())
+            {
+                _file.Reset();
+                ALIMER_LOGERRORF("Could not open package file '%s'", fileName.CString());
+                return false;
+            }
+        }
+
+        _fileName = fileName;
+        _packageSize = _mapped ? _mapped->GetSize() : _file->GetSize();
+
+        PackageHeader header;
+        if (_packageSize < sizeof(header)
+            || !ReadData(0, &header, sizeof(header))
+            || header.magic != PACKAGE_MAGIC)
+        {
+            ALIMER_LOGERRORF("'%s' is not a valid package file", fileName.CString());
+            Close();
+            return false;
+        }
+
+        if (header.version != PACKAGE_VERSION)
+        {
+            ALIMER_LOGERRORF("Package file '%s' has unsupported version %u", fileName.CString(), header.version);
+            Close();
+            return false;
+        }
+
+        uint64_t tocSize = static_cast<uint64_t>(header.entryCount) * sizeof(PackageEntry);
+        if (header.tocOffset > _packageSize || tocSize > _packageSize - header.tocOffset
+            || header.namesOffset > _packageSize || header.namesSize > _packageSize - header.namesOffset)
+        {
+            ALIMER_LOGERRORF("Package file '%s' has corrupted table of contents", fileName.CString());
+            Close();
+            return false;
+        }
+
+        _entries.resize(header.entryCount);
+        _names.resize(static_cast<size_t>(header.namesSize) + 1);
+        if (!ReadData(header.tocOffset, _entries.data(), static_cast<size_t>(tocSize))
+            || !ReadData(header.namesOffset, _names.data(), static_cast<size_t>(header.namesSize)))
+        {
+            ALIMER_LOGERRORF("Failed to read table of contents of package file '%s'", fileName.CString());
+            Close();
+            return false;
+        }
+        _names.back() = '\0';
+
+        for (size_t i = 0; i < _entries.size(); ++i)
+        {
+            const PackageEntry& entry = _entries[i];
+            bool compressed = any(entry.flags & PackageEntryFlags::CompressedLZ4);
+            if (entry.offset > _packageSize || entry.size > _packageSize - entry.offset
+                || entry.nameOffset >= header.namesSize
+                || (!compressed && entry.size != entry.uncompressedSize)
+                || (compressed && entry.uncompressedSize > GetDecompressBound(entry.size))
+                || (i > 0 && _entries[i - 1].nameHash > entry.nameHash))
+            {
+                ALIMER_LOGERRORF("Package file '%s' has corrupted entry %u", fileName.CString(), static_cast<uint32_t>(i));
+                Close();
+                return false;
+            }
+        }
+
+        ALIMER_LOGDEBUGF("Opened package file '%s' with %u entries", fileName.CString(), header.entryCount);
+        return true;
+    }
+
+    void PackageFile::Close()
+    {
+        _mapped.Reset();
+        _file.Reset();
+        _packageSize = 0;
+        _entries.clear();
+        _names.clear();
+    }
+
+    bool PackageFile::Exists(const String& name) const
+    {
+        return GetEntry(name) != nullptr;
+    }
+
+    const PackageEntry* PackageFile::GetEntry(const String& name) const
+    {
+        String normalizedName = NormalizeName(name);
+        uint64_t nameHash = HashName(normalizedName);
+
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), nameHash, [](const PackageEntry& entry, uint64_t hash)
+        {
+            return entry.nameHash < hash;
+        });
+
+        // Compare names to resolve possible hash collisions.
+        for (; it != _entries.end() && it->nameHash == nameHash; ++it)
+        {
+            if (normalizedName == &_names[it->nameOffset])
+                return &*it;
+        }
+
+        return nullptr;
+    }
+
+    UniquePtr<Stream> PackageFile::OpenEntry(const String& name)
+    {
+        const PackageEntry* entry = GetEntry(name);
+        if (!entry)
+            return {};
+
+        UniquePtr<Stream> stream;
+        if (_mapped && !any(entry->flags & PackageEntryFlags::CompressedLZ4))
+        {
+            stream.Reset(new PackageEntryStream(this, _mapped->GetData() + entry->offset, static_cast<size_t>(entry->size)));
+        }
+        else
+        {
+            std::vector<uint8_t> data(static_cast<size_t>(entry->uncompressedSize));
+            if (!ReadEntry(*entry, data.data()))
+                return {};
+
+            stream.Reset(new PackageEntryStream(std::move(data)));
+        }
+
+        stream->SetName(_fileName + "/" + GetEntryName(*entry));
+        return stream;
+    }
+
+    bool PackageFile::ReadEntry(const PackageEntry& entry, void* dest)
+    {
+        if (!any(entry.flags & PackageEntryFlags::CompressedLZ4))
+            return ReadData(entry.offset, dest, static_cast<size_t>(entry.size));
+
+        const uint8_t* compressedData = nullptr;
+        std::vector<uint8_t> buffer;
+        if (_mapped)
+        {
+            compressedData = _mapped->GetData() + entry.offset;
+        }
+        else
+        {
+            buffer.resize(static_cast<size_t>(entry.size));
+            if (!ReadData(entry.offset, buffer.data(), buffer.size()))
+                return false;
+            compressedData = buffer.data();
+        }
+
+        size_t size = static_cast<size_t>(entry.uncompressedSize);
+        if (DecompressLZ4(compressedData, static_cast<size_t>(entry.size), dest, size) != size)
+        {
+            ALIMER_LOGERRORF("Failed to decompress '%s' from package file '%s'", GetEntryName(entry).CString(), _fileName.CString());
+            return false;
+        }
+
+        return true;
+    }
+
+    String PackageFile::GetEntryName(const PackageEntry& entry) const
+    {
+        return entry.nameOffset < _names.size() ? String(&_names[entry.nameOffset]) : String::EMPTY;
+    }
+
+    bool PackageFile::ReadData(uint64_t offset, void* dest, size_t size)
+    {
+        if (offset > _packageSize || size > _packageSize - offset)
+            return false;
+
+        if (!size)
+            return true;
+
+        if (_mapped)
+        {
+            memcpy(dest, _mapped->GetData() + offset, size);
+            return true;
+        }
+
+        std::lock_guard<std::mutex> guard(_fileMutex);
+        return _file && _file->Seek(static_cast<size_t>(offset)) && _file->Read(dest, size) == size;
+    }
+
+    String PackageFile::NormalizeName(const String& name)
+    {
+        String result = name.Replaced('\\', '/').ToLower();
+        size_t start = 0;
+        while (start < result.Length() && result[start] == '/')
+            ++start;
+        return start ? result.Substring(start) : result;
+    }
+
+    uint64_t PackageFile::HashName(const String& name)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t i = 0; i < name.Length(); ++i)
+        {
+            hash ^= static_cast<uint8_t>(name[i]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    PackageFileSystemProtocol::PackageFileSystemProtocol(PackageFile* package)
+        : _package(package)
+    {
+    }
+
+    bool PackageFileSystemProtocol::Exists(const String& path)
+    {
+        return _package->Exists(path);
+    }
+
+    UniquePtr<Stream> PackageFileSystemProtocol::Open(const String& path, FileAccess mode)
+    {
+        if (mode != FileAccess::ReadOnly)
+        {
+            ALIMER_LOGERROR("Package entries can only be opened for reading");
+            return {};
+        }
+
+        return _package->OpenEntry(path);
+    }
+
+    bool PackageFileSystemProtocol::SetChangeCallback(MAYBE_UNUSED const FileWatcher::Callback& callback)
+    {
+        // Package content does not change while open.
+        return true;
+    }
+
+    PackageBuilder::PackageBuilder()
+        : _defaultAlignment(PACKAGE_DEFAULT_ALIGNMENT)
+        , _compressionLevel(CompressionLevel::Fast)
+    {
+    }
+
+    void PackageBuilder::AddFile(const String& name, const String& fileName, bool compress, uint32_t alignment)
+    {
+        _sources.push_back({ name, fileName, {}, compress, alignment });
+    }
+
+    void PackageBuilder::AddData(const String& name, std::vector<uint8_t> data, bool compress, uint32_t alignment)
+    {
+        _sources.push_back({ name, String::EMPTY, std::move(data), compress, alignment });
+    }
+
+    void PackageBuilder::SetDefaultAlignment(uint32_t alignment)
+    {
+        ALIMER_ASSERT(alignment && !(alignment & (alignment - 1)));
+        _defaultAlignment = alignment;
+    }
+
+    bool PackageBuilder::Save(const String& fileName)
+    {
+        std::vector<PackageEntry> entries;
+        std::vector<char> names;
+        entries.reserve(_sources.size());
+
+        // Reject duplicate names up front, the package lookup would silently return the first one.
+        std::vector<std::pair<uint64_t, String>> sortedNames;
+        sortedNames.reserve(_sources.size());
+        for (const Source& source : _sources)
+        {
+            String name = PackageFile::NormalizeName(source.name);
+            sortedNames.emplace_back(PackageFile::HashName(name), name);
+        }
+        std::sort(sortedNames.begin(), sortedNames.end());
+        for (size_t i = 1; i < sortedNames.size(); ++i)
+        {
+            if (sortedNames[i] == sortedNames[i - 1])
+            {
+                ALIMER_LOGERRORF("Duplicate package entry '%s'", sortedNames[i].second.CString());
+                return false;
+            }
+        }
+
+        FileStream stream(fileName, FileAccess::WriteOnly);
+        if (!stream.IsOpen())
+        {
+            ALIMER_LOGERRORF("Could not create package file '%s'", fileName.CString());
+            return false;
+        }
+
+        // Header is written last, once the table of contents offsets are known.
+        PackageHeader header = {};
+        if (!WritePadding(stream, sizeof(header)))
+            return false;
+
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> compressed;
+        for (const Source& source : _sources)
+        {
+            const std::vector<uint8_t>* entryData = &source.data;
+            if (source.fileName.Length())
+            {
+                FileStream sourceFile(source.fileName);
+                if (!sourceFile.IsOpen())
+                {
+                    ALIMER_LOGERRORF("Could not open '%s' for packaging", source.fileName.CString());
+                    return false;
+                }
+
+                data.resize(sourceFile.GetSize());
+                if (sourceFile.Read(data.data(), data.size()) != data.size())
+                {
+                    ALIMER_LOGERRORF("Failed to read '%s' for packaging", source.fileName.CString());
+                    return false;
+                }
+                entryData = &data;
+            }
+
+            String name = PackageFile::NormalizeName(source.name);
+            PackageEntry entry = {};
+            entry.nameHash = PackageFile::HashName(name);
+            entry.uncompressedSize = entryData->size();
+            entry.nameOffset = static_cast<uint32_t>(names.size());
+            entry.flags = PackageEntryFlags::None;
+            names.insert(names.end(), name.CString(), name.CString() + name.Length() + 1);
+
+            const uint8_t* writeData = entryData->data();
+            size_t writeSize = entryData->size();
+            if (source.compress && writeSize)
+            {
+                compressed.resize(GetCompressBound(writeSize));
+                size_t compressedSize = CompressLZ4(entryData->data(), writeSize, compressed.data(), compressed.size(), _compressionLevel);
+
+                // Keep data uncompressed unless it saves enough to pay for decompression.
+                if (compressedSize && compressedSize < writeSize - writeSize / 16)
+                {
+                    writeData = compressed.data();
+                    writeSize = compressedSize;
+                    entry.flags |= PackageEntryFlags::CompressedLZ4;
+                }
+            }
+
+            entry.offset = AlignOffset(stream.GetPosition(), source.alignment ? source.alignment : _defaultAlignment);
+            entry.size = writeSize;
+            if (!WritePadding(stream, entry.offset) || stream.Write(writeData, writeSize) != writeSize)
+            {
+                ALIMER_LOGERRORF("Failed to write package file '%s'", fileName.CString());
+                return false;
+            }
+
+            entries.push_back(entry);
+        }
+
+        std::stable_sort(entries.begin(), entries.end(), [](const PackageEntry& lhs, const PackageEntry& rhs)
+        {
+            return lhs.nameHash < rhs.nameHash;
+        });
+
+        header.magic = PACKAGE_MAGIC;
+        header.version = PACKAGE_VERSION;
+        header.entryCount = static_cast<uint32_t>(entries.size());
+        header.tocOffset = AlignOffset(stream.GetPosition(), alignof(PackageEntry));
+        header.namesOffset = header.tocOffset + entries.size() * sizeof(PackageEntry);
+        header.namesSize = names.size();
+
+        size_t tocSize = entries.size() * sizeof(PackageEntry);
+        if (!WritePadding(stream, header.tocOffset)
+            || stream.Write(entries.data(), tocSize) != tocSize
+            || stream.Write(names.data(), names.size()) != names.size()
+            || !stream.Seek(0)
+            || stream.Write(&header, sizeof(header)) != sizeof(header))
+        {
+            ALIMER_LOGERRORF("Failed to write package file '%s'", fileName.CString());
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,221 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Core/Object.h"
+#include "../IO/Stream.h"
+#include "../IO/Compression.h"
+#include "../IO/FileSystem.h"
+#include <mutex>
+#include <vector>
+
+namespace Alimer
+{
+    class FileStream;
+    class MappedFileStream;
+
+    /// Package file magic, "APAK".
+    static constexpr uint32_t PACKAGE_MAGIC = 0x4B415041;
+    /// Package file format version.
+    static constexpr uint32_t PACKAGE_VERSION = 1;
+    /// Default data alignment of package entries.
+    static constexpr uint32_t PACKAGE_DEFAULT_ALIGNMENT = 16;
+
+    /// Package entry flags.
+    enum class PackageEntryFlags : uint32_t
+    {
+        None = 0,
+        /// Entry data is compressed in LZ4 block format.
+        CompressedLZ4 = 0x1
+    };
+    ALIMER_BITMASK(PackageEntryFlags);
+
+    /// Package file header, stored at the beginning of the file.
+    struct PackageHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t flags;
+        /// Offset of the table of contents, entries sorted by name hash.
+        uint64_t tocOffset;
+        /// Offset of the null terminated entry names.
+        uint64_t namesOffset;
+        uint64_t namesSize;
+    };
+
+    /// Package table of contents entry.
+    struct PackageEntry
+    {
+        /// 64-bit hash of the normalized entry name.
+        uint64_t nameHash;
+        /// Offset of entry data from the beginning of the file.
+        uint64_t offset;
+        /// Size of stored data.
+        uint64_t size;
+        /// Size of data after decompression.
+        uint64_t uncompressedSize;
+        /// Offset of the entry name in the names table.
+        uint32_t nameOffset;
+        /// Entry flags.
+        PackageEntryFlags flags;
+    };
+
+    static_assert(sizeof(PackageHeader) == 40, "Invalid PackageHeader size");
+    static_assert(sizeof(PackageEntry) == 40, "Invalid PackageEntry size");
+
+    /// Read-only archive of resource files with a hash sorted table of contents.
+    class ALIMER_API PackageFile final : public Object
+    {
+        ALIMER_OBJECT(PackageFile, Object);
+
+    public:
+        /// Constructor.
+        PackageFile();
+
+        /// Construct and open.
+        PackageFile(const String& fileName);
+
+        /// Destructor.
+        ~PackageFile() override;
+
+        /// Open the package file and read the table of contents. Return true on success.
+        bool Open(const String& fileName);
+
+        /// Close the package file.
+        void Close();
+
+        /// Return whether the package contains an entry.
+        bool Exists(const String& name) const;
+
+        /// Return entry by name, or null if not found.
+        const PackageEntry* GetEntry(const String& name) const;
+
+        /// Open entry for reading. Uncompressed entries of a memory mapped package are read without copying.
+        UniquePtr<Stream> OpenEntry(const String& name);
+
+        /// Read entry data into a buffer of uncompressedSize bytes. Return true on success.
+        bool ReadEntry(const PackageEntry& entry, void* dest);
+
+        /// Return entry name.
+        String GetEntryName(const PackageEntry& entry) const;
+
+        /// Return all entries, sorted by name hash.
+        const std::vector<PackageEntry>& GetEntries() const { return _entries; }
+
+        /// Return number of entries.
+        size_t GetNumEntries() const { return _entries.size(); }
+
+        /// Return package file name.
+        const String& GetName() const { return _fileName; }
+
+        /// Return whether is open.
+        bool IsOpen() const { return _packageSize != 0; }
+
+        /// Return whether the package is memory mapped.
+        bool IsMapped() const { return _mapped.IsNotNull(); }
+
+        /// Normalize an entry name: use slashes, no leading slash and lowercase.
+        static String NormalizeName(const String& name);
+
+        /// Return 64-bit FNV-1a hash of the normalized entry name.
+        static uint64_t HashName(const String& name);
+
+    private:
+        /// Read from the package file.
+        bool ReadData(uint64_t offset, void* dest, size_t size);
+
+        /// Package file name.
+        String _fileName;
+        /// Memory mapped package.
+        UniquePtr<MappedFileStream> _mapped;
+        /// Package file when memory mapping is not used.
+        UniquePtr<FileStream> _file;
+        /// Mutex for reads through the package file.
+        std::mutex _fileMutex;
+        /// Package size in bytes.
+        uint64_t _packageSize;
+        /// Table of contents.
+        std::vector<PackageEntry> _entries;
+        /// Entry names.
+        std::vector<char> _names;
+    };
+
+    /// File system protocol serving the entries of a package file, for mounting in a VirtualFileSystem.
+    class ALIMER_API PackageFileSystemProtocol final : public FileSystemProtocol
+    {
+    public:
+        /// Construct over an opened package.
+        PackageFileSystemProtocol(PackageFile* package);
+
+        bool Exists(const String& path) override;
+        UniquePtr<Stream> Open(const String& path, FileAccess mode = FileAccess::ReadOnly) override;
+        bool SetChangeCallback(const FileWatcher::Callback& callback) override;
+
+        /// Return the package.
+        PackageFile* GetPackage() const { return _package.Get(); }
+
+    private:
+        SharedPtr<PackageFile> _package;
+    };
+
+    /// Writes package files.
+    class ALIMER_API PackageBuilder final
+    {
+    public:
+        /// Constructor.
+        PackageBuilder();
+
+        /// Add a file from disk. Zero alignment uses the default alignment.
+        void AddFile(const String& name, const String& fileName, bool compress, uint32_t alignment = 0);
+
+        /// Add an entry from memory. Zero alignment uses the default alignment.
+        void AddData(const String& name, std::vector<uint8_t> data, bool compress, uint32_t alignment = 0);
+
+        /// Write the package. Return true on success.
+        bool Save(const String& fileName);
+
+        /// Set default entry alignment, must be power of two.
+        void SetDefaultAlignment(uint32_t alignment);
+
+        /// Set compression level of compressed entries.
+        void SetCompressionLevel(CompressionLevel level) { _compressionLevel = level; }
+
+        /// Return number of added entries.
+        size_t GetNumEntries() const { return _sources.size(); }
+
+    private:
+        struct Source
+        {
+            String name;
+            String fileName;
+            std::vector<uint8_t> data;
+            bool compress;
+            uint32_t alignment;
+        };
+
+        std::vector<Source> _sources;
+        uint32_t _defaultAlignment;
+        CompressionLevel _compressionLevel;
+    };
+}
@@ -0,0 +1,647 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Resource/PngDecoder.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace Alimer
+{
+    static const uint8_t PNG_SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    /// Largest supported width or height in pixels.
+    static constexpr uint32_t PNG_MAX_DIMENSION = 1u << 24;
+    /// Size of the deflate back-reference window.
+    static constexpr size_t INFLATE_WINDOW_SIZE = 32768;
+    /// Longest deflate match.
+    static constexpr size_t INFLATE_MAX_MATCH = 258;
+
+    static const uint16_t INFLATE_LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t INFLATE_LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t INFLATE_DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t INFLATE_DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    static const uint8_t INFLATE_CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    static uint32_t ReadBigEndian(const uint8_t* data)
+    {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+    }
+
+    /// Canonical Huffman code of deflate. Short codes decode through a table of the next bits, longer codes bit by bit.
+    struct HuffmanCode
+    {
+        static constexpr uint32_t FAST_BITS = 9;
+
+        bool Build(const uint8_t* lengths, uint32_t numSymbols)
+        {
+            memset(count, 0, sizeof(count));
+            memset(fast, 0, sizeof(fast));
+            for (uint32_t i = 0; i < numSymbols; ++i)
+                ++count[lengths[i]];
+            count[0] = 0;
+
+            // Over-subscribed codes are invalid, incomplete ones are allowed.
+            int32_t left = 1;
+            for (uint32_t length = 1; length < 16; ++length)
+            {
+                left = (left << 1) - count[length];
+                if (left < 0)
+                    return false;
+            }
+
+            uint16_t offsets[16];
+            uint32_t nextCode[16];
+            uint32_t code = 0;
+            offsets[1] = 0;
+            for (uint32_t length = 1; length < 16; ++length)
+            {
+                code = (code + count[length - 1]) << 1;
+                nextCode[length] = code;
+                if (length < 15)
+                    offsets[length + 1] = offsets[length] + count[length];
+            }
+
+            for (uint32_t symbol = 0; symbol < numSymbols; ++symbol)
+            {
+                const uint32_t length = lengths[symbol];
+                if (!length)
+                    continue;
+
+                symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+                const uint32_t symbolCode = nextCode[length]++;
+                if (length <= FAST_BITS)
+                {
+                    // Deflate stores codes from the most significant bit, the table is indexed by the stream order.
+                    uint32_t reversed = 0;
+                    for (uint32_t i = 0; i < length; ++i)
+                        reversed |= ((symbolCode >> i) & 1) << (length - 1 - i);
+                    for (uint32_t i = reversed; i < (1u << FAST_BITS); i += 1u << length)
+                        fast[i] = static_cast<uint16_t>((length << FAST_BITS) | symbol);
+                }
+            }
+
+            return true;
+        }
+
+        /// Length and symbol of codes up to FAST_BITS long, indexed by the next bits of the stream. Zero for longer codes.
+        uint16_t fast[1 << FAST_BITS];
+        /// Number of codes of each length.
+        uint16_t count[16];
+        /// Symbols ordered by code.
+        uint16_t symbols[288];
+    };
+
+    /// Inflater of a zlib stream split over several buffers. Output is passed to a callback in chunks as the window fills.
+    class Inflater
+    {
+    public:
+        typedef std::function<bool(const uint8_t* data, size_t size)> OutputCallback;
+
+        Inflater(const std::vector<std::pair<const uint8_t*, size_t>>& input)
+            : _input(input)
+            , _window(INFLATE_WINDOW_SIZE * 2)
+        {
+        }
+
+        /// Inflate the whole stream. Return false if the stream is invalid or the callback returned false.
+        bool Run(const OutputCallback& output)
+        {
+            _output = &output;
+            const uint32_t method = GetBits(8);
+            const uint32_t flags = GetBits(8);
+            if ((method & 15) != 8 || ((method << 8) | flags) % 31 != 0 || (flags & 32))
+                return false;
+
+            bool finalBlock = false;
+            while (!finalBlock)
+            {
+                finalBlock = GetBits(1) != 0;
+                bool success;
+                switch (GetBits(2))
+                {
+                case 0:
+                    success = InflateStored();
+                    break;
+                case 1:
+                    success = InflateFixed();
+                    break;
+                case 2:
+                    success = InflateDynamic();
+                    break;
+                default:
+                    success = false;
+                    break;
+                }
+
+                if (!success || _truncated)
+                    return false;
+            }
+
+            return Flush();
+        }
+
+    private:
+        void Refill()
+        {
+            while (_numBits <= 56)
+            {
+                while (_next == _end && _inputIndex < _input.size())
+                {
+                    _next = _input[_inputIndex].first;
+                    _end = _next + _input[_inputIndex].second;
+                    ++_inputIndex;
+                }
+
+                // Past the end read zeros, a stream that consumes more than the lookahead of them is truncated.
+                uint64_t value = 0;
+                if (_next != _end)
+                    value = *_next++;
+                else if (++_padding > 8)
+                    _truncated = true;
+
+                _bitBuffer |= value << _numBits;
+                _numBits += 8;
+            }
+        }
+
+        uint32_t GetBits(uint32_t count)
+        {
+            if (_numBits < count)
+                Refill();
+
+            const uint32_t value = static_cast<uint32_t>(_bitBuffer & ((1ull << count) - 1));
+            _bitBuffer >>= count;
+            _numBits -= count;
+            return value;
+        }
+
+        /// Decode a symbol, or return -1 for an invalid code.
+        int32_t DecodeSymbol(const HuffmanCode& code)
+        {
+            if (_numBits < 16)
+                Refill();
+
+            const uint32_t entry = code.fast[_bitBuffer & ((1u << HuffmanCode::FAST_BITS) - 1)];
+            if (entry)
+            {
+                const uint32_t length = entry >> HuffmanCode::FAST_BITS;
+                _bitBuffer >>= length;
+                _numBits -= length;
+                return static_cast<int32_t>(entry & ((1u << HuffmanCode::FAST_BITS) - 1));
+            }
+
+            int32_t value = 0;
+            int32_t first = 0;
+            int32_t index = 0;
+            for (uint32_t length = 1; length < 16; ++length)
+            {
+                value |= static_cast<int32_t>((_bitBuffer >> (length - 1)) & 1);
+                const int32_t count = code.count[length];
+                if (value - count < first)
+                {
+                    _bitBuffer >>= length;
+                    _numBits -= length;
+                    return code.symbols[index + (value - first)];
+                }
+
+                index += count;
+                first = (first + count) << 1;
+                value <<= 1;
+            }
+
+            return -1;
+        }
+
+        /// Pass pending output to the callback.
+        bool Flush()
+        {
+            if (_position > _flushed && !(*_output)(_window.data() + _flushed, _position - _flushed))
+                return false;
+            _flushed = _position;
+            return true;
+        }
+
+        /// Make room for a match, keeping the last window of output for back-references.
+        bool Reserve()
+        {
+            if (_position + INFLATE_MAX_MATCH <= _window.size())
+                return true;
+
+            if (!Flush())
+                return false;
+
+            memmove(_window.data(), _window.data() + _position - INFLATE_WINDOW_SIZE, INFLATE_WINDOW_SIZE);
+            _position = _flushed = INFLATE_WINDOW_SIZE;
+            return true;
+        }
+
+        bool InflateStored()
+        {
+            // Stored data starts at the next byte boundary.
+            GetBits(_numBits & 7);
+            const uint32_t length = GetBits(16);
+            const uint32_t inverse = GetBits(16);
+            if ((length ^ 0xffff) != inverse)
+                return false;
+
+            for (uint32_t i = 0; i < length; ++i)
+            {
+                if (!Reserve())
+                    return false;
+                _window[_position++] = static_cast<uint8_t>(GetBits(8));
+            }
+
+            return true;
+        }
+
+        bool InflateFixed()
+        {
+            uint8_t lengths[288 + 30];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            memset(lengths + 288, 5, 30);
+            return _literals.Build(lengths, 288) && _distances.Build(lengths + 288, 30) && InflateCodes();
+        }
+
+        bool InflateDynamic()
+        {
+            const uint32_t numLiterals = GetBits(5) + 257;
+            const uint32_t numDistances = GetBits(5) + 1;
+            const uint32_t numCodeLengths = GetBits(4) + 4;
+            if (numLiterals > 286 || numDistances > 30)
+                return false;
+
+            uint8_t codeLengths[19] = {};
+            for (uint32_t i = 0; i < numCodeLengths; ++i)
+                codeLengths[INFLATE_CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(GetBits(3));
+
+            HuffmanCode codeLengthCode;
+            if (!codeLengthCode.Build(codeLengths, 19))
+                return false;
+
+            uint8_t lengths[286 + 30];
+            uint32_t count = 0;
+            while (count < numLiterals + numDistances)
+            {
+                const int32_t symbol = DecodeSymbol(codeLengthCode);
+                if (symbol < 0 || _truncated)
+                    return false;
+
+                if (symbol < 16)
+                {
+                    lengths[count++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                uint8_t value = 0;
+                uint32_t repeat;
+                if (symbol == 16)
+                {
+                    if (!count)
+                        return false;
+                    value = lengths[count - 1];
+                    repeat = 3 + GetBits(2);
+                }
+                else if (symbol == 17)
+                    repeat = 3 + GetBits(3);
+                else
+                    repeat = 11 + GetBits(7);
+
+                if (count + repeat > numLiterals + numDistances)
+                    return false;
+                memset(lengths + count, value, repeat);
+                count += repeat;
+            }
+
+            // The end of block code must exist.
+            if (!lengths[256])
+                return false;
+
+            return _literals.Build(lengths, numLiterals) && _distances.Build(lengths + numLiterals, numDistances) && InflateCodes();
+        }
+
+        bool InflateCodes()
+        {
+            for (;;)
+            {
+                const int32_t symbol = DecodeSymbol(_literals);
+                if (symbol < 0 || _truncated || !Reserve())
+                    return false;
+
+                if (symbol < 256)
+                {
+                    _window[_position++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                if (symbol == 256)
+                    return true;
+
+                const uint32_t lengthSymbol = static_cast<uint32_t>(symbol) - 257;
+                if (lengthSymbol >= 29)
+                    return false;
+                const uint32_t length = INFLATE_LENGTH_BASE[lengthSymbol] + GetBits(INFLATE_LENGTH_EXTRA[lengthSymbol]);
+
+                const int32_t distanceSymbol = DecodeSymbol(_distances);
+                if (distanceSymbol < 0 || distanceSymbol >= 30)
+                    return false;
+                const uint32_t distance = INFLATE_DISTANCE_BASE[distanceSymbol] + GetBits(INFLATE_DISTANCE_EXTRA[distanceSymbol]);
+                if (distance > _position)
+                    return false;
+
+                // Matches may overlap their own output, copy forwards.
+                uint8_t* dest = _window.data() + _position;
+                const uint8_t* source = dest - distance;
+                if (distance >= length)
+                    memcpy(dest, source, length);
+                else
+                {
+                    for (uint32_t i = 0; i < length; ++i)
+                        dest[i] = source[i];
+                }
+                _position += length;
+            }
+        }
+
+        const std::vector<std::pair<const uint8_t*, size_t>>& _input;
+        size_t _inputIndex = 0;
+        const uint8_t* _next = nullptr;
+        const uint8_t* _end = nullptr;
+        uint64_t _bitBuffer = 0;
+        uint32_t _numBits = 0;
+        uint32_t _padding = 0;
+        bool _truncated = false;
+
+        std::vector<uint8_t> _window;
+        size_t _position = 0;
+        size_t _flushed = 0;
+        const OutputCallback* _output = nullptr;
+        HuffmanCode _literals;
+        HuffmanCode _distances;
+    };
+
+    /// Reverse a PNG row filter in place. The previous row is already unfiltered, or zeros for the first row.
+    static bool UnfilterRow(uint32_t filter, uint8_t* row, const uint8_t* previous, size_t rowBytes, uint32_t pixelBytes)
+    {
+        switch (filter)
+        {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = pixelBytes; i < rowBytes; ++i)
+                row[i] = static_cast<uint8_t>(row[i] + row[i - pixelBytes]);
+            break;
+        case 2:
+            for (size_t i = 0; i < rowBytes; ++i)
+                row[i] = static_cast<uint8_t>(row[i] + previous[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                const uint32_t left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+                row[i] = static_cast<uint8_t>(row[i] + ((left + previous[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                const int32_t left = i >= pixelBytes ? row[i - pixelBytes] : 0;
+                const int32_t up = previous[i];
+                const int32_t upLeft = i >= pixelBytes ? previous[i - pixelBytes] : 0;
+                const int32_t estimate = left + up - upLeft;
+                const int32_t distanceLeft = std::abs(estimate - left);
+                const int32_t distanceUp = std::abs(estimate - up);
+                const int32_t distanceUpLeft = std::abs(estimate - upLeft);
+                const int32_t predictor = (distanceLeft <= distanceUp && distanceLeft <= distanceUpLeft) ? left : (distanceUp <= distanceUpLeft ? up : upLeft);
+                row[i] = static_cast<uint8_t>(row[i] + predictor);
+            }
+            break;
+        default:
+            return false;
+        }
+
+        return true;
+    }
+
+    PngDecoder::PngDecoder(const void* data, size_t size)
+        : _data(static_cast<const uint8_t*>(data))
+        , _size(size)
+    {
+    }
+
+    bool PngDecoder::IsPng(const void* data, size_t size)
+    {
+        return size >= sizeof(PNG_SIGNATURE) && memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0;
+    }
+
+    bool PngDecoder::ReadHeader()
+    {
+        if (!IsPng(_data, _size))
+            return false;
+
+        bool hasHeader = false;
+        uint32_t bitDepth = 0;
+        uint32_t interlace = 0;
+        const uint8_t* transparency = nullptr;
+        uint32_t transparencySize = 0;
+        _imageData.clear();
+        _paletteSize = 0;
+
+        // Entries missing from the palette are opaque black.
+        for (uint8_t (&entry)[4] : _palette)
+        {
+            memset(entry, 0, 3);
+            entry[3] = 255;
+        }
+
+        size_t position = sizeof(PNG_SIGNATURE);
+        while (position + 12 <= _size)
+        {
+            const uint32_t length = ReadBigEndian(_data + position);
+            const uint8_t* type = _data + position + 4;
+            const uint8_t* chunk = _data + position + 8;
+            if (length > _size - position - 12)
+                return false;
+
+            if (!memcmp(type, "IHDR", 4))
+            {
+                if (length != 13)
+                    return false;
+                _width = ReadBigEndian(chunk);
+                _height = ReadBigEndian(chunk + 4);
+                bitDepth = chunk[8];
+                _colorType = chunk[9];
+                // Compression and filter methods must be 0.
+                if (chunk[10] || chunk[11])
+                    return false;
+                interlace = chunk[12];
+                hasHeader = true;
+            }
+            else if (!memcmp(type, "PLTE", 4))
+            {
+                if (length % 3 || length > 256 * 3)
+                    return false;
+                _paletteSize = length / 3;
+                for (uint32_t i = 0; i < _paletteSize; ++i)
+                {
+                    memcpy(_palette[i], chunk + i * 3, 3);
+                    _palette[i][3] = 255;
+                }
+            }
+            else if (!memcmp(type, "tRNS", 4))
+            {
+                transparency = chunk;
+                transparencySize = length;
+            }
+            else if (!memcmp(type, "IDAT", 4))
+                _imageData.push_back(std::make_pair(chunk, static_cast<size_t>(length)));
+            else if (!memcmp(type, "IEND", 4))
+                break;
+
+            position += 12 + length;
+        }
+
+        static const uint32_t channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+        if (!hasHeader || !_width || !_height || _width > PNG_MAX_DIMENSION || _height > PNG_MAX_DIMENSION || bitDepth != 8 || interlace
+            || _colorType > 6 || !channels[_colorType] || (_colorType == 3 && !_paletteSize) || _imageData.empty())
+        {
+            return false;
+        }
+
+        _channels = channels[_colorType];
+        if (transparency)
+        {
+            if (_colorType == 3)
+            {
+                for (uint32_t i = 0; i < std::min(transparencySize, _paletteSize); ++i)
+                    _palette[i][3] = transparency[i];
+            }
+            else if ((_colorType == 0 && transparencySize == 2) || (_colorType == 2 && transparencySize == 6))
+            {
+                // Keys are 16-bit, of which 8-bit images use the low byte.
+                _hasColorKey = true;
+                for (uint32_t i = 0; i < transparencySize / 2; ++i)
+                    _colorKey[i] = transparency[i * 2 + 1];
+            }
+        }
+
+        return true;
+    }
+
+    bool PngDecoder::ConvertRow(const uint8_t* source, uint8_t* dest) const
+    {
+        switch (_colorType)
+        {
+        case 0:
+            for (uint32_t x = 0; x < _width; ++x, dest += 4)
+            {
+                dest[0] = dest[1] = dest[2] = source[x];
+                dest[3] = (_hasColorKey && source[x] == _colorKey[0]) ? 0 : 255;
+            }
+            break;
+        case 2:
+            for (uint32_t x = 0; x < _width; ++x, source += 3, dest += 4)
+            {
+                dest[0] = source[0];
+                dest[1] = source[1];
+                dest[2] = source[2];
+                dest[3] = (_hasColorKey && !memcmp(source, _colorKey, 3)) ? 0 : 255;
+            }
+            break;
+        case 3:
+            for (uint32_t x = 0; x < _width; ++x, dest += 4)
+            {
+                if (source[x] >= _paletteSize)
+                    return false;
+                memcpy(dest, _palette[source[x]], 4);
+            }
+            break;
+        case 4:
+            for (uint32_t x = 0; x < _width; ++x, source += 2, dest += 4)
+            {
+                dest[0] = dest[1] = dest[2] = source[0];
+                dest[3] = source[1];
+            }
+            break;
+        default:
+            memcpy(dest, source, _width * 4);
+            break;
+        }
+
+        return true;
+    }
+
+    bool PngDecoder::Decode(uint8_t* dest, size_t rowPitch)
+    {
+        if (!_channels)
+            return false;
+
+        // Only the row being assembled and the previous unfiltered row are kept.
+        const size_t rowBytes = static_cast<size_t>(_width) * _channels;
+        std::vector<uint8_t> rows(rowBytes * 2);
+        uint8_t* row = rows.data();
+        uint8_t* previous = rows.data() + rowBytes;
+        size_t filled = 0;
+        bool hasFilter = false;
+        uint32_t filter = 0;
+        uint32_t y = 0;
+
+        Inflater inflater(_imageData);
+        const bool success = inflater.Run([&](const uint8_t* data, size_t size) {
+            // Data past the last row is ignored.
+            while (size && y < _height)
+            {
+                if (!hasFilter)
+                {
+                    filter = *data++;
+                    --size;
+                    hasFilter = true;
+                    continue;
+                }
+
+                const size_t count = std::min(size, rowBytes - filled);
+                memcpy(row + filled, data, count);
+                filled += count;
+                data += count;
+                size -= count;
+                if (filled < rowBytes)
+                    break;
+
+                if (!UnfilterRow(filter, row, previous, rowBytes, _channels))
+                    return false;
+
+                if (!ConvertRow(row, dest + y * rowPitch))
+                    return false;
+                std::swap(row, previous);
+                filled = 0;
+                hasFilter = false;
+                ++y;
+            }
+
+            return true;
+        });
+
+        return success && y == _height;
+    }
+}
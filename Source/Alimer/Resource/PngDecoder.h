@@ -0,0 +1,74 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../AlimerConfig.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Alimer
+{
+    /// Streaming decoder of 8-bit non-interlaced PNG images. Image data is inflated and unfiltered a row at a time and written as RGBA8 straight to the destination, so decoding needs no memory beyond the file data, the destination and a 64 KB window.
+    class ALIMER_API PngDecoder
+    {
+    public:
+        /// Construct from PNG file data, which must stay valid until decoding has finished.
+        PngDecoder(const void* data, size_t size);
+
+        /// Parse the chunks. Return true if the file is a PNG the streaming decoder supports.
+        bool ReadHeader();
+
+        /// Decode RGBA8 rows to destination with given row pitch in bytes. ReadHeader must have succeeded. Return true on success.
+        bool Decode(uint8_t* dest, size_t rowPitch);
+
+        /// Return image width in pixels.
+        uint32_t GetWidth() const { return _width; }
+        /// Return image height in pixels.
+        uint32_t GetHeight() const { return _height; }
+
+        /// Return whether data starts with the PNG signature.
+        static bool IsPng(const void* data, size_t size);
+
+    private:
+        /// Convert an unfiltered row to RGBA8. Return false if a palette index is out of range.
+        bool ConvertRow(const uint8_t* source, uint8_t* dest) const;
+
+        const uint8_t* _data;
+        size_t _size;
+        uint32_t _width = 0;
+        uint32_t _height = 0;
+        uint32_t _colorType = 0;
+        uint32_t _channels = 0;
+        /// RGBA8 palette of indexed images.
+        uint8_t _palette[256][4] = {};
+        /// Number of palette entries.
+        uint32_t _paletteSize = 0;
+        /// Transparent color of gray and RGB images.
+        bool _hasColorKey = false;
+        uint8_t _colorKey[3] = {};
+        /// Compressed image data split over IDAT chunks.
+        std::vector<std::pair<const uint8_t*, size_t>> _imageData;
+    };
+}
@@ -64,11 +64,28 @@ namespace Alimer
 		/// Return name.
 		const String& GetName() const { return _name; }
 
+		/// Set the asynchronous loading state.
+		void SetAsyncLoadState(AsyncLoadState state) { _asyncLoadState = state; }
+
 		/// Return the asynchronous loading state.
 		AsyncLoadState GetAsyncLoadState() const { return _asyncLoadState; }
 
+		/// Set CPU memory use in bytes, used for resource cache budgets.
+		void SetMemoryUse(size_t size) { _memoryUse = size; }
+
+		/// Return CPU memory use in bytes, 0 if unknown.
+		size_t GetMemoryUse() const { return _memoryUse; }
+
+		/// Set GPU memory use in bytes, used for resource cache budgets.
+		void SetGpuMemoryUse(size_t size) { _gpuMemoryUse = size; }
+
+		/// Return GPU memory use in bytes.
+		size_t GetGpuMemoryUse() const { return _gpuMemoryUse; }
+
 	protected:
         String _name;
 		AsyncLoadState _asyncLoadState;
+		size_t _memoryUse = 0;
+		size_t _gpuMemoryUse = 0;
 	};
 }
@@ -33,6 +33,7 @@ namespace Alimer
     SharedPtr<Object> ResourceLoader::Load(Stream& source)
 	{
         _fileName = source.GetName();
+        _dependencies.clear();
         SharedPtr<Object> result = nullptr;
 		bool success = BeginLoad(source);
 		if (success)
@@ -40,4 +41,12 @@ namespace Alimer
 
 		return result;
 	}
+
+    void ResourceLoader::AddDependency(StringHash type, const String& name)
+    {
+        ResourceDependency dependency;
+        dependency.type = type;
+        dependency.name = name;
+        _dependencies.push_back(dependency);
+    }
 }
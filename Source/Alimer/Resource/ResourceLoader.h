@@ -25,11 +25,23 @@
 #include "../Resource/Resource.h"
 #include <memory>
 #include <atomic>
+#include <vector>
 
 namespace Alimer
 {
 	class Stream;
 
+    /// Resource needed to finish loading another resource.
+    struct ResourceDependency
+    {
+        /// Resource type.
+        StringHash type;
+        /// Resource name.
+        String name;
+        /// Loaded resource, available in EndLoad. Null if it failed to load.
+        SharedPtr<Object> object;
+    };
+
 	/// Runtime resource loader class.
 	class ResourceLoader
 	{
@@ -47,12 +59,31 @@ namespace Alimer
         /// Get the type being loaded.
         virtual StringHash GetType() const = 0;
 
+        /// Create a loader of the same type for loading concurrently with this one. Return null if not supported, asynchronous loads then run on the main thread.
+        virtual ResourceLoader* CreateInstance() const { return nullptr; }
+
 	protected:
+        friend class ResourceManager;
+
+		/// Parse the resource from a stream. Called on a worker thread for asynchronous loads.
 		virtual bool BeginLoad(Stream& source) = 0;
+		/// Finish loading and return instance. Called on the main thread.
 		virtual Object* EndLoad() = 0;
 
+        /// Declare a resource needed to finish loading, called from BeginLoad. Dependencies load in parallel and are available in EndLoad.
+        /// Dependencies handled by this loader itself require CreateInstance, and cyclic dependencies are left null.
+        void AddDependency(StringHash type, const String& name);
+
+        /// Return dependency object by index in declaration order, available in EndLoad.
+        template <class T> T* GetDependency(size_t index) const
+        {
+            return index < _dependencies.size() ? static_cast<T*>(_dependencies[index].object.Get()) : nullptr;
+        }
+
         /// File being loaded.
         String _fileName;
+        /// Dependencies declared by the current load.
+        std::vector<ResourceDependency> _dependencies;
 
 	private:
 		DISALLOW_COPY_MOVE_AND_ASSIGN(ResourceLoader);
@@ -24,24 +24,35 @@
 #include "../Application/Application.h"
 #include "../Graphics/ShaderCompiler.h"
 #include "../IO/FileSystem.h"
+#include "../IO/MemoryStream.h"
 #include "../IO/Path.h"
+#include "../Renderer/Mesh.h"
+#include "../Resource/CookedAsset.h"
+#include "../Resource/Image.h"
 #include "../Core/Log.h"
+#include <algorithm>
 
 namespace Alimer
 {
+    static const size_t NO_ASYNC_LOAD = static_cast<size_t>(-1);
+
     class ShaderLoader final : public ResourceLoader
     {
     public:
         void SetSource(ShaderStage stage, const String& source);
 
         StringHash GetType() const override;
+        ResourceLoader* CreateInstance() const override;
 
         bool BeginLoad(Stream& source) override;
         Object* EndLoad() override;
 
     private:
         String _shaderSources[static_cast<unsigned>(ShaderStage::Count)] = {};
-        ShaderDescriptor _descriptor;
+        /// Precompiled stages of a cooked shader.
+        CookedShader _cookedShader;
+        /// Whether loading a cooked shader.
+        bool _cooked = false;
     };
 
     void ShaderLoader::SetSource(ShaderStage stage, const String& source)
@@ -54,135 +65,342 @@ namespace Alimer
         return Shader::GetTypeStatic();
     }
 
-    bool ShaderLoader::BeginLoad(Stream& source)
+    ResourceLoader* ShaderLoader::CreateInstance() const
     {
-        size_t length = source.GetSize();
-        char *shaderText = new char[length + 1];
-        source.Read(shaderText, length);
-        shaderText[length] = '\0';
-
-        char* vertex = strstr(shaderText, "[vertex]");
-        char* fragment = strstr(shaderText, "[fragment]");
-
-        char* header = (shaderText[0] != '[') ? shaderText : nullptr;
-
-        uint32_t vs_line = 0;
-        uint32_t fs_line = 0;
+        return new ShaderLoader();
+    }
 
-        if (vertex != nullptr)
+    bool ShaderLoader::BeginLoad(Stream& source)
+    {
+        // Cooked shaders are used as compiled, source shaders are parsed in place and compiled in EndLoad.
+        CookedAssetReader reader(source);
+        _cooked = reader.IsCookedAsset(CookedAssetType::Shader);
+        if (_cooked)
         {
-            *vertex = '\0';
-            vertex += strlen("[vertex]");
-            while (*vertex == '\r' || *vertex == '\n') vertex++;
+            for (String& shaderSource : _shaderSources)
+                shaderSource.Clear();
 
-            char *str = shaderText;
-            while (str < vertex) {
-                if (*str == '\n') vs_line++;
-                str++;
+            if (!_cookedShader.Load(reader))
+            {
+                ALIMER_LOGERRORF("Invalid cooked shader '%s'", _fileName.CString());
+                return false;
             }
-        }
-        
-        if (fragment != nullptr)
-        {
-            *fragment = '\0';
-            fragment += strlen("[fragment]");
-            while (*fragment == '\r' || *fragment == '\n') fragment++;
 
-            char *str = shaderText;
-            while (str < fragment) {
-                if (*str == '\n') fs_line++;
-                str++;
-            }
-        }
-
-        if (vertex != nullptr)
-        {
-            String shaderString;
-            //if (extra != NULL) shaderString += extra;
-            if (header != NULL) shaderString += String(header);
-            shaderString += String::Format("#line %d\n", vs_line + 1);
-            shaderString += String(vertex);
-            SetSource(ShaderStage::Vertex, shaderString);
-        }
-
-        if (fragment != nullptr)
-        {
-            String shaderString;
-            //if (extra != NULL) shaderString += extra;
-            if (header != NULL) shaderString += String(header);
-            shaderString += String::Format("#line %d\n", fs_line + 1);
-            shaderString += String(fragment);
-            SetSource(ShaderStage::Fragment, shaderString);
+            return true;
         }
 
+        _cookedShader.Clear();
+        const StreamView& view = reader.GetView();
+        SplitShaderSections(reinterpret_cast<const char*>(view.data), view.size, _shaderSources);
         return true;
     }
 
     Object* ShaderLoader::EndLoad()
     {
+        ShaderDescriptor descriptor = {};
+        std::vector<ShaderBlob> compiledBlobs;
         for (unsigned i = 0; i < static_cast<unsigned>(ShaderStage::Count); i++)
         {
+            ShaderStage stage = static_cast<ShaderStage>(i);
+            if (_cooked)
+            {
+                descriptor.stages[i] = _cookedShader.GetStage(stage);
+                continue;
+            }
+
             if (_shaderSources[i].IsEmpty())
                 continue;
 
-            ShaderStage stage = static_cast<ShaderStage>(i);
             ShaderCompiler compiler;
-            _descriptor.stages[i] = compiler.Compile(
+            descriptor.stages[i] = compiler.Compile(
                 _shaderSources[i].CString(),
                 "main",
                 ShaderLanguage::GLSL,
                 stage, _fileName.CString());
+            compiledBlobs.push_back(descriptor.stages[i]);
         }
 
-        return Object::GetSubsystem<GraphicsDevice>()->CreateShader(&_descriptor);
+        Object* shader = Object::GetSubsystem<GraphicsDevice>()->CreateShader(&descriptor);
+
+        // The driver keeps the code of each stage, account it as GPU memory.
+        if (Shader* resource = shader ? shader->Cast<Shader>() : nullptr)
+        {
+            uint64_t codeSize = 0;
+            for (const ShaderBlob& blob : descriptor.stages)
+                codeSize += blob.size;
+            resource->SetGpuMemoryUse(static_cast<size_t>(codeSize));
+        }
+
+        for (ShaderBlob& blob : compiledBlobs)
+            delete[] blob.data;
+
+        return shader;
+    }
+
+    AsyncLoadRequest::AsyncLoadRequest(const String& name, StringHash type)
+        : _name(name)
+        , _type(type)
+        , _state(AsyncLoadState::Queued)
+    {
     }
 
     ResourceManager::ResourceManager()
     {
         AddLoader(new ShaderLoader());
+        AddLoader(new ImageLoader());
+        AddLoader(new MeshLoader());
+
+        _mounts.SetChangeCallback([this](const FileChange& change) {
+            OnResourceFileChanged(change);
+        });
     }
 
     ResourceManager::~ResourceManager()
     {
+        // Loads not finished are abandoned, but their loaders must not be destroyed while in use.
+        for (AsyncLoadItem& item : _asyncLoads)
+        {
+            if (item.task.valid())
+                item.task.wait();
+        }
+
+        // Let reads in flight complete, the watchers stop when the mounts are destroyed.
+        if (_reloadsInFlight)
+            FileSystem::Get().GetAsyncIO().WaitIdle();
     }
 
     bool ResourceManager::AddResourceDir(const String& path, uint32_t priority)
     {
         std::lock_guard<std::mutex> guard(_resourceMutex);
 
-        if (!FileSystem::DirectoryExists(path))
-        {
-            ALIMER_LOGERRORF("Directory '%s' does not exists", path.CString());
-            return false;
-        }
-
         // Convert path to absolute
         String fixedPath = SanitateResourceDirName(path);
 
         // Check that the same path does not already exist
-        for (size_t i = 0; i < _resourceDirs.size(); ++i)
+        if (_mounts.GetMount(fixedPath))
+            return true;
+
+        // Resource directories are kept together in the search order, before or after the packages.
+        size_t position = std::min(static_cast<size_t>(priority), _numResourceDirs);
+        if (_searchPackagesFirst)
+            position += _packages.size();
+
+        if (!_mounts.MountDirectory(fixedPath, static_cast<uint32_t>(position)))
+            return false;
+
+        ++_numResourceDirs;
+        ALIMER_LOGINFOF("Added resource path '%s'", fixedPath.CString());
+        return true;
+    }
+
+    bool ResourceManager::AddPackageFile(const String& fileName, uint32_t priority)
+    {
+        SharedPtr<PackageFile> package(new PackageFile());
+        return package->Open(fileName) && AddPackageFile(package.Get(), priority);
+    }
+
+    bool ResourceManager::AddPackageFile(PackageFile* package, uint32_t priority)
+    {
+        std::lock_guard<std::mutex> guard(_resourceMutex);
+
+        if (!package || !package->IsOpen())
         {
-            if (!_resourceDirs[i].Compare(fixedPath))
+            ALIMER_LOGERROR("Could not add package file which is not open");
+            return false;
+        }
+
+        // Do not add the same package twice
+        for (size_t i = 0; i < _packages.size(); ++i)
+        {
+            if (_packages[i].Get() == package)
                 return true;
         }
 
-        if (priority < _resourceDirs.size())
-            _resourceDirs.insert(_resourceDirs.begin() + priority, fixedPath);
-        else
-            _resourceDirs.push_back(fixedPath);
+        size_t position = std::min(static_cast<size_t>(priority), _packages.size());
+        size_t mountPosition = _searchPackagesFirst ? position : position + _numResourceDirs;
+        if (!_mounts.Mount(package->GetName(), new PackageFileSystemProtocol(package), static_cast<uint32_t>(mountPosition)))
+            return false;
 
-        // If resource auto-reloading active, create a file watcher for the directory
-       /* if (_autoReloadResources)
-        {
-            SharedPtr<FileWatcher> watcher(new FileWatcher(context_));
-            watcher->StartWatching(fixedPath, true);
-            fileWatchers_.Push(watcher);
-        }*/
+        _packages.insert(_packages.begin() + position, SharedPtr<PackageFile>(package));
 
-        ALIMER_LOGINFOF("Added resource path '%s'", fixedPath.CString());
+        ALIMER_LOGINFOF("Added resource package '%s' with %u entries", package->GetName().CString(), static_cast<uint32_t>(package->GetNumEntries()));
         return true;
     }
 
+    void ResourceManager::RemovePackageFile(const String& fileName)
+    {
+        std::lock_guard<std::mutex> guard(_resourceMutex);
+
+        for (auto it = _packages.begin(); it != _packages.end(); ++it)
+        {
+            if ((*it)->GetName() == fileName)
+            {
+                _mounts.Unmount(fileName);
+                _packages.erase(it);
+                return;
+            }
+        }
+    }
+
+    void ResourceManager::SetSearchPackagesFirst(bool value)
+    {
+        std::lock_guard<std::mutex> guard(_resourceMutex);
+        if (value == _searchPackagesFirst)
+            return;
+
+        // Move the packages to the front or the back of the search order, keeping their relative order.
+        for (size_t i = 0; i < _packages.size(); ++i)
+            _mounts.SetMountPriority(_packages[i]->GetName(), value ? static_cast<uint32_t>(i) : static_cast<uint32_t>(_numResourceDirs + _packages.size() - 1));
+
+        _searchPackagesFirst = value;
+    }
+
+    void ResourceManager::SetAutoReloadResources(bool enable)
+    {
+        std::lock_guard<std::mutex> guard(_reloadMutex);
+        _autoReloadResources = enable;
+        if (!enable)
+            _pendingReloads.clear();
+    }
+
+    void ResourceManager::SetReloadDelay(uint32_t milliseconds)
+    {
+        std::lock_guard<std::mutex> guard(_reloadMutex);
+        _reloadDelay = std::chrono::milliseconds(milliseconds);
+    }
+
+    uint32_t ResourceManager::GetReloadDelay() const
+    {
+        return static_cast<uint32_t>(_reloadDelay.count());
+    }
+
+    void ResourceManager::Update()
+    {
+        if (!_asyncLoads.empty())
+            UpdateAsyncLoads(false);
+
+        if (_hasPendingExternalMemoryUse.load(std::memory_order_acquire))
+            ApplyExternalMemoryUse();
+
+        if (_memoryReportInterval.count())
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now - _lastMemoryReport >= _memoryReportInterval)
+            {
+                _lastMemoryReport = now;
+                LogMemoryUsage();
+            }
+        }
+
+        // Nothing changed, the watcher threads sleep in the kernel meanwhile.
+        if (!_hasPendingReloads.load(std::memory_order_acquire))
+            return;
+
+        std::vector<String> dueNames;
+        std::vector<CompletedReload> completed;
+        {
+            std::lock_guard<std::mutex> guard(_reloadMutex);
+
+            // Reload only once the file has stopped changing, editors often write in several steps.
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = _pendingReloads.begin(); it != _pendingReloads.end();)
+            {
+                if (now - it->second >= _reloadDelay)
+                {
+                    dueNames.push_back(it->first);
+                    it = _pendingReloads.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            completed.swap(_completedReloads);
+            _hasPendingReloads = !_pendingReloads.empty();
+        }
+
+        // Read native files on the I/O threads, loading happens in a later update on this thread.
+        for (const String& name : dueNames)
+        {
+            String fileName = _mounts.GetFileSystemPath(name);
+            if (fileName.IsEmpty())
+            {
+                // Served from memory or a package, read right away.
+                UniquePtr<Stream> stream = _mounts.Open(name);
+                if (stream)
+                    completed.push_back({ name, stream->ReadBytes(), true });
+                continue;
+            }
+
+            ++_reloadsInFlight;
+            FileSystem::Get().ReadAsync(fileName, 0, 0, [this, name](AsyncReadResult& result) {
+                std::lock_guard<std::mutex> guard(_reloadMutex);
+                _completedReloads.push_back({ name, std::move(result.data), result.success });
+                _hasPendingReloads = true;
+                --_reloadsInFlight;
+            }, WorkPriority::Low);
+        }
+
+        for (CompletedReload& reload : completed)
+        {
+            if (reload.success)
+                ReloadResource(reload.name, reload.data);
+            else
+                ALIMER_LOGWARNF("Could not read changed resource '%s'", reload.name.CString());
+        }
+    }
+
+    void ResourceManager::OnResourceFileChanged(const FileChange& change)
+    {
+        if (change.directory || change.type == FileChangeType::Removed)
+            return;
+
+        std::lock_guard<std::mutex> guard(_reloadMutex);
+        if (!_autoReloadResources || _loadedResourceTypes.find(change.fileName) == _loadedResourceTypes.end())
+            return;
+
+        // Restart the delay on every change so that a burst of changes results in one reload.
+        _pendingReloads[change.fileName] = std::chrono::steady_clock::now();
+        _hasPendingReloads = true;
+    }
+
+    void ResourceManager::ReloadResource(const String& name, std::vector<uint8_t>& data)
+    {
+        StringHash type;
+        {
+            std::lock_guard<std::mutex> guard(_reloadMutex);
+            auto it = _loadedResourceTypes.find(name);
+            if (it == _loadedResourceTypes.end())
+                return;
+            type = it->second;
+        }
+
+        // Resources released from the cache are not reloaded.
+        CacheEntry* entry = FindResource(type, name);
+        if (!entry || !entry->object)
+        {
+            std::lock_guard<std::mutex> guard(_reloadMutex);
+            _loadedResourceTypes.erase(name);
+            return;
+        }
+
+        MemoryStream stream(data);
+        stream.SetName(name);
+        SharedPtr<Object> resource = LoadFromStream(type, name, stream);
+        if (!resource)
+        {
+            ALIMER_LOGERRORF("Failed to reload resource '%s'", name.CString());
+            return;
+        }
+
+        ALIMER_LOGINFOF("Reloaded resource '%s'", name.CString());
+        resourceReloaded.name = name;
+        resourceReloaded.resource = resource;
+        resourceReloaded.Send(resource.Get());
+        resourceReloaded.resource.Reset();
+    }
+
     void ResourceManager::AddLoader(ResourceLoader* loader)
     {
         ALIMER_ASSERT(loader);
@@ -197,160 +415,741 @@ namespace Alimer
 
     UniquePtr<Stream> ResourceManager::Open(const String &assetName)
     {
-        std::lock_guard<std::mutex> guard(_resourceMutex);
+        UniquePtr<Stream> stream = _mounts.Open(assetName);
+        if (stream)
+            return stream;
 
         String sanitatedName = SanitateResourceName(assetName);
+        if (sanitatedName.IsEmpty())
+            return {};
 
-        if (sanitatedName.Length())
+        // Fallback using absolute path
+        if (FileSystem::FileExists(sanitatedName))
+            return FileSystem::OpenFile(sanitatedName);
+
+        return FileSystem::Get().Open("assets://" + assetName);
+    }
+
+    bool ResourceManager::Exists(const String &assetName)
+    {
+        if (_mounts.Exists(assetName))
+            return true;
+
+        // Fallback using absolute path
+        String sanitatedName = SanitateResourceName(assetName);
+        return !sanitatedName.IsEmpty() && FileSystem::FileExists(sanitatedName);
+    }
+
+    SharedPtr<Object> ResourceManager::LoadObject(StringHash type, const String& assetName)
+    {
+        String sanitatedName = SanitateResourceName(assetName);
+        if (sanitatedName.IsEmpty())
+            return nullptr;
+
+        // Return the cached resource, or finish a background load of it right away.
+        if (CacheEntry* entry = FindResource(type, sanitatedName))
         {
-            UniquePtr<Stream> stream = {};
+            if (entry->object)
+            {
+                entry->lastUse = ++_useCounter;
+                return entry->object;
+            }
 
-            if (_searchPackagesFirst)
+            SharedPtr<AsyncLoadRequest> request = entry->request;
+            FinishAsyncLoad(request.Get(), true);
+            return request->_object;
+        }
+
+        auto stream = Open(sanitatedName);
+        if (!stream)
+        {
+            ALIMER_LOGERRORF("Could not find resource '%s'", assetName.CString());
+            return nullptr;
+        }
+
+        return LoadFromStream(type, sanitatedName, *stream);
+    }
+
+    SharedPtr<Object> ResourceManager::LoadFromStream(StringHash type, const String& sanitatedName, Stream& source)
+    {
+        ResourceLoader* loader = GetLoader(type);
+        if (!loader)
+        {
+            ALIMER_LOGERRORF("No loader for resource '%s'", sanitatedName.CString());
+            return nullptr;
+        }
+
+        // A dependency may be of the same type, load with an own instance when possible.
+        UniquePtr<ResourceLoader> instance(loader->CreateInstance());
+        if (instance)
+        {
+            loader = instance.Get();
+        }
+        else if (std::find(_sharedLoadersInUse.begin(), _sharedLoadersInUse.end(), loader) != _sharedLoadersInUse.end())
+        {
+            ALIMER_LOGERRORF("Loader for resource '%s' is in use by a dependent resource", sanitatedName.CString());
+            return nullptr;
+        }
+
+        loader->_fileName = source.GetName();
+        loader->_dependencies.clear();
+        if (!loader->BeginLoad(source))
+            return nullptr;
+
+        // Dependencies load one after another here, the asynchronous path loads them in parallel.
+        _loadStack.push_back(std::make_pair(type, sanitatedName));
+        if (!instance)
+            _sharedLoadersInUse.push_back(loader);
+
+        for (ResourceDependency& dependency : loader->_dependencies)
+        {
+            const String dependencyName = SanitateResourceName(dependency.name);
+            auto it = std::find(_loadStack.begin(), _loadStack.end(), std::make_pair(dependency.type, dependencyName));
+            if (it != _loadStack.end())
             {
-                stream = SearchPackages(sanitatedName);
-                if (!stream)
-                    stream = SearchResourceDirs(sanitatedName);
+                ALIMER_LOGERRORF("Cyclic dependency from resource '%s' to '%s'", sanitatedName.CString(), dependencyName.CString());
+                continue;
             }
-            else
+
+            dependency.object = LoadObject(dependency.type, dependencyName);
+        }
+        _loadStack.pop_back();
+        if (!instance)
+            _sharedLoadersInUse.pop_back();
+
+        if (_endLoadCallback)
+            _endLoadCallback();
+        SharedPtr<Object> resource(loader->EndLoad());
+        loader->_dependencies.clear();
+        if (resource)
+            StoreResource(type, sanitatedName, resource.Get(), source.GetSize());
+
+        return resource;
+    }
+
+    SharedPtr<AsyncLoadRequest> ResourceManager::LoadObjectAsync(StringHash type, const String& assetName, WorkPriority priority)
+    {
+        String sanitatedName = SanitateResourceName(assetName);
+
+        // Share a load in progress, or hand out the cached resource.
+        if (CacheEntry* entry = FindResource(type, sanitatedName))
+        {
+            if (entry->request)
+                return entry->request;
+
+            SharedPtr<AsyncLoadRequest> request(new AsyncLoadRequest(sanitatedName, type));
+            request->_object = entry->object;
+            request->_state = AsyncLoadState::Done;
+            entry->lastUse = ++_useCounter;
+            return request;
+        }
+
+        SharedPtr<AsyncLoadRequest> request(new AsyncLoadRequest(sanitatedName, type));
+
+        ResourceLoader* loader = GetLoader(type);
+        if (!loader || sanitatedName.IsEmpty())
+        {
+            ALIMER_LOGERRORF("No loader for resource '%s'", assetName.CString());
+            request->_state = AsyncLoadState::Fail;
+            return request;
+        }
+
+        AsyncLoadItem item;
+        item.request = request;
+        item.loader.Reset(loader->CreateInstance());
+        item.priority = priority;
+
+        // Parse on a worker thread when the loader can be instantiated, otherwise on the main thread in Update.
+        WorkQueue* workQueue = Object::GetSubsystem<WorkQueue>();
+        if (item.loader && workQueue)
+        {
+            AsyncLoadRequest* requestPtr = request.Get();
+            ResourceLoader* loaderPtr = item.loader.Get();
+            item.task = workQueue->Async([this, requestPtr, loaderPtr]() {
+                BeginAsyncLoad(requestPtr, loaderPtr);
+            }, priority);
+        }
+
+        _asyncLoads.push_back(std::move(item));
+
+        // Register the load in the cache so that further requests share it. On a name hash collision the load is not shared.
+        CacheEntry& entry = _resourceGroups[type].resources[StringHash(sanitatedName)];
+        if (entry.name.IsEmpty())
+        {
+            entry.name = sanitatedName;
+            entry.request = request;
+        }
+
+        return request;
+    }
+
+    void ResourceManager::SetAsyncLoadBudget(uint32_t milliseconds)
+    {
+        _asyncLoadBudget = std::chrono::milliseconds(milliseconds);
+    }
+
+    void ResourceManager::WaitForAsyncLoads()
+    {
+        while (!_asyncLoads.empty())
+            UpdateAsyncLoads(true);
+    }
+
+    SharedPtr<Object> ResourceManager::GetExistingObject(StringHash type, const String& assetName)
+    {
+        CacheEntry* entry = FindResource(type, SanitateResourceName(assetName));
+        return entry ? entry->object : nullptr;
+    }
+
+    void ResourceManager::ReleaseResource(StringHash type, const String& assetName, bool force)
+    {
+        auto groupIt = _resourceGroups.find(type);
+        if (groupIt == _resourceGroups.end())
+            return;
+
+        ResourceGroup& group = groupIt->second;
+        String sanitatedName = SanitateResourceName(assetName);
+        auto it = group.resources.find(StringHash(sanitatedName));
+        if (it == group.resources.end()
+            || it->second.name != sanitatedName
+            || !it->second.object
+            || (!force && it->second.object->Refs() > 1))
+        {
+            return;
+        }
+
+        EraseResource(group, it);
+    }
+
+    void ResourceManager::ReleaseResources(StringHash type, bool force)
+    {
+        auto it = _resourceGroups.find(type);
+        if (it != _resourceGroups.end())
+            ReleaseResources(it->second, force, 0);
+    }
+
+    void ResourceManager::ReleaseAllResources(bool force)
+    {
+        for (auto& group : _resourceGroups)
+            ReleaseResources(group.second, force, 0);
+    }
+
+    void ResourceManager::SetMemoryBudget(StringHash type, size_t budget)
+    {
+        ResourceGroup& group = _resourceGroups[type];
+        group.memoryBudget = budget;
+        if (budget && group.memoryUse > budget)
+            ReleaseResources(group, false, budget);
+    }
+
+    size_t ResourceManager::GetMemoryBudget(StringHash type) const
+    {
+        auto it = _resourceGroups.find(type);
+        return it != _resourceGroups.end() ? it->second.memoryBudget : 0;
+    }
+
+    size_t ResourceManager::GetMemoryUse(StringHash type) const
+    {
+        auto it = _resourceGroups.find(type);
+        return it != _resourceGroups.end() ? it->second.memoryUse : 0;
+    }
+
+    void ResourceManager::SetTotalMemoryBudget(size_t softBudget, size_t hardBudget)
+    {
+        _totalMemorySoftBudget = softBudget;
+        _totalMemoryHardBudget = hardBudget;
+        ApplyTotalMemoryBudget();
+    }
+
+    size_t ResourceManager::GetTotalMemoryUse() const
+    {
+        size_t total = 0;
+        for (const auto& group : _resourceGroups)
+            total += group.second.memoryUse;
+
+        return total;
+    }
+
+    void ResourceManager::SetExternalMemoryUse(StringHash type, const String& typeName, size_t cpuMemoryUse, size_t gpuMemoryUse)
+    {
+        std::lock_guard<std::mutex> guard(_externalMemoryMutex);
+        _pendingExternalMemoryUse[type] = { typeName, cpuMemoryUse, gpuMemoryUse };
+        _hasPendingExternalMemoryUse.store(true, std::memory_order_release);
+    }
+
+    std::vector<ResourceTypeMemoryInfo> ResourceManager::GetMemoryUsage() const
+    {
+        std::vector<ResourceTypeMemoryInfo> usage;
+        usage.reserve(_resourceGroups.size());
+        for (const auto& group : _resourceGroups)
+        {
+            ResourceTypeMemoryInfo info;
+            info.type = group.first;
+            info.typeName = group.second.typeName;
+            for (const auto& resource : group.second.resources)
             {
-                stream = SearchResourceDirs(sanitatedName);
-                if (!stream)
-                    stream = SearchPackages(sanitatedName);
+                if (resource.second.object)
+                    ++info.numResources;
             }
+            info.cpuMemoryUse = group.second.memoryUse - group.second.gpuMemoryUse;
+            info.gpuMemoryUse = group.second.gpuMemoryUse;
+            info.memoryBudget = group.second.memoryBudget;
+            usage.push_back(info);
+        }
 
-            if (!stream)
+        std::sort(usage.begin(), usage.end(), [](const ResourceTypeMemoryInfo& lhs, const ResourceTypeMemoryInfo& rhs) {
+            return lhs.cpuMemoryUse + lhs.gpuMemoryUse > rhs.cpuMemoryUse + rhs.gpuMemoryUse;
+        });
+        return usage;
+    }
+
+    std::vector<ResourceMemoryInfo> ResourceManager::GetLargestResources(size_t count) const
+    {
+        // Partial sort of (memory use, entry) pairs, the cache can hold many resources.
+        std::vector<std::pair<size_t, const CacheEntry*>> entries;
+        std::vector<StringHash> types;
+        for (const auto& group : _resourceGroups)
+        {
+            for (const auto& resource : group.second.resources)
             {
-                stream = FileSystem::Get().Open("assets://" + assetName);
+                if (resource.second.object)
+                {
+                    entries.push_back(std::make_pair(resource.second.memoryUse, &resource.second));
+                    types.push_back(group.first);
+                }
             }
+        }
 
-            return stream;
+        std::vector<size_t> order(entries.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+
+        count = std::min(count, order.size());
+        std::partial_sort(order.begin(), order.begin() + count, order.end(), [&entries](size_t lhs, size_t rhs) {
+            return entries[lhs].first > entries[rhs].first;
+        });
+
+        std::vector<ResourceMemoryInfo> largest(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const CacheEntry& entry = *entries[order[i]].second;
+            largest[i].type = types[order[i]];
+            largest[i].name = entry.name;
+            largest[i].cpuMemoryUse = entry.memoryUse - entry.gpuMemoryUse;
+            largest[i].gpuMemoryUse = entry.gpuMemoryUse;
         }
 
-        return {};
+        return largest;
     }
 
-    bool ResourceManager::Exists(const String &assetName)
+    /// Return a byte count in megabytes for logging.
+    static double ToMegabytes(size_t bytes)
     {
-        std::lock_guard<std::mutex> guard(_resourceMutex);
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
 
-        String sanitatedName = SanitateResourceName(assetName);
+    void ResourceManager::LogMemoryUsage(size_t numLargest) const
+    {
+        std::vector<ResourceTypeMemoryInfo> usage = GetMemoryUsage();
+        size_t cpuMemoryUse = 0;
+        size_t gpuMemoryUse = 0;
+        uint32_t numResources = 0;
+        for (const ResourceTypeMemoryInfo& info : usage)
+        {
+            cpuMemoryUse += info.cpuMemoryUse;
+            gpuMemoryUse += info.gpuMemoryUse;
+            numResources += info.numResources;
+        }
 
-        if (sanitatedName.Length())
+        ALIMER_LOGINFOF("Resource memory %.1f MB (CPU %.1f MB, GPU %.1f MB) in %u resources, budget %.1f MB soft, %.1f MB hard",
+            ToMegabytes(cpuMemoryUse + gpuMemoryUse), ToMegabytes(cpuMemoryUse), ToMegabytes(gpuMemoryUse), numResources,
+            ToMegabytes(_totalMemorySoftBudget), ToMegabytes(_totalMemoryHardBudget));
+
+        for (const ResourceTypeMemoryInfo& info : usage)
+        {
+            ALIMER_LOGINFOF("  %s: %u resources, CPU %.1f MB, GPU %.1f MB, budget %.1f MB",
+                info.typeName.IsEmpty() ? info.type.ToString().CString() : info.typeName.CString(), info.numResources,
+                ToMegabytes(info.cpuMemoryUse), ToMegabytes(info.gpuMemoryUse), ToMegabytes(info.memoryBudget));
+        }
+
+        for (const ResourceMemoryInfo& info : GetLargestResources(numLargest))
         {
-            bool exists = false;
-            if (_searchPackagesFirst)
+            ALIMER_LOGINFOF("  '%s': CPU %.1f MB, GPU %.1f MB",
+                info.name.CString(), ToMegabytes(info.cpuMemoryUse), ToMegabytes(info.gpuMemoryUse));
+        }
+    }
+
+    void ResourceManager::SetMemoryReportInterval(uint32_t milliseconds)
+    {
+        _memoryReportInterval = std::chrono::milliseconds(milliseconds);
+        _lastMemoryReport = std::chrono::steady_clock::now();
+    }
+
+    void ResourceManager::BeginAsyncLoad(AsyncLoadRequest* request, ResourceLoader* loader)
+    {
+        request->_state = AsyncLoadState::Loading;
+
+        bool success = false;
+        {
+            UniquePtr<Stream> stream = Open(request->_name);
+            if (stream)
             {
-                exists = ExistsInPackages(sanitatedName);
-                if (!exists)
-                    exists = ExistsInResourceDirs(sanitatedName);
+                request->_sourceSize = stream->GetSize();
+                loader->_fileName = stream->GetName();
+                success = loader->BeginLoad(*stream);
             }
             else
             {
-                exists = ExistsInResourceDirs(sanitatedName);
-                if (!exists)
-                    exists = ExistsInPackages(sanitatedName);
+                ALIMER_LOGERRORF("Could not find resource '%s'", request->_name.CString());
             }
-
-            return exists;
         }
 
-        return false;
+        request->_state = success ? AsyncLoadState::Success : AsyncLoadState::Fail;
     }
 
-    SharedPtr<Object> ResourceManager::LoadObject(StringHash type, const String& assetName)
+    void ResourceManager::UpdateAsyncLoads(bool waitAll)
     {
-        auto stream = Open(assetName);
-        auto loader = GetLoader(type);
-        return loader->Load(*stream);
+        const auto startTime = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < _asyncLoads.size();)
+        {
+            if (!FinishAsyncLoad(_asyncLoads[i].request.Get(), waitAll))
+            {
+                ++i;
+                continue;
+            }
+
+            if (!waitAll && std::chrono::steady_clock::now() - startTime >= _asyncLoadBudget)
+                break;
+        }
     }
 
-    String ResourceManager::SanitateResourceName(const String& name) const
+    bool ResourceManager::FinishAsyncLoad(AsyncLoadRequest* request, bool wait)
     {
-        // Sanitate unsupported constructs from the resource name
-        String sanitatedName = name.Replaced("../", "");
-        sanitatedName.Replace("./", "");
+        size_t index = FindAsyncLoad(request);
+        if (index == NO_ASYNC_LOAD)
+            return request->IsFinished();
 
-        // If the path refers to one of the resource directories, normalize the resource name
-        if (_resourceDirs.size())
+        ResourceLoader* loader;
+        WorkPriority priority;
+        bool sharedLoader;
         {
-            String namePath = FileSystem::GetPath(sanitatedName);
-            String exePath = FileSystem::GetExecutableFolder().Replaced("/./", "/");
-            for (size_t i = 0; i < _resourceDirs.size(); ++i)
+            AsyncLoadItem& item = _asyncLoads[index];
+            priority = item.priority;
+            sharedLoader = !item.loader;
+
+            // Loads not queued to a worker begin here, one at a time within the budget.
+            loader = item.loader ? item.loader.Get() : GetLoader(request->_type);
+            if (!item.task.valid() && request->_state == AsyncLoadState::Queued)
+            {
+                if (sharedLoader && std::find(_sharedLoadersInUse.begin(), _sharedLoadersInUse.end(), loader) != _sharedLoadersInUse.end())
+                {
+                    ALIMER_LOGERRORF("Loader for resource '%s' is in use by a dependent resource", request->_name.CString());
+                    request->_state = AsyncLoadState::Fail;
+                }
+                else
+                {
+                    BeginAsyncLoad(request, loader);
+                }
+            }
+            else if (wait && item.task.valid())
             {
-                String relativeResourcePath = _resourceDirs[i];
-                if (relativeResourcePath.StartsWith(exePath))
-                    relativeResourcePath = relativeResourcePath.Substring(exePath.Length());
-
-                if (namePath.StartsWith(_resourceDirs[i], false))
-                    namePath = namePath.Substring(_resourceDirs[i].Length());
-                else if (namePath.StartsWith(relativeResourcePath, false))
-                    namePath = namePath.Substring(relativeResourcePath.Length());
+                item.task.wait();
             }
 
-            sanitatedName = namePath + FileSystem::GetFileNameAndExtension(sanitatedName);
+            AsyncLoadState state = request->_state;
+            if (state != AsyncLoadState::Success && state != AsyncLoadState::Fail)
+                return false;
+
+            if (item.task.valid())
+                item.task.wait();
         }
 
-        return sanitatedName.Trimmed();
-    }
+        if (request->_state == AsyncLoadState::Success)
+        {
+            // Dependencies start loading in parallel once declared, the resource finishes after all of them.
+            if (!request->_dependenciesRequested)
+                RequestDependencies(request, loader, priority);
 
-    String ResourceManager::SanitateResourceDirName(const String& name) const
-    {
-        String cleanName = AddTrailingSlash(name);
-        if (!IsAbsolutePath(name))
-            cleanName = Path::Join(FileSystem::GetCurrentDirectory(), name);
+            // The shared loader holds the parsed data until EndLoad, so its dependencies are finished right away.
+            if (sharedLoader)
+                _sharedLoadersInUse.push_back(loader);
 
-        // Sanitate away /./ construct
-        cleanName = cleanName.Replaced("/./", "/").Trimmed();
-        return cleanName;
+            for (size_t i = 0; i < request->_dependencyRequests.size(); ++i)
+            {
+                AsyncLoadRequest* dependency = request->_dependencyRequests[i].Get();
+                if (!dependency || dependency->IsFinished())
+                    continue;
+
+                if (!wait && !sharedLoader)
+                    return false;
+
+                FinishAsyncLoad(dependency, true);
+            }
+
+            if (sharedLoader)
+                _sharedLoadersInUse.pop_back();
+
+            for (size_t i = 0; i < request->_dependencyRequests.size(); ++i)
+            {
+                AsyncLoadRequest* dependency = request->_dependencyRequests[i].Get();
+                loader->_dependencies[i].object = dependency ? dependency->_object : nullptr;
+            }
+
+            request->_dependencyRequests.clear();
+            if (_endLoadCallback)
+                _endLoadCallback();
+            request->_object = loader->EndLoad();
+            loader->_dependencies.clear();
+            if (request->_object)
+            {
+                StoreResource(request->_type, request->_name, request->_object.Get(), request->_sourceSize);
+                request->_state = AsyncLoadState::Done;
+            }
+            else
+            {
+                request->_state = AsyncLoadState::Fail;
+            }
+        }
+
+        if (request->_state == AsyncLoadState::Fail)
+        {
+            ALIMER_LOGERRORF("Failed to load resource '%s'", request->_name.CString());
+
+            // Forget the failed load, a later request tries again.
+            CacheEntry* entry = FindResource(request->_type, request->_name);
+            if (entry && entry->request.Get() == request)
+                _resourceGroups[request->_type].resources.erase(StringHash(request->_name));
+        }
+
+        // Finishing dependencies may have moved the load.
+        _asyncLoads.erase(_asyncLoads.begin() + FindAsyncLoad(request));
+        return true;
     }
 
-    UniquePtr<Stream> ResourceManager::SearchResourceDirs(const String& name)
+    void ResourceManager::RequestDependencies(AsyncLoadRequest* request, ResourceLoader* loader, WorkPriority priority)
     {
-        for (size_t i = 0; i < _resourceDirs.size(); ++i)
+        request->_dependenciesRequested = true;
+
+        // Loading a dependency may add loads, copy the declarations first.
+        std::vector<std::pair<StringHash, String>> dependencies;
+        for (const ResourceDependency& dependency : loader->_dependencies)
+            dependencies.push_back(std::make_pair(dependency.type, dependency.name));
+
+        for (const auto& dependency : dependencies)
         {
-            if (FileSystem::FileExists(_resourceDirs[i] + name))
+            SharedPtr<AsyncLoadRequest> dependencyRequest = LoadObjectAsync(dependency.first, dependency.second, priority);
+
+            // A load that would wait for itself never finishes, the loader gets a null dependency instead.
+            std::vector<const AsyncLoadRequest*> visited;
+            if (DependsOn(dependencyRequest.Get(), request, visited))
             {
-                return UniquePtr<Stream>(new FileStream(_resourceDirs[i] + name));
+                ALIMER_LOGERRORF("Cyclic dependency from resource '%s' to '%s'", request->_name.CString(), dependencyRequest->_name.CString());
+                dependencyRequest.Reset();
             }
+
+            request->_dependencyRequests.push_back(dependencyRequest);
         }
+    }
 
-        // Fallback using absolute path
-        if (FileSystem::FileExists(name))
+    bool ResourceManager::DependsOn(const AsyncLoadRequest* request, const AsyncLoadRequest* target, std::vector<const AsyncLoadRequest*>& visited) const
+    {
+        if (request == target)
+            return true;
+
+        if (std::find(visited.begin(), visited.end(), request) != visited.end())
+            return false;
+
+        visited.push_back(request);
+        for (const SharedPtr<AsyncLoadRequest>& dependency : request->_dependencyRequests)
         {
-            return UniquePtr<Stream>(new FileStream(name));
+            if (dependency && DependsOn(dependency.Get(), target, visited))
+                return true;
         }
 
-        return {};
+        return false;
     }
 
-    UniquePtr<Stream> ResourceManager::SearchPackages(const String& name)
+    size_t ResourceManager::FindAsyncLoad(const AsyncLoadRequest* request) const
     {
-        ALIMER_UNUSED(name);
-        // TODO:
-        return {};
+        for (size_t i = 0; i < _asyncLoads.size(); ++i)
+        {
+            if (_asyncLoads[i].request.Get() == request)
+                return i;
+        }
+
+        return NO_ASYNC_LOAD;
     }
 
-    bool ResourceManager::ExistsInResourceDirs(const String& name)
+    ResourceManager::CacheEntry* ResourceManager::FindResource(StringHash type, const String& sanitatedName)
     {
-        for (size_t i = 0; i < _resourceDirs.size(); ++i)
+        auto groupIt = _resourceGroups.find(type);
+        if (groupIt == _resourceGroups.end())
+            return nullptr;
+
+        auto it = groupIt->second.resources.find(StringHash(sanitatedName));
+        if (it == groupIt->second.resources.end() || it->second.name != sanitatedName)
+            return nullptr;
+
+        return &it->second;
+    }
+
+    void ResourceManager::StoreResource(StringHash type, const String& sanitatedName, Object* object, size_t sourceSize)
+    {
+        // Resources that do not report their memory use are accounted by their source size.
+        size_t memoryUse = sourceSize;
+        size_t gpuMemoryUse = 0;
+        if (Resource* resource = object->Cast<Resource>())
+        {
+            resource->SetName(sanitatedName);
+            resource->SetAsyncLoadState(AsyncLoadState::Done);
+            gpuMemoryUse = resource->GetGpuMemoryUse();
+            if (resource->GetMemoryUse() || gpuMemoryUse)
+                memoryUse = resource->GetMemoryUse() + gpuMemoryUse;
+        }
+
+        // On a name hash collision with another resource the new one is not cached.
+        ResourceGroup& group = _resourceGroups[type];
+        CacheEntry& entry = group.resources[StringHash(sanitatedName)];
+        if (entry.name.IsEmpty() || entry.name == sanitatedName)
         {
-            if (FileSystem::FileExists(_resourceDirs[i] + name))
+            if (group.typeName.IsEmpty())
+                group.typeName = String(object->GetTypeName().c_str());
+
+            group.memoryUse = group.memoryUse - entry.memoryUse + memoryUse;
+            group.gpuMemoryUse = group.gpuMemoryUse - entry.gpuMemoryUse + gpuMemoryUse;
+            entry.name = sanitatedName;
+            entry.object = object;
+            entry.request.Reset();
+            entry.memoryUse = memoryUse;
+            entry.gpuMemoryUse = gpuMemoryUse;
+            entry.lastUse = ++_useCounter;
+
+            if (group.memoryBudget && group.memoryUse > group.memoryBudget)
+                ReleaseResources(group, false, group.memoryBudget);
+
+            ApplyTotalMemoryBudget();
+        }
+
+        // Remember the type so that the resource can be reloaded when its file changes.
+        std::lock_guard<std::mutex> guard(_reloadMutex);
+        _loadedResourceTypes[sanitatedName] = type;
+    }
+
+    void ResourceManager::ReleaseResources(ResourceGroup& group, bool force, size_t targetMemoryUse)
+    {
+        // Release least recently used first. Resources referenced only by the cache are unused.
+        std::vector<std::pair<uint64_t, StringHash>> candidates;
+        for (const auto& resource : group.resources)
+        {
+            const CacheEntry& entry = resource.second;
+            if (entry.object && (force || entry.object->Refs() == 1))
+                candidates.push_back(std::make_pair(entry.lastUse, resource.first));
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        for (const auto& candidate : candidates)
+        {
+            if (targetMemoryUse && group.memoryUse <= targetMemoryUse)
+                break;
+
+            EraseResource(group, group.resources.find(candidate.second));
+        }
+    }
+
+    void ResourceManager::EraseResource(ResourceGroup& group, std::unordered_map<StringHash, CacheEntry>::iterator it)
+    {
+        group.memoryUse -= it->second.memoryUse;
+        group.gpuMemoryUse -= it->second.gpuMemoryUse;
+        group.resources.erase(it);
+    }
+
+    void ResourceManager::ApplyExternalMemoryUse()
+    {
+        std::unordered_map<StringHash, ExternalMemoryUse> pending;
+        {
+            std::lock_guard<std::mutex> guard(_externalMemoryMutex);
+            pending.swap(_pendingExternalMemoryUse);
+            _hasPendingExternalMemoryUse.store(false, std::memory_order_relaxed);
+        }
+
+        for (const auto& use : pending)
+        {
+            ResourceGroup& group = _resourceGroups[use.first];
+            if (group.typeName.IsEmpty())
+                group.typeName = use.second.typeName;
+
+            const size_t memoryUse = use.second.cpuMemoryUse + use.second.gpuMemoryUse;
+            group.memoryUse = group.memoryUse - group.externalMemoryUse + memoryUse;
+            group.gpuMemoryUse = group.gpuMemoryUse - group.externalGpuMemoryUse + use.second.gpuMemoryUse;
+            group.externalMemoryUse = memoryUse;
+            group.externalGpuMemoryUse = use.second.gpuMemoryUse;
+
+            if (group.memoryBudget && group.memoryUse > group.memoryBudget)
+                ReleaseResources(group, false, group.memoryBudget);
+        }
+
+        ApplyTotalMemoryBudget();
+    }
+
+    void ResourceManager::ApplyTotalMemoryBudget()
+    {
+        size_t totalMemoryUse = GetTotalMemoryUse();
+        if (_totalMemorySoftBudget && totalMemoryUse > _totalMemorySoftBudget)
+        {
+            // Release least recently used first across all types, like the per-type budgets do.
+            std::vector<std::pair<uint64_t, std::pair<StringHash, StringHash>>> candidates;
+            for (const auto& group : _resourceGroups)
             {
-                return true;
+                for (const auto& resource : group.second.resources)
+                {
+                    const CacheEntry& entry = resource.second;
+                    if (entry.object && entry.object->Refs() == 1)
+                        candidates.push_back(std::make_pair(entry.lastUse, std::make_pair(group.first, resource.first)));
+                }
+            }
+
+            std::sort(candidates.begin(), candidates.end());
+            for (const auto& candidate : candidates)
+            {
+                if (totalMemoryUse <= _totalMemorySoftBudget)
+                    break;
+
+                ResourceGroup& group = _resourceGroups[candidate.second.first];
+                auto it = group.resources.find(candidate.second.second);
+                totalMemoryUse -= it->second.memoryUse;
+                EraseResource(group, it);
             }
         }
 
-        // Fallback using absolute path
-        if (FileSystem::FileExists(name))
-            return true;
+        // Report the hard budget once per overrun, so that the log shows what was resident when memory ran out.
+        const bool exceeded = _totalMemoryHardBudget && totalMemoryUse > _totalMemoryHardBudget;
+        const bool newlyExceeded = exceeded && !_hardMemoryBudgetExceeded;
+        _hardMemoryBudgetExceeded = exceeded;
+        if (!newlyExceeded)
+            return;
 
-        return false;
+        ALIMER_LOGERRORF("Resource memory %.1f MB exceeds the hard budget of %.1f MB",
+            ToMegabytes(totalMemoryUse), ToMegabytes(_totalMemoryHardBudget));
+        LogMemoryUsage();
+
+        memoryBudgetExceeded.memoryUse = totalMemoryUse;
+        memoryBudgetExceeded.budget = _totalMemoryHardBudget;
+        memoryBudgetExceeded.Send(nullptr);
     }
 
-    bool ResourceManager::ExistsInPackages(const String& name)
+    String ResourceManager::SanitateResourceName(const String& name) const
     {
-        ALIMER_UNUSED(name);
-        // TODO:
-        return false;
+        return _mounts.SanitateName(name);
+    }
+
+    String ResourceManager::SanitateResourceDirName(const String& name) const
+    {
+        String cleanName = AddTrailingSlash(name);
+        if (!IsAbsolutePath(name))
+            cleanName = AddTrailingSlash(Path::Join(FileSystem::GetCurrentDirectory(), name));
+
+        // Sanitate away /./ construct
+        cleanName = cleanName.Replaced("/./", "/").Trimmed();
+        return cleanName;
     }
 }
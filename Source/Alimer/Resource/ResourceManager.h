@@ -24,15 +24,112 @@
 
 #include "../IO/FileSystem.h"
 #include "../Resource/ResourceLoader.h"
+#include "../Resource/PackageFile.h"
+#include "../IO/VirtualFileSystem.h"
+#include "../Core/Event.h"
+#include "../Core/WorkQueue.h"
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <functional>
 
 namespace Alimer
 {
-    /// Sets to priority so that a package or file is pushed to the end of the vector.
-    static constexpr uint32_t PRIORITY_LAST = 0xffffffff;
+    /// Resource reloaded after its file changed. Sent with the new resource as sender.
+    class ALIMER_API ResourceReloadedEvent : public Event
+    {
+    public:
+        /// Resource name.
+        String name;
+        /// New resource instance.
+        SharedPtr<Object> resource;
+    };
+
+    /// Total memory use of cached resources exceeded the hard budget even after releasing the unused ones. Sent without a sender when the budget becomes exceeded, so that the owners of resources can drop references.
+    class ALIMER_API MemoryBudgetExceededEvent : public Event
+    {
+    public:
+        /// Memory use of all cached resources in bytes.
+        size_t memoryUse = 0;
+        /// Hard memory budget in bytes.
+        size_t budget = 0;
+    };
+
+    /// Memory use of a cached resource.
+    struct ALIMER_API ResourceMemoryInfo
+    {
+        /// Resource type.
+        StringHash type;
+        /// Resource name.
+        String name;
+        /// CPU memory use in bytes.
+        size_t cpuMemoryUse = 0;
+        /// GPU memory use in bytes.
+        size_t gpuMemoryUse = 0;
+    };
+
+    /// Memory use and budget of cached resources of one type.
+    struct ALIMER_API ResourceTypeMemoryInfo
+    {
+        /// Resource type.
+        StringHash type;
+        /// Resource type name, empty if no resource of the type has been cached.
+        String typeName;
+        /// Number of cached resources.
+        uint32_t numResources = 0;
+        /// CPU memory use in bytes.
+        size_t cpuMemoryUse = 0;
+        /// GPU memory use in bytes.
+        size_t gpuMemoryUse = 0;
+        /// Memory budget in bytes, 0 for unlimited.
+        size_t memoryBudget = 0;
+    };
+
+    /// Handle to a resource loading in the background, returned by ResourceManager::LoadAsync.
+    class ALIMER_API AsyncLoadRequest : public RefCounted
+    {
+        friend class ResourceManager;
+
+    public:
+        /// Constructor.
+        AsyncLoadRequest(const String& name, StringHash type);
+
+        /// Return resource name.
+        const String& GetName() const { return _name; }
+
+        /// Return resource type.
+        StringHash GetType() const { return _type; }
+
+        /// Return loading state, Done once finished on the main thread or Fail if loading failed.
+        AsyncLoadState GetState() const { return _state; }
+
+        /// Return whether loading has finished, successfully or not.
+        bool IsFinished() const { return _state == AsyncLoadState::Done || _state == AsyncLoadState::Fail; }
+
+        /// Return loaded object, null until done.
+        Object* GetResult() const { return _object.Get(); }
+
+        /// Return loaded resource, null until done.
+        template <class T> SharedPtr<T> GetResource() const { return StaticCast<T>(_object); }
+
+    private:
+        /// Resource name.
+        String _name;
+        /// Resource type.
+        StringHash _type;
+        /// Loading state, written by the worker thread until BeginLoad completes.
+        std::atomic<AsyncLoadState> _state;
+        /// Loaded object.
+        SharedPtr<Object> _object;
+        /// Size of the source stream in bytes.
+        size_t _sourceSize = 0;
+        /// Loads of the dependencies declared in BeginLoad, null for cyclic ones.
+        std::vector<SharedPtr<AsyncLoadRequest>> _dependencyRequests;
+        /// Whether the dependency loads have been requested.
+        bool _dependenciesRequested = false;
+    };
 
 	/// Resource cache subsystem. Loads resources on demand and stores them for later access.
 	class ALIMER_API ResourceManager final
@@ -47,6 +144,42 @@ namespace Alimer
         /// Add a resource load directory. Optional priority parameter which will control search order.
         bool AddResourceDir(const String& assetName, uint32_t priority = PRIORITY_LAST);
 
+        /// Add a package file for loading resources from. Optional priority parameter which will control search order.
+        bool AddPackageFile(const String& fileName, uint32_t priority = PRIORITY_LAST);
+
+        /// Add an opened package file for loading resources from. Optional priority parameter which will control search order.
+        bool AddPackageFile(PackageFile* package, uint32_t priority = PRIORITY_LAST);
+
+        /// Remove a package file by name.
+        void RemovePackageFile(const String& fileName);
+
+        /// Set whether packages are searched before resource directories.
+        void SetSearchPackagesFirst(bool value);
+
+        /// Return whether packages are searched before resource directories.
+        bool GetSearchPackagesFirst() const { return _searchPackagesFirst; }
+
+        /// Return added package files.
+        const std::vector<SharedPtr<PackageFile>>& GetPackageFiles() const { return _packages; }
+
+        /// Return the virtual file system holding resource directories and packages, to mount other sources such as memory files.
+        VirtualFileSystem& GetVirtualFileSystem() { return _mounts; }
+
+        /// Enable or disable reloading of loaded resources when their file changes in a resource directory.
+        void SetAutoReloadResources(bool enable);
+
+        /// Return whether resources are reloaded when their file changes.
+        bool GetAutoReloadResources() const { return _autoReloadResources; }
+
+        /// Set time in milliseconds a changed file must stay unmodified before it is reloaded, so that bursts of changes reload once.
+        void SetReloadDelay(uint32_t milliseconds);
+
+        /// Return reload delay in milliseconds.
+        uint32_t GetReloadDelay() const;
+
+        /// Issue reads of changed resources and reload the ones that completed. Call once per frame from the main thread.
+        void Update();
+
         void AddLoader(ResourceLoader* loader);
         ResourceLoader* GetLoader(StringHash type) const;
 
@@ -60,36 +193,272 @@ namespace Alimer
 			return StaticCast<T>(LoadObject(T::GetTypeStatic(), assetName));
 		}
 
+        /// Load a resource in the background and return a handle immediately. BeginLoad runs on a worker thread and EndLoad in Update.
+        SharedPtr<AsyncLoadRequest> LoadObjectAsync(StringHash type, const String& assetName, WorkPriority priority = WorkPriority::Normal);
+
+        /// Load a resource in the background and return a handle immediately, template version.
+        template <class T> SharedPtr<AsyncLoadRequest> LoadAsync(const String& assetName, WorkPriority priority = WorkPriority::Normal)
+        {
+            return LoadObjectAsync(T::GetTypeStatic(), assetName, priority);
+        }
+
+        /// Set time in milliseconds Update may spend finishing asynchronous loads. At least one load is finished per update.
+        void SetAsyncLoadBudget(uint32_t milliseconds);
+
+        /// Return time in milliseconds Update may spend finishing asynchronous loads.
+        uint32_t GetAsyncLoadBudget() const { return static_cast<uint32_t>(_asyncLoadBudget.count()); }
+
+        /// Set function called on the main thread before a loader finishes a resource, for example to wait until another thread no longer uses the objects that EndLoad creates or replaces.
+        void SetEndLoadCallback(std::function<void()> callback) { _endLoadCallback = std::move(callback); }
+
+        /// Return number of asynchronous loads not yet finished.
+        size_t GetNumAsyncLoads() const { return _asyncLoads.size(); }
+
+        /// Block until all asynchronous loads have finished.
+        void WaitForAsyncLoads();
+
+        /// Return a cached resource, or null if not loaded.
+        SharedPtr<Object> GetExistingObject(StringHash type, const String& assetName);
+
+        /// Return a cached resource, or null if not loaded, template version.
+        template <class T> SharedPtr<T> GetExisting(const String& assetName)
+        {
+            return StaticCast<T>(GetExistingObject(T::GetTypeStatic(), assetName));
+        }
+
+        /// Release a resource from the cache. Unless forced, only if it is not referenced elsewhere.
+        void ReleaseResource(StringHash type, const String& assetName, bool force = false);
+
+        /// Release resources of a type from the cache. Unless forced, only those not referenced elsewhere.
+        void ReleaseResources(StringHash type, bool force = false);
+
+        /// Release all resources from the cache. Unless forced, only those not referenced elsewhere.
+        void ReleaseAllResources(bool force = false);
+
+        /// Set memory budget in bytes for a resource type, 0 for unlimited. Unused resources of the type are released, least recently used first, to stay within the budget.
+        void SetMemoryBudget(StringHash type, size_t budget);
+
+        /// Return memory budget of a resource type.
+        size_t GetMemoryBudget(StringHash type) const;
+
+        /// Set soft and hard memory budgets in bytes for all cached resources, 0 for unlimited. Unused resources of any type are released, least recently used first, to stay within the soft budget. Exceeding the hard budget logs the largest resources and sends memoryBudgetExceeded, once until memory use drops back within the budget.
+        void SetTotalMemoryBudget(size_t softBudget, size_t hardBudget);
+
+        /// Return soft memory budget of all cached resources.
+        size_t GetTotalMemorySoftBudget() const { return _totalMemorySoftBudget; }
+
+        /// Return hard memory budget of all cached resources.
+        size_t GetTotalMemoryHardBudget() const { return _totalMemoryHardBudget; }
+
+        /// Return CPU and GPU memory use of cached resources of a type.
+        size_t GetMemoryUse(StringHash type) const;
+
+        /// Return CPU and GPU memory use of all cached resources.
+        size_t GetTotalMemoryUse() const;
+
+        /// Set memory use in bytes of resources of a type held outside the cache, such as streamed textures. It counts towards the budgets, though only cached resources are released to meet them. May be called from any thread, applied on the next Update.
+        void SetExternalMemoryUse(StringHash type, const String& typeName, size_t cpuMemoryUse, size_t gpuMemoryUse);
+
+        /// Return memory use and budget of each resource type, largest first.
+        std::vector<ResourceTypeMemoryInfo> GetMemoryUsage() const;
+
+        /// Return memory use of the largest cached resources, largest first.
+        std::vector<ResourceMemoryInfo> GetLargestResources(size_t count) const;
+
+        /// Log memory use of each resource type and of the largest cached resources.
+        void LogMemoryUsage(size_t numLargest = 10) const;
+
+        /// Set interval in milliseconds at which Update logs memory use, 0 to disable.
+        void SetMemoryReportInterval(uint32_t milliseconds);
+
+        /// Return interval in milliseconds at which Update logs memory use.
+        uint32_t GetMemoryReportInterval() const { return static_cast<uint32_t>(_memoryReportInterval.count()); }
+
         /// Remove unsupported constructs from the resource name to prevent ambiguity, and normalize absolute filename to resource path relative if possible.
         String SanitateResourceName(const String& name) const;
 
         /// Remove unnecessary constructs from a resource directory name and ensure it to be an absolute path.
         String SanitateResourceDirName(const String& name) const;
 
+        /// Resource reloaded event.
+        ResourceReloadedEvent resourceReloaded;
+
+        /// Memory budget exceeded event.
+        MemoryBudgetExceededEvent memoryBudgetExceeded;
+
 	private:
-        /// Search FileSystem for file.
-        UniquePtr<Stream> SearchResourceDirs(const String& name);
-        /// Search resource packages for file.
-        UniquePtr<Stream> SearchPackages(const String& name);
+        /// Asynchronous load in progress.
+        struct AsyncLoadItem
+        {
+            /// Request handle.
+            SharedPtr<AsyncLoadRequest> request;
+            /// Loader instance owned by this load, null when loading on the main thread.
+            UniquePtr<ResourceLoader> loader;
+            /// BeginLoad task on the work queue.
+            std::future<void> task;
+            /// Priority, also used for the dependency loads.
+            WorkPriority priority;
+        };
+
+        /// Cached resource.
+        struct CacheEntry
+        {
+            /// Sanitated resource name.
+            String name;
+            /// Resource, null while loading in the background.
+            SharedPtr<Object> object;
+            /// Background load in progress, shared by further requests.
+            SharedPtr<AsyncLoadRequest> request;
+            /// CPU and GPU memory use in bytes.
+            size_t memoryUse = 0;
+            /// GPU part of the memory use in bytes.
+            size_t gpuMemoryUse = 0;
+            /// Use counter value at the last request.
+            uint64_t lastUse = 0;
+        };
+
+        /// Cached resources of one type.
+        struct ResourceGroup
+        {
+            /// Memory budget in bytes, 0 for unlimited.
+            size_t memoryBudget = 0;
+            /// CPU and GPU memory use of the cached resources.
+            size_t memoryUse = 0;
+            /// GPU part of the memory use.
+            size_t gpuMemoryUse = 0;
+            /// Memory use of resources held outside the cache, included in memoryUse.
+            size_t externalMemoryUse = 0;
+            /// GPU part of the external memory use, included in gpuMemoryUse.
+            size_t externalGpuMemoryUse = 0;
+            /// Type name, taken from the first cached resource.
+            String typeName;
+            /// Resources by name hash.
+            std::unordered_map<StringHash, CacheEntry> resources;
+        };
+
+        /// Return cache entry or null if not cached.
+        CacheEntry* FindResource(StringHash type, const String& sanitatedName);
+        /// Add or replace a resource in the cache and account its memory use.
+        void StoreResource(StringHash type, const String& sanitatedName, Object* object, size_t sourceSize);
+        /// Release resources of a group, least recently used first, until its memory use is within the target. Zero target releases all candidates.
+        void ReleaseResources(ResourceGroup& group, bool force, size_t targetMemoryUse);
+        /// Remove a resource from the cache and its memory use from the group.
+        void EraseResource(ResourceGroup& group, std::unordered_map<StringHash, CacheEntry>::iterator it);
+        /// Release unused resources of all types, least recently used first, to stay within the total memory budgets. Report when the hard budget is exceeded.
+        void ApplyTotalMemoryBudget();
+        /// Account memory use reported by SetExternalMemoryUse and apply the budgets.
+        void ApplyExternalMemoryUse();
+
+        /// Open the resource and call BeginLoad, on a worker thread or the main thread.
+        void BeginAsyncLoad(AsyncLoadRequest* request, ResourceLoader* loader);
+        /// Finish asynchronous loads within the time budget, or all of them.
+        void UpdateAsyncLoads(bool waitAll);
+        /// Finish an asynchronous load if its BeginLoad and dependencies have completed, optionally waiting for them. Return true if finished.
+        bool FinishAsyncLoad(AsyncLoadRequest* request, bool wait);
+        /// Request loading the dependencies declared by a load, dropping cyclic ones.
+        void RequestDependencies(AsyncLoadRequest* request, ResourceLoader* loader, WorkPriority priority);
+        /// Return whether a load waits for another through its dependencies.
+        bool DependsOn(const AsyncLoadRequest* request, const AsyncLoadRequest* target, std::vector<const AsyncLoadRequest*>& visited) const;
+        /// Return index of an asynchronous load, or NO_ASYNC_LOAD if not in progress.
+        size_t FindAsyncLoad(const AsyncLoadRequest* request) const;
+        /// Load a resource and its dependencies from a stream and store it in the cache.
+        SharedPtr<Object> LoadFromStream(StringHash type, const String& sanitatedName, Stream& source);
 
-        /// Search FileSystem for file.
-        bool ExistsInResourceDirs(const String& name);
+        /// Handle a file change in a mount, called on the watcher thread.
+        void OnResourceFileChanged(const FileChange& change);
 
-        /// Search resource packages for file.
-        bool ExistsInPackages(const String& name);
+        /// Reload a resource from data read from its changed file.
+        void ReloadResource(const String& name, std::vector<uint8_t>& data);
 
-        /// Mutex for thread-safe access to the resource directories, resource packages and resource dependencies.
+        /// Changed resource read from file.
+        struct CompletedReload
+        {
+            /// Resource name.
+            String name;
+            /// File contents.
+            std::vector<uint8_t> data;
+            /// Whether the file could be read.
+            bool success;
+        };
+
+        /// Mutex for adding and removing resource directories and packages.
         mutable std::mutex _resourceMutex;
 
-        /// Resource load directories.
-        std::vector<String> _resourceDirs;
+        /// Package files.
+        std::vector<SharedPtr<PackageFile>> _packages;
+
+        /// Number of resource directories.
+        size_t _numResourceDirs{ 0 };
 
         std::unordered_map<StringHash, UniquePtr<ResourceLoader>> _loaders;
-		std::map<String, SharedPtr<Resource>> _resources;
+
+        /// Cached resources by type, accessed from the main thread.
+        std::unordered_map<StringHash, ResourceGroup> _resourceGroups;
+        /// Counter for least recently used ordering.
+        uint64_t _useCounter{ 0 };
+        /// Soft memory budget of all cached resources, 0 for unlimited.
+        size_t _totalMemorySoftBudget{ 0 };
+        /// Hard memory budget of all cached resources, 0 for unlimited.
+        size_t _totalMemoryHardBudget{ 0 };
+        /// Whether the hard memory budget was exceeded at the last check, to report only when first exceeded.
+        bool _hardMemoryBudgetExceeded{ false };
+        /// Interval of memory use logging, 0 to disable.
+        std::chrono::milliseconds _memoryReportInterval{ 0 };
+        /// Time of the last memory use logging.
+        std::chrono::steady_clock::time_point _lastMemoryReport;
+
+        /// Memory use of resources held outside the cache.
+        struct ExternalMemoryUse
+        {
+            /// Resource type name.
+            String typeName;
+            /// CPU memory use in bytes.
+            size_t cpuMemoryUse;
+            /// GPU memory use in bytes.
+            size_t gpuMemoryUse;
+        };
+
+        /// External memory use reported since the last Update.
+        std::unordered_map<StringHash, ExternalMemoryUse> _pendingExternalMemoryUse;
+        /// Set when there is external memory use for Update to account.
+        std::atomic<bool> _hasPendingExternalMemoryUse{ false };
+        /// Mutex for the reported external memory use.
+        std::mutex _externalMemoryMutex;
 
         /// Search priority flag.
         bool _searchPackagesFirst{ true };
 
+        /// Asynchronous loads in progress, accessed from the main thread.
+        std::vector<AsyncLoadItem> _asyncLoads;
+        /// Time Update may spend finishing asynchronous loads.
+        std::chrono::milliseconds _asyncLoadBudget{ 5 };
+        /// Resources being loaded synchronously, outermost first, to detect cyclic dependencies.
+        std::vector<std::pair<StringHash, String>> _loadStack;
+        /// Shared loaders between BeginLoad and EndLoad while their dependencies load.
+        std::vector<ResourceLoader*> _sharedLoadersInUse;
+        /// Called before each EndLoad.
+        std::function<void()> _endLoadCallback;
+
+        /// Resource auto-reload flag.
+        std::atomic<bool> _autoReloadResources{ false };
+        /// Set when there are pending or completed reloads for Update to process.
+        std::atomic<bool> _hasPendingReloads{ false };
+        /// Number of reload reads in flight.
+        std::atomic<uint32_t> _reloadsInFlight{ 0 };
+        /// Mutex for the reload state and loaded resource types.
+        std::mutex _reloadMutex;
+        /// Time a changed file must stay unmodified before it is reloaded.
+        std::chrono::milliseconds _reloadDelay{ 100 };
+        /// Type of each loaded resource by name.
+        std::unordered_map<String, StringHash> _loadedResourceTypes;
+        /// Time of the last change of changed resources by name.
+        std::unordered_map<String, std::chrono::steady_clock::time_point> _pendingReloads;
+        /// Reads completed since the last update.
+        std::vector<CompletedReload> _completedReloads;
+
+        /// Resource directories followed by packages, or the reverse when packages are searched first. Declared last so that watchers stop before the reload state is destroyed.
+        VirtualFileSystem _mounts;
+
     private:
 		DISALLOW_COPY_MOVE_AND_ASSIGN(ResourceManager);
 	};
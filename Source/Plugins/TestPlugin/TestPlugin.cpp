@@ -43,4 +43,9 @@ extern "C" ALIMER_INTERFACE_EXPORT void AlimerPluginUnload(Alimer::Plugin* plugi
 {
     delete static_cast<TestPlugin*>(plugin);
 }
+
+extern "C" ALIMER_INTERFACE_EXPORT uint32_t AlimerPluginApiVersion()
+{
+    return ALIMER_PLUGIN_API_VERSION;
+}
 #endif
@@ -0,0 +1,849 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4458) 
+#endif
+
+#include "CLI11.hpp"
+#include "Alimer/Base/HashMap.h"
+#include "Alimer/Core/Log.h"
+#include "Alimer/Core/WorkQueue.h"
+#include "Alimer/Graphics/ShaderCompiler.h"
+#include "Alimer/IO/FileSystem.h"
+#include "Alimer/IO/FileStream.h"
+#include "Alimer/IO/PagedMemoryStream.h"
+#include "Alimer/IO/Path.h"
+#include "Alimer/Renderer/Mesh.h"
+#include "Alimer/Resource/CookedAsset.h"
+#include "Alimer/Resource/DerivedDataCache.h"
+#include "Alimer/Resource/Image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+using namespace Alimer;
+using namespace std;
+
+/// Version of the cooking rules. Part of every content hash, so that changed rules cook everything again.
+static constexpr uint32_t COOK_VERSION = 1;
+/// Name of the file in the output directory holding the content hash of each cooked file.
+static const char* MANIFEST_FILE_NAME = ".cookmanifest";
+
+enum class AssetKind : uint32_t
+{
+    Copy,
+    Shader,
+    Image,
+    Mesh
+};
+
+static AssetKind GetAssetKind(const String& extension)
+{
+    if (extension == ".shader")
+        return AssetKind::Shader;
+    if (extension == ".png" || extension == ".bmp" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga")
+        return AssetKind::Image;
+    if (extension == ".obj")
+        return AssetKind::Mesh;
+
+    return AssetKind::Copy;
+}
+
+static bool ReadFile(const String& fileName, std::vector<uint8_t>& data)
+{
+    UniquePtr<Stream> stream = FileSystem::OpenFile(fileName);
+    if (!stream || !stream->CanRead())
+        return false;
+
+    data = stream->ReadBytes();
+    return data.size() == stream->GetSize();
+}
+
+static bool CreateDirectories(const String& path)
+{
+    if (path.IsEmpty() || FileSystem::DirectoryExists(path))
+        return true;
+
+    return CreateDirectories(GetParentPath(RemoveTrailingSlash(path))) && FileSystem::CreateDirectory(path);
+}
+
+/// Hash the files included by a shader, relative to the directory of the shader as the compiler resolves them.
+static void HashShaderIncludes(Hasher& hasher, const String& directory, const std::vector<uint8_t>& data, std::vector<String>& visited)
+{
+    String text(reinterpret_cast<const char*>(data.data()), static_cast<uint32_t>(data.size()));
+    for (const String& line : text.Split('\n'))
+    {
+        String trimmed = line.Trimmed();
+        if (!trimmed.StartsWith("#include"))
+            continue;
+
+        uint32_t start = trimmed.Find('"');
+        uint32_t end = start != String::NPOS ? trimmed.Find('"', start + 1) : String::NPOS;
+        if (end == String::NPOS)
+        {
+            start = trimmed.Find('<');
+            end = start != String::NPOS ? trimmed.Find('>', start + 1) : String::NPOS;
+        }
+        if (end == String::NPOS)
+            continue;
+
+        String includeFile = Path::Join(directory, trimmed.Substring(start + 1, end - start - 1));
+        if (std::find(visited.begin(), visited.end(), includeFile) != visited.end())
+            continue;
+
+        visited.push_back(includeFile);
+
+        // A missing include is hashed as empty, the compiler reports it.
+        std::vector<uint8_t> includeData;
+        ReadFile(includeFile, includeData);
+        hasher.UInt64(includeData.size());
+        hasher.Data(includeData.data(), includeData.size());
+        HashShaderIncludes(hasher, directory, includeData, visited);
+    }
+}
+
+static bool CookShader(const String& fileName, const std::vector<uint8_t>& data, Stream& dest, uint64_t hash)
+{
+    String sources[static_cast<unsigned>(ShaderStage::Count)];
+    SplitShaderSections(reinterpret_cast<const char*>(data.data()), data.size(), sources);
+
+    CookedShader shader;
+    for (unsigned i = 0; i < static_cast<unsigned>(ShaderStage::Count); i++)
+    {
+        if (sources[i].IsEmpty())
+            continue;
+
+        ShaderCompiler compiler;
+        ShaderBlob blob = compiler.Compile(sources[i].CString(), "main", ShaderLanguage::GLSL, static_cast<ShaderStage>(i), fileName.CString());
+        if (!blob.size)
+        {
+            cerr << compiler.get_error_message() << endl;
+            return false;
+        }
+
+        shader.SetStage(static_cast<ShaderStage>(i), blob);
+        delete[] blob.data;
+    }
+
+    return shader.Save(dest, hash);
+}
+
+/// Parse an image block compression format name, none for uncompressed images.
+static bool ParseCompression(const std::string& name, PixelFormat& format)
+{
+    static const std::pair<const char*, PixelFormat> formats[] = {
+        { "none", PixelFormat::Unknown },
+        { "bc1", PixelFormat::BC1UNorm },
+        { "bc3", PixelFormat::BC3UNorm },
+        { "bc4", PixelFormat::BC4UNorm },
+        { "bc5", PixelFormat::BC5UNorm },
+        { "bc7", PixelFormat::BC7UNorm }
+    };
+
+    for (const auto& entry : formats)
+    {
+        if (name == entry.first)
+        {
+            format = entry.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Parse a block compression quality name.
+static bool ParseQuality(const std::string& name, CompressionQuality& quality)
+{
+    if (name == "fast")
+        quality = CompressionQuality::Fast;
+    else if (name == "normal")
+        quality = CompressionQuality::Normal;
+    else if (name == "high")
+        quality = CompressionQuality::High;
+    else
+        return false;
+
+    return true;
+}
+
+static bool CookImage(const std::vector<uint8_t>& data, Stream& dest, uint64_t hash, bool mipmaps, PixelFormat compression, CompressionQuality quality)
+{
+    Image image;
+    if (!image.Decode(data.data(), data.size()))
+        return false;
+
+    if (mipmaps && !image.GenerateMipmaps())
+        return false;
+
+    if (compression != PixelFormat::Unknown && !image.Compress(compression, quality))
+        return false;
+
+    return image.SaveCooked(dest, hash);
+}
+
+/// Compress an RGBA8 image to every block format and quality, decode it back and print throughput and PSNR. Return false if a format fails to compress or decode, or if alpha decodes wrong: opaque pixels of opaque images must stay opaque, and BC1 must keep the alpha threshold at half.
+static bool CheckCompression(const String& name, const Image& source)
+{
+    static const char* formatNames[] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+    static const char* qualityNames[] = { "fast", "normal", "high" };
+    static const uint32_t formatChannels[] = { 3, 4, 1, 2, 4 };
+
+    const uint32_t width = source.GetWidth();
+    const uint32_t height = source.GetHeight();
+    const uint8_t* sourcePixels = source.Data();
+    bool opaque = true;
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+        opaque &= sourcePixels[i * 4 + 3] == 255;
+
+    cout << "Checking block compression of '" << name.CString() << "' (" << width << "x" << height << (opaque ? ", opaque)" : ")") << endl;
+
+    bool success = true;
+    for (uint32_t f = 0; f < 5; ++f)
+    {
+        PixelFormat format;
+        ParseCompression(formatNames[f], format);
+        for (uint32_t q = 0; q < 3; ++q)
+        {
+            Image image;
+            image.Define(source.GetSize(), PixelFormat::RGBA8UNorm);
+            image.SetData(sourcePixels);
+
+            auto start = std::chrono::steady_clock::now();
+            if (!image.Compress(format, static_cast<CompressionQuality>(q)))
+            {
+                cerr << "  " << formatNames[f] << " " << qualityNames[q] << ": compression failed" << endl;
+                success = false;
+                continue;
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Compare the decoded blocks against the source over the channels the format stores.
+            const uint32_t blockSize = FormatDesc[static_cast<uint32_t>(format)].bytesPerBlock;
+            const uint32_t blocksWide = (width + 3) / 4;
+            const uint8_t* blocks = image.Data();
+            double squaredError = 0.0;
+            uint32_t numSamples = 0;
+            uint32_t numWrongAlpha = 0;
+            bool decoded = true;
+            for (uint32_t blockY = 0; blockY < (height + 3) / 4 && decoded; ++blockY)
+            {
+                for (uint32_t blockX = 0; blockX < blocksWide && decoded; ++blockX)
+                {
+                    uint8_t pixels[16][4];
+                    decoded = DecompressBlock(format, blocks + (static_cast<size_t>(blockY) * blocksWide + blockX) * blockSize, pixels);
+                    for (uint32_t i = 0; i < 16; ++i)
+                    {
+                        const uint32_t x = blockX * 4 + (i & 3);
+                        const uint32_t y = blockY * 4 + (i >> 2);
+                        if (x >= width || y >= height)
+                            continue;
+
+                        const uint8_t* pixel = sourcePixels + (static_cast<size_t>(y) * width + x) * 4;
+                        if (format == PixelFormat::BC1UNorm)
+                        {
+                            // BC1 has 1-bit alpha and drops the color of transparent pixels.
+                            const bool transparent = pixel[3] < 128;
+                            if (pixels[i][3] != (transparent ? 0 : 255))
+                                ++numWrongAlpha;
+                            if (transparent)
+                                continue;
+                        }
+                        else if (opaque && pixels[i][3] != 255)
+                        {
+                            ++numWrongAlpha;
+                        }
+
+                        for (uint32_t c = 0; c < formatChannels[f]; ++c)
+                        {
+                            const double diff = static_cast<double>(pixels[i][c]) - pixel[c];
+                            squaredError += diff * diff;
+                        }
+                        numSamples += formatChannels[f];
+                    }
+                }
+            }
+
+            const double meanError = numSamples ? squaredError / numSamples : 0.0;
+            const double psnr = meanError > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / meanError) : 99.0;
+            const double megapixels = static_cast<double>(width) * height / 1000000.0;
+            cout << "  " << formatNames[f] << " " << qualityNames[q] << ": " << megapixels / std::max(seconds, 1e-9) << " MPix/s, " << psnr << " dB" << endl;
+            if (!decoded)
+            {
+                cerr << "  " << formatNames[f] << " " << qualityNames[q] << ": block does not decode" << endl;
+                success = false;
+            }
+            if (numWrongAlpha)
+            {
+                cerr << "  " << formatNames[f] << " " << qualityNames[q] << ": alpha of " << numWrongAlpha << " pixels decodes wrong" << endl;
+                success = false;
+            }
+        }
+    }
+
+    return success;
+}
+
+/// Define an opaque noise image with dark pixels, which exercise the three color mode of BC1.
+static void CreateCompressionTestImage(Image& image)
+{
+    const uint32_t size = 512;
+    image.Define(uvec2(size, size), PixelFormat::RGBA8UNorm);
+    std::mt19937 random(1);
+    uint8_t* pixels = image.Data();
+    for (uint32_t i = 0; i < size * size; ++i, pixels += 4)
+    {
+        const uint32_t range = (random() & 3) ? 256 : 24;
+        pixels[0] = static_cast<uint8_t>(random() % range);
+        pixels[1] = static_cast<uint8_t>(random() % range);
+        pixels[2] = static_cast<uint8_t>(random() % range);
+        pixels[3] = 255;
+    }
+}
+
+/// Parse a Wavefront OBJ index, which is one-based or negative from the end.
+static bool ParseObjIndex(const String& value, size_t count, uint32_t& index)
+{
+    if (value.IsEmpty())
+        return false;
+
+    long parsed = strtol(value.CString(), nullptr, 10);
+    if (parsed < 0)
+        parsed += static_cast<long>(count) + 1;
+
+    if (parsed < 1 || static_cast<size_t>(parsed) > count)
+        return false;
+
+    index = static_cast<uint32_t>(parsed - 1);
+    return true;
+}
+
+/// Convert a Wavefront OBJ file to an indexed triangle list, sharing vertices with identical attributes.
+static bool CookMesh(const std::vector<uint8_t>& data, Stream& dest, uint64_t hash)
+{
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    std::vector<vec2> texCoords;
+
+    struct ObjVertex
+    {
+        uint32_t position;
+        uint32_t texCoord;
+        uint32_t normal;
+
+        bool operator == (const ObjVertex& rhs) const { return position == rhs.position && texCoord == rhs.texCoord && normal == rhs.normal; }
+    };
+    struct ObjVertexHash
+    {
+        size_t operator () (const ObjVertex& vertex) const
+        {
+            uint64_t hash = vertex.position;
+            hash = hash * 0x9E3779B97F4A7C15ull + vertex.texCoord;
+            hash = hash * 0x9E3779B97F4A7C15ull + vertex.normal;
+            return static_cast<size_t>(hash ^ (hash >> 32));
+        }
+    };
+    std::vector<ObjVertex> faceVertices;
+    bool hasTexCoords = true;
+    bool hasNormals = true;
+
+    String text(reinterpret_cast<const char*>(data.data()), static_cast<uint32_t>(data.size()));
+    for (const String& line : text.Split('\n'))
+    {
+        std::vector<String> tokens = line.Trimmed().Split(' ');
+        if (tokens.empty())
+            continue;
+
+        if (tokens[0] == "v" && tokens.size() >= 4)
+        {
+            positions.push_back(vec3(strtof(tokens[1].CString(), nullptr), strtof(tokens[2].CString(), nullptr), strtof(tokens[3].CString(), nullptr)));
+        }
+        else if (tokens[0] == "vn" && tokens.size() >= 4)
+        {
+            normals.push_back(vec3(strtof(tokens[1].CString(), nullptr), strtof(tokens[2].CString(), nullptr), strtof(tokens[3].CString(), nullptr)));
+        }
+        else if (tokens[0] == "vt" && tokens.size() >= 3)
+        {
+            texCoords.push_back(vec2(strtof(tokens[1].CString(), nullptr), strtof(tokens[2].CString(), nullptr)));
+        }
+        else if (tokens[0] == "f" && tokens.size() >= 4)
+        {
+            std::vector<ObjVertex> polygon;
+            for (size_t i = 1; i < tokens.size(); ++i)
+            {
+                std::vector<String> parts = tokens[i].Split('/', true);
+                ObjVertex vertex = {};
+                if (!ParseObjIndex(parts[0], positions.size(), vertex.position))
+                {
+                    cerr << "Invalid face index '" << tokens[i].CString() << "'" << endl;
+                    return false;
+                }
+
+                hasTexCoords &= parts.size() > 1 && ParseObjIndex(parts[1], texCoords.size(), vertex.texCoord);
+                hasNormals &= parts.size() > 2 && ParseObjIndex(parts[2], normals.size(), vertex.normal);
+                polygon.push_back(vertex);
+            }
+
+            // Triangulate as a fan.
+            for (size_t i = 2; i < polygon.size(); ++i)
+            {
+                faceVertices.push_back(polygon[0]);
+                faceVertices.push_back(polygon[i - 1]);
+                faceVertices.push_back(polygon[i]);
+            }
+        }
+    }
+
+    if (faceVertices.empty())
+    {
+        cerr << "Mesh has no faces" << endl;
+        return false;
+    }
+
+    // Attributes missing from any face are left out of the vertex format.
+    CookedMesh mesh;
+    uint32_t stride = 0;
+    mesh.attributes[ecast(MeshAttribute::Position)] = { VertexFormat::Float3, stride };
+    stride += sizeof(vec3);
+    if (hasNormals)
+    {
+        mesh.attributes[ecast(MeshAttribute::Normal)] = { VertexFormat::Float3, stride };
+        stride += sizeof(vec3);
+    }
+    if (hasTexCoords)
+    {
+        mesh.attributes[ecast(MeshAttribute::UV)] = { VertexFormat::Float2, stride };
+        stride += sizeof(vec2);
+    }
+    mesh.vertexStride = stride;
+
+    std::unordered_map<ObjVertex, uint32_t, ObjVertexHash> vertexIndices;
+    std::vector<uint32_t> indices;
+    indices.reserve(faceVertices.size());
+    for (const ObjVertex& vertex : faceVertices)
+    {
+        const uint32_t texCoord = hasTexCoords ? vertex.texCoord : 0;
+        const uint32_t normal = hasNormals ? vertex.normal : 0;
+        const ObjVertex key = { vertex.position, texCoord, normal };
+
+        auto it = vertexIndices.find(key);
+        if (it != vertexIndices.end())
+        {
+            indices.push_back(it->second);
+            continue;
+        }
+
+        const size_t offset = mesh.vertexData.size();
+        mesh.vertexData.resize(offset + stride);
+        uint8_t* dest = mesh.vertexData.data() + offset;
+        memcpy(dest, &positions[vertex.position], sizeof(vec3));
+        if (hasNormals)
+            memcpy(dest + mesh.attributes[ecast(MeshAttribute::Normal)].offset, &normals[normal], sizeof(vec3));
+        if (hasTexCoords)
+            memcpy(dest + mesh.attributes[ecast(MeshAttribute::UV)].offset, &texCoords[texCoord], sizeof(vec2));
+
+        indices.push_back(mesh.vertexCount);
+        vertexIndices[key] = mesh.vertexCount++;
+    }
+
+    mesh.indexCount = static_cast<uint32_t>(indices.size());
+    mesh.indexStride = mesh.vertexCount <= 0xffff ? sizeof(uint16_t) : sizeof(uint32_t);
+    mesh.indexData.resize(indices.size() * mesh.indexStride);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        if (mesh.indexStride == sizeof(uint16_t))
+            reinterpret_cast<uint16_t*>(mesh.indexData.data())[i] = static_cast<uint16_t>(indices[i]);
+        else
+            reinterpret_cast<uint32_t*>(mesh.indexData.data())[i] = indices[i];
+    }
+
+    return mesh.Save(dest, hash);
+}
+
+static void LoadManifest(const String& fileName, std::unordered_map<String, uint64_t>& manifest)
+{
+    std::vector<uint8_t> data;
+    if (!ReadFile(fileName, data))
+        return;
+
+    String text(reinterpret_cast<const char*>(data.data()), static_cast<uint32_t>(data.size()));
+    for (const String& line : text.Split('\n'))
+    {
+        uint32_t separator = line.Find(' ');
+        if (separator == String::NPOS)
+            continue;
+
+        manifest[line.Substring(separator + 1).Trimmed()] = strtoull(line.Substring(0, separator).CString(), nullptr, 16);
+    }
+}
+
+static bool SaveManifest(const String& fileName, const std::unordered_map<String, uint64_t>& manifest)
+{
+    std::vector<String> names;
+    for (const auto& entry : manifest)
+        names.push_back(entry.first);
+    std::sort(names.begin(), names.end());
+
+    FileStream stream(fileName, FileAccess::WriteOnly);
+    if (!stream.IsOpen())
+        return false;
+
+    for (const String& name : names)
+        stream.WriteLine(String::Format("%016llx %s", static_cast<unsigned long long>(manifest.at(name)), name.CString()));
+
+    return true;
+}
+
+/// Result of cooking one file.
+enum class CookResult
+{
+    Skipped,
+    UpToDate,
+    Cooked,
+    Cached,
+    ReadFailed,
+    Failed
+};
+
+/// Result and content hash of cooking one file.
+struct CookOutcome
+{
+    CookResult result = CookResult::Skipped;
+    uint64_t hash = 0;
+};
+
+/// Settings shared by the files of a cook.
+struct CookSettings
+{
+    String sourceDirectory;
+    String destDirectory;
+    bool force;
+    bool mipmaps;
+    PixelFormat compression;
+    CompressionQuality quality;
+    /// Content hashes of the previous cook.
+    std::unordered_map<String, uint64_t> oldManifest;
+};
+
+/// Cook a file unless its output is up to date. Safe to call from several threads for different files.
+static CookOutcome CookFile(const CookSettings& settings, const String& file)
+{
+    CookOutcome outcome;
+    const String sourceFile = settings.sourceDirectory + file;
+    const String destFile = settings.destDirectory + file;
+    const AssetKind kind = GetAssetKind(FileSystem::GetExtension(file));
+
+    std::vector<uint8_t> data;
+    if (!ReadFile(sourceFile, data))
+    {
+        outcome.result = CookResult::ReadFailed;
+        return outcome;
+    }
+
+    // The content hash covers everything the output depends on.
+    Hasher hasher;
+    hasher.UInt32(COOK_VERSION);
+    hasher.UInt32(static_cast<uint32_t>(kind));
+    hasher.UInt32(kind == AssetKind::Image && settings.mipmaps);
+    if (kind == AssetKind::Image && settings.compression != PixelFormat::Unknown)
+    {
+        hasher.UInt32(static_cast<uint32_t>(settings.compression));
+        hasher.UInt32(static_cast<uint32_t>(settings.quality));
+    }
+    hasher.UInt64(data.size());
+    hasher.Data(data.data(), data.size());
+    if (kind == AssetKind::Shader)
+    {
+        std::vector<String> visited;
+        HashShaderIncludes(hasher, FileSystem::GetPath(sourceFile), data, visited);
+    }
+    const uint64_t hash = hasher.GetValue();
+    outcome.hash = hash;
+
+    auto it = settings.oldManifest.find(file);
+    if (!settings.force && it != settings.oldManifest.end() && it->second == hash && FileSystem::FileExists(destFile))
+    {
+        outcome.result = CookResult::UpToDate;
+        return outcome;
+    }
+
+    bool cached = false;
+    bool success = CreateDirectories(FileSystem::GetPath(destFile));
+    if (success)
+    {
+        FileStream dest(destFile, FileAccess::WriteOnly);
+        success = dest.IsOpen();
+        if (success && kind == AssetKind::Copy)
+        {
+            success = dest.Write(data.data(), data.size()) == data.size();
+        }
+        else if (success)
+        {
+            // The same content cooks the same everywhere, so look it up in the derived data cache first.
+            DerivedDataCache& cache = DerivedDataCache::Get();
+            Hasher keyHasher(hash);
+            keyHasher.String("Cook");
+            const uint64_t cacheKey = keyHasher.GetValue();
+
+            std::vector<uint8_t> cachedData;
+            cached = cache.Get(cacheKey, cachedData);
+            if (cached)
+            {
+                success = dest.Write(cachedData.data(), cachedData.size()) == cachedData.size();
+            }
+            else
+            {
+                PagedMemoryStream cooked;
+                switch (kind)
+                {
+                case AssetKind::Shader:
+                    success = CookShader(sourceFile, data, cooked, hash);
+                    break;
+                case AssetKind::Image:
+                    success = CookImage(data, cooked, hash, settings.mipmaps, settings.compression, settings.quality);
+                    break;
+                default:
+                    success = CookMesh(data, cooked, hash);
+                    break;
+                }
+
+                success = success && cooked.CopyTo(dest) == cooked.GetSize();
+                if (success)
+                    cache.Put(cacheKey, cooked);
+            }
+        }
+    }
+
+    if (!success)
+    {
+        FileSystem::Delete(destFile);
+        outcome.result = CookResult::Failed;
+        return outcome;
+    }
+
+    outcome.result = cached ? CookResult::Cached : CookResult::Cooked;
+    return outcome;
+}
+
+int main(int argc, char* argv[])
+{
+    CLI::App app{ "cook, Alimer asset cooking tool, version 0.9.", "cook" };
+
+    std::string inputDir;
+    std::string outputDir;
+    std::string cacheDir;
+    uint64_t cacheSizeMB = DEFAULT_DERIVED_DATA_CACHE_SIZE / (1024 * 1024);
+    bool force = false;
+    bool noMipmaps = false;
+    std::string compressionName = "none";
+    std::string qualityName = "normal";
+    uint32_t numJobs = 0;
+    bool checkCompression = false;
+
+    app.add_option("input", inputDir, "Source asset directory")->required(true)->check(CLI::ExistingDirectory);
+    app.add_option("-o,--output", outputDir, "Output directory for cooked assets, with the same file names");
+    app.add_flag("-f,--force", force, "Cook all assets even if up to date");
+    app.add_flag("--no-mipmaps", noMipmaps, "Do not generate image mip levels");
+    app.add_option("--compress", compressionName, "Image block compression: none, bc1, bc3, bc4, bc5 or bc7", true);
+    app.add_option("--quality", qualityName, "Image block compression quality: fast, normal or high", true);
+    app.add_option("-j,--jobs", numJobs, "Number of worker threads, 0 to match the hardware threads", true);
+    app.add_flag("--check-compression", checkCompression, "Compress a noise image and the input images to every block format and quality, verify the decoded blocks and report throughput instead of cooking");
+    app.add_option("--cache", cacheDir, "Derived data cache directory shared between cooks and compiles of unchanged content");
+    app.add_option("--cache-size", cacheSizeMB, "Maximum derived data cache size in megabytes", true);
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError &e) {
+        return app.exit(e);
+    }
+
+    PixelFormat compression;
+    CompressionQuality quality;
+    if (!ParseCompression(compressionName, compression) || !ParseQuality(qualityName, quality))
+    {
+        cerr << "Unknown image compression '" << compressionName << "' or quality '" << qualityName << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    Logger logger;
+
+    if (checkCompression)
+    {
+        WorkQueue workQueue;
+        workQueue.CreateThreads(numJobs);
+
+        Image noise;
+        CreateCompressionTestImage(noise);
+        bool success = CheckCompression("noise", noise);
+
+        std::vector<String> files;
+        const String sourceDirectory = AddTrailingSlash(String(inputDir.c_str()));
+        ScanDirectory(files, sourceDirectory, "*", ScanDirFlags::Files, true);
+        std::sort(files.begin(), files.end());
+        for (const String& file : files)
+        {
+            if (GetAssetKind(FileSystem::GetExtension(file)) != AssetKind::Image)
+                continue;
+
+            std::vector<uint8_t> data;
+            Image image;
+            if (!ReadFile(sourceDirectory + file, data) || !image.Decode(data.data(), data.size()))
+            {
+                cerr << "Could not decode '" << (sourceDirectory + file).CString() << "'" << endl;
+                success = false;
+                continue;
+            }
+
+            success &= CheckCompression(file, image);
+        }
+
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (outputDir.empty())
+    {
+        cerr << "--output is required" << endl;
+        return EXIT_FAILURE;
+    }
+
+    String sourceDirectory = AddTrailingSlash(String(inputDir.c_str()));
+    String destDirectory = AddTrailingSlash(String(outputDir.c_str()));
+    if (!CreateDirectories(destDirectory))
+    {
+        cerr << "Could not create output directory '" << outputDir << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    DerivedDataCache& cache = DerivedDataCache::Get();
+    if (!cacheDir.empty() && !cache.SetDirectory(String(cacheDir.c_str()), cacheSizeMB * 1024 * 1024))
+    {
+        cerr << "Could not create cache directory '" << cacheDir << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<String> files;
+    ScanDirectory(files, sourceDirectory, "*", ScanDirFlags::Files, true);
+    std::sort(files.begin(), files.end());
+
+    CookSettings settings;
+    settings.sourceDirectory = sourceDirectory;
+    settings.destDirectory = destDirectory;
+    settings.force = force;
+    settings.mipmaps = !noMipmaps;
+    settings.compression = compression;
+    settings.quality = quality;
+
+    const String manifestFileName = destDirectory + MANIFEST_FILE_NAME;
+    LoadManifest(manifestFileName, settings.oldManifest);
+
+    // Files cook in parallel, except shaders which go through the shader compiler one at a time.
+    std::vector<String> cookFiles;
+    std::vector<String> shaderFiles;
+    for (const String& file : files)
+    {
+        if (file == MANIFEST_FILE_NAME)
+            continue;
+
+        if (GetAssetKind(FileSystem::GetExtension(file)) == AssetKind::Shader)
+            shaderFiles.push_back(file);
+        else
+            cookFiles.push_back(file);
+    }
+
+    std::vector<CookOutcome> outcomes(files.size());
+    auto cookFile = [&](const String& file) {
+        const size_t index = std::lower_bound(files.begin(), files.end(), file) - files.begin();
+        outcomes[index] = CookFile(settings, file);
+    };
+
+    WorkQueue workQueue;
+    workQueue.CreateThreads(numJobs);
+    workQueue.ParallelFor(static_cast<uint32_t>(cookFiles.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i)
+            cookFile(cookFiles[i]);
+    });
+    for (const String& file : shaderFiles)
+        cookFile(file);
+
+    std::unordered_map<String, uint64_t> manifest;
+    uint32_t numCooked = 0;
+    uint32_t numUpToDate = 0;
+    uint32_t numCached = 0;
+    uint32_t numFailed = 0;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        const String& file = files[i];
+        const CookOutcome& outcome = outcomes[i];
+        switch (outcome.result)
+        {
+        case CookResult::Skipped:
+            continue;
+        case CookResult::ReadFailed:
+            cerr << "Could not read '" << (sourceDirectory + file).CString() << "'" << endl;
+            ++numFailed;
+            continue;
+        case CookResult::Failed:
+            cerr << "Failed to cook '" << (sourceDirectory + file).CString() << "'" << endl;
+            ++numFailed;
+            continue;
+        case CookResult::UpToDate:
+            ++numUpToDate;
+            break;
+        case CookResult::Cached:
+            ++numCached;
+            cout << "Cooked '" << file.CString() << "' from cache" << endl;
+            break;
+        case CookResult::Cooked:
+            ++numCooked;
+            cout << "Cooked '" << file.CString() << "'" << endl;
+            break;
+        }
+
+        manifest[file] = outcome.hash;
+    }
+
+    // Remove outputs of sources that no longer exist.
+    for (const auto& entry : settings.oldManifest)
+    {
+        if (!std::binary_search(files.begin(), files.end(), entry.first))
+            FileSystem::Delete(destDirectory + entry.first);
+    }
+
+    if (!SaveManifest(manifestFileName, manifest))
+    {
+        cerr << "Failed to write '" << manifestFileName.CString() << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "Cooked " << numCooked << " files, " << numCached << " from cache, " << numUpToDate << " up to date, " << numFailed << " failed" << endl;
+    return numFailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
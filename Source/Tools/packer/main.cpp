@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2018 Amer Koleci and contributors.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4458) 
+#endif
+
+#include "CLI11.hpp"
+#include "Alimer/Core/Log.h"
+#include "Alimer/IO/FileSystem.h"
+#include "Alimer/Resource/PackageFile.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace Alimer;
+using namespace std;
+
+/// Page alignment for entries which are used directly from the memory mapped package.
+static constexpr uint32_t PAGE_ALIGNMENT = 4096;
+
+int main(int argc, char* argv[])
+{
+    CLI::App app{ "packer, Alimer resource package tool, version 0.9.", "packer" };
+
+    std::string inputDir;
+    std::string outputFile;
+    bool compress = false;
+    bool highCompression = false;
+    uint32_t alignment = PACKAGE_DEFAULT_ALIGNMENT;
+    std::vector<std::string> pageAlignExtensions;
+
+    app.add_option("input", inputDir, "Resource directory to package")->required(true)->check(CLI::ExistingDirectory);
+    app.add_option("-o,--output", outputFile, "Output package file")->required(true);
+    app.add_flag("-c,--compress", compress, "Compress entries with LZ4");
+    app.add_flag("--hc", highCompression, "Use LZ4 high compression, slower to pack with same decompression speed");
+    app.add_option("-a,--alignment", alignment, "Default entry alignment, power of two", true);
+    app.add_option("-p,--page-align", pageAlignExtensions, "Extensions of files stored uncompressed and page aligned for direct mapping, e.g. dds");
+
+    try {
+        app.parse(argc, argv);
+    }
+    catch (const CLI::ParseError &e) {
+        return app.exit(e);
+    }
+
+    if (!alignment || (alignment & (alignment - 1)))
+    {
+        cerr << "Alignment must be a power of two" << endl;
+        return EXIT_FAILURE;
+    }
+
+    Logger logger;
+
+    String directory = AddTrailingSlash(String(inputDir.c_str()));
+    std::vector<String> files;
+    ScanDirectory(files, directory, "*", ScanDirFlags::Files, true);
+    std::sort(files.begin(), files.end());
+
+    PackageBuilder builder;
+    builder.SetDefaultAlignment(alignment);
+    builder.SetCompressionLevel(highCompression ? CompressionLevel::High : CompressionLevel::Fast);
+    for (const String& file : files)
+    {
+        String extension = FileSystem::GetExtension(file);
+        bool pageAligned = false;
+        for (const std::string& pageAlignExtension : pageAlignExtensions)
+        {
+            String compareExtension = String(pageAlignExtension.c_str()).ToLower();
+            if (!compareExtension.StartsWith("."))
+                compareExtension = "." + compareExtension;
+            pageAligned |= extension == compareExtension;
+        }
+
+        builder.AddFile(file, directory + file, compress && !pageAligned, pageAligned ? PAGE_ALIGNMENT : 0);
+    }
+
+    if (!builder.Save(String(outputFile.c_str())))
+    {
+        cerr << "Failed to write package '" << outputFile << "'" << endl;
+        return EXIT_FAILURE;
+    }
+
+    cout << "Packaged " << builder.GetNumEntries() << " files into '" << outputFile << "'" << endl;
+    return EXIT_SUCCESS;
+}
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif